@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+
+/**
+ * 广播压测: 同一条消息发给所有连接, 每轮等所有客户端收齐后再发下一轮
+ * 对比逐连接send(每个连接拷贝一份, 每个连接一个functor)和TcpServer::broadcast(共享一份, 每个loop一个任务)
+ * 输出每轮扇出耗时、每轮服务端执行的functor数、进程CPU时间和发送期间的堆内存峰值
+ * 用法: broadcast_bench [连接数] [服务端subloop数] [消息字节数] [轮数]
+**/
+
+static const uint16_t kPort = 9967;
+
+static double cpuSeconds() {
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    int numConnections = argc > 1 ? atoi(argv[1]) : 1000;
+    int serverThreads = argc > 2 ? atoi(argv[2]) : 2;
+    size_t payloadSize = static_cast<size_t>(argc > 3 ? atoi(argv[3]) : 16384);
+    int rounds = argc > 4 ? atoi(argv[4]) : 50;
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoopThread serverThread;
+    EventLoop *serverLoop = serverThread.startLoop();
+    std::mutex mutex;
+    std::vector<TcpConnectionPtr> serverConns;
+    TcpServer server(serverLoop, InetAddress(kPort), "BroadcastServer");
+    server.setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            serverConns.push_back(conn);
+        }
+    });
+    server.setThreadNum(serverThreads);
+    std::promise<void> listening; // 开始监听后客户端再发起连接
+    serverLoop->runInLoop([&]() {
+        server.start();
+        listening.set_value();
+    });
+    listening.get_future().wait();
+
+    // 客户端只统计收到的字节数
+    EventLoopThread clientThread;
+    EventLoop *clientLoop = clientThread.startLoop();
+    std::atomic<uint64_t> received(0);
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < numConnections; ++i) {
+        clients.emplace_back(new TcpClient(clientLoop, InetAddress(kPort), "BroadcastClient"));
+        clients.back()->setMessageCallback([&received](const TcpConnectionPtr &, Buffer *buf, Timestamp) {
+            received.fetch_add(buf->readableBytes(), std::memory_order_relaxed);
+            buf->retrieveAll();
+        });
+        clients.back()->connect();
+    }
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (static_cast<int>(serverConns.size()) == numConnections) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    const uint64_t bytesPerRound = static_cast<uint64_t>(numConnections) * payloadSize;
+    for (bool shared : {false, true}) {
+        LoopStats before;
+        for (const LoopStats &stats : server.loopStats()) before += stats;
+        size_t heapBase = mallinfo2().uordblks;
+        size_t heapPeak = heapBase;
+        double cpuStart = cpuSeconds();
+        uint64_t expected = received.load();
+        bool complete = true;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds && complete; ++r) {
+            SharedPayload payload = std::make_shared<const std::string>(payloadSize, static_cast<char>('a' + r % 26));
+            if (shared) {
+                server.broadcast(payload);
+            } else {
+                for (const TcpConnectionPtr &conn : serverConns) {
+                    conn->send(*payload);
+                }
+            }
+            expected += bytesPerRound;
+            auto roundStart = std::chrono::steady_clock::now();
+            while (received.load(std::memory_order_relaxed) < expected) {
+                heapPeak = std::max(heapPeak, mallinfo2().uordblks);
+                if (std::chrono::steady_clock::now() - roundStart > std::chrono::seconds(10)) {
+                    complete = false;
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double cpu = cpuSeconds() - cpuStart;
+
+        LoopStats after;
+        for (const LoopStats &stats : server.loopStats()) after += stats;
+        printf("bench=broadcast impl=%s connections=%d server_threads=%d payload=%zu rounds=%d complete=%d "
+               "ms_per_round=%.2f MBps=%.0f functors_per_round=%.1f cpu_s=%.3f heap_peak_kb=%.0f\n",
+               shared ? "broadcast" : "send", numConnections, serverThreads, payloadSize, rounds, complete,
+               seconds * 1000 / rounds, static_cast<double>(bytesPerRound) * rounds / seconds / 1e6,
+               static_cast<double>(after.functors - before.functors) / rounds, cpu,
+               (heapPeak - heapBase) / 1024.0);
+        fflush(stdout);
+    }
+
+    // 客户端在自己的loop中析构, 等析构完成再退出
+    std::promise<void> closed;
+    clientLoop->runInLoop([&]() {
+        clients.clear();
+        closed.set_value();
+    });
+    closed.get_future().wait();
+    serverConns.clear();
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+
+#include "LengthHeaderCodec.h"
+#include "Buffer.h"
+
+/**
+ * 对比长度前缀分帧的两种实现
+ * decode: 逐帧retrieveAsString拷贝出std::string vs LengthHeaderCodec在缓冲区上直接解析
+ * encode: 拼接头和消息体的std::string后再写入输出缓冲区 vs 消息体直接写入Buffer后prepend长度头
+ * 用法: codec_bench [每轮帧数] [轮数]
+**/
+
+using Clock = std::chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point start) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+static void report(const char *name, size_t frameSize, size_t frames, double ns) {
+    printf("bench=%s frame_size=%zu ns_per_frame=%.1f MB_per_s=%.1f\n",
+           name, frameSize, ns / frames, frames * frameSize * 1e3 / ns);
+}
+
+static void benchDecode(size_t frameSize, int framesPerRound, int rounds) {
+    // 准备一轮的原始数据
+    Buffer wire;
+    std::string body(frameSize, 'x');
+    for (int i = 0; i < framesPerRound; ++i) {
+        wire.appendInt32(static_cast<int32_t>(frameSize));
+        wire.append(body.data(), body.size());
+    }
+    std::string raw(wire.peek(), wire.readableBytes());
+    size_t sink = 0;
+
+    Buffer input;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        input.append(raw.data(), raw.size());
+        while (input.readableBytes() >= LengthHeaderCodec::kHeaderLen) {
+            size_t len = static_cast<size_t>(input.peekInt32());
+            if (input.readableBytes() < LengthHeaderCodec::kHeaderLen + len) break;
+            input.retrieve(LengthHeaderCodec::kHeaderLen);
+            std::string message = input.retrieveAsString(len);
+            sink += message.size();
+        }
+    }
+    report("decode_string", frameSize, static_cast<size_t>(framesPerRound) * rounds, elapsedNs(start));
+
+    LengthHeaderCodec codec([&sink](const TcpConnectionPtr &, std::string_view frame, Timestamp) {
+        sink += frame.size();
+    });
+    start = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        input.append(raw.data(), raw.size());
+        codec.onMessage(TcpConnectionPtr(), &input, Timestamp());
+    }
+    report("decode_view", frameSize, static_cast<size_t>(framesPerRound) * rounds, elapsedNs(start));
+
+    if (sink == 0) printf("unexpected sink\n");
+}
+
+static void benchEncode(size_t frameSize, int framesPerRound, int rounds) {
+    std::string payload(frameSize, 'y');
+    Buffer output;
+    size_t frames = static_cast<size_t>(framesPerRound) * rounds;
+
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < framesPerRound; ++i) {
+            std::string body(payload); // 应用构造消息体
+            std::string frame(LengthHeaderCodec::kHeaderLen, '\0');
+            uint32_t be = htonl(static_cast<uint32_t>(body.size()));
+            ::memcpy(&frame[0], &be, sizeof be);
+            frame += body;
+            output.append(frame.data(), frame.size());
+        }
+        output.retrieveAll();
+    }
+    report("encode_string", frameSize, frames, elapsedNs(start));
+
+    start = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (int i = 0; i < framesPerRound; ++i) {
+            Buffer body(frameSize); // 应用直接在Buffer中构造消息体
+            body.append(payload.data(), payload.size());
+            body.prependInt32(static_cast<int32_t>(body.readableBytes()));
+            output.append(body.peek(), body.readableBytes());
+        }
+        output.retrieveAll();
+    }
+    report("encode_prepend", frameSize, frames, elapsedNs(start));
+}
+
+int main(int argc, char *argv[]) {
+    int framesPerRound = argc > 1 ? atoi(argv[1]) : 1000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 200;
+
+    const size_t sizes[] = { 16, 256, 4096, 65536 };
+    for (size_t frameSize : sizes) {
+        benchDecode(frameSize, framesPerRound, rounds);
+        benchEncode(frameSize, framesPerRound, rounds);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "Logger.h"
+
+/**
+ * 统计服务端每接受/关闭一个连接产生的堆内存分配次数
+ * 用法: conn_alloc_bench [连接数] [轮数] [subloop数] [端口]
+ * 客户端只使用系统调用, 不产生堆分配, 计数全部来自服务端
+**/
+
+static std::atomic<uint64_t> g_allocs(0);
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void *p = ::malloc(size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { ::free(p); }
+void operator delete(void *p, size_t) noexcept { ::free(p); }
+
+static std::atomic<int> g_established(0);
+static std::atomic<int> g_closed(0);
+
+static void waitFor(const std::atomic<int> &counter, int target) {
+    while (counter.load() < target) {
+        ::usleep(1000);
+    }
+}
+
+static void runClient(EventLoop *loop, const InetAddress &addr, int numConns, int rounds) {
+    std::vector<int> fds(numConns, -1);
+    for (int r = 0; r < rounds; ++r) {
+        uint64_t before = g_allocs.load();
+        for (int i = 0; i < numConns; ++i) {
+            fds[i] = ::socket(addr.family(), SOCK_STREAM, 0);
+            if (::connect(fds[i], addr.getSockAddr(), addr.getSockLen()) < 0) {
+                perror("connect");
+                exit(1);
+            }
+        }
+        waitFor(g_established, (r + 1) * numConns);
+        uint64_t accepted = g_allocs.load();
+
+        for (int i = 0; i < numConns; ++i) {
+            ::close(fds[i]);
+        }
+        waitFor(g_closed, (r + 1) * numConns);
+        uint64_t closed = g_allocs.load();
+
+        printf("round=%d connections=%d allocs_per_accept=%.2f allocs_per_close=%.2f\n",
+               r, numConns,
+               static_cast<double>(accepted - before) / numConns,
+               static_cast<double>(closed - accepted) / numConns);
+    }
+    loop->quit();
+}
+
+int main(int argc, char *argv[]) {
+    int numConns = argc > 1 ? atoi(argv[1]) : 1000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    int numThreads = argc > 3 ? atoi(argv[3]) : 2;
+    uint16_t port = static_cast<uint16_t>(argc > 4 ? atoi(argv[4]) : 9981);
+
+    Logger::setInfoEnabled(false);
+
+    EventLoop loop;
+    InetAddress addr(port);
+    TcpServer server(&loop, addr, "AllocBench");
+    server.setThreadNum(numThreads);
+    server.setConnectionCallback([](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            ++g_established;
+        } else {
+            ++g_closed;
+        }
+    });
+    server.start();
+
+    std::thread client(runClient, &loop, addr, numConns, rounds);
+    loop.loop();
+    client.join();
+
+    BlockPool::Stats stats = server.connectionPoolStats();
+    printf("pool_allocated=%lu pool_reused=%lu pool_free=%zu\n",
+           static_cast<unsigned long>(stats.allocated),
+           static_cast<unsigned long>(stats.reused),
+           stats.freeBlocks);
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+/**
+ * 自动合并发送压测: 客户端每批流水线发送depth个请求行, 服务端对每个请求单独调用一次send回复
+ * 分别在关闭和开启TcpServer::setAutoCork时运行, 对比吞吐和服务端每个回复的写系统调用次数
+ * 用法: cork_bench [连接数] [流水线深度] [秒数] [服务端subloop数]
+**/
+
+static const uint16_t kPort = 9965;
+
+static void onRequest(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    static const std::string kReply = "+OK\r\n";
+    for (;;) {
+        const char *end = buf->peek() + buf->readableBytes();
+        const char *eol = std::find(buf->peek(), end, '\n');
+        if (eol == end) {
+            break;
+        }
+        buf->retrieve(eol + 1 - buf->peek());
+        conn->send(kReply); // 逐条回复
+    }
+}
+
+// 客户端: 每个连接收齐一批回复后再发下一批
+static uint64_t runClients(int numConnections, int depth, int seconds) {
+    EventLoop loop;
+    std::string batch;
+    for (int i = 0; i < depth; ++i) {
+        batch += "PING\r\n";
+    }
+    std::vector<int> pending(numConnections, 0); // 每个连接本批还未收到的回复数
+    uint64_t replies = 0;
+    bool stopped = false;
+    int connected = 0;
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < numConnections; ++i) {
+        int *remaining = &pending[i];
+        clients.emplace_back(new TcpClient(&loop, InetAddress(kPort), "CorkBenchClient"));
+        clients.back()->setConnectionCallback([&, remaining](const TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                ++connected;
+                conn->setTcpNoDelay(true);
+                *remaining = depth;
+                conn->send(batch);
+            } else if (--connected == 0 && stopped) {
+                loop.quit();
+            }
+        });
+        clients.back()->setMessageCallback([&, remaining](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+            int n = static_cast<int>(std::count(buf->peek(), buf->peek() + buf->readableBytes(), '\n'));
+            buf->retrieveAll();
+            if (stopped) {
+                return;
+            }
+            replies += n;
+            *remaining -= n;
+            if (*remaining == 0) {
+                *remaining = depth;
+                conn->send(batch);
+            }
+        });
+        clients.back()->connect();
+    }
+    loop.runAfter(seconds, [&]() {
+        stopped = true;
+        if (connected == 0) {
+            loop.quit();
+            return;
+        }
+        for (auto &client : clients) {
+            client->disconnect();
+        }
+    });
+    loop.loop();
+    return replies;
+}
+
+static LoopStats totalStats(const TcpServer &server) {
+    LoopStats total;
+    for (const LoopStats &stats : server.loopStats()) {
+        total += stats;
+    }
+    return total;
+}
+
+int main(int argc, char *argv[]) {
+    int numConnections = argc > 1 ? atoi(argv[1]) : 16;
+    int depth = argc > 2 ? atoi(argv[2]) : 16;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    int serverThreads = argc > 4 ? atoi(argv[4]) : 1;
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    for (bool cork : {false, true}) {
+        EventLoop loop;
+        TcpServer server(&loop, InetAddress(kPort), "CorkBenchServer", TcpServer::kReusePort);
+        server.setConnectionCallback([](const TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                conn->setTcpNoDelay(true); // 否则逐条发送的小包受Nagle算法和延迟确认影响
+            }
+        });
+        server.setMessageCallback(onRequest);
+        server.setThreadNum(serverThreads);
+        server.setAutoCork(cork);
+        server.start();
+
+        uint64_t replies = 0;
+        std::thread driver([&]() {
+            replies = runClients(numConnections, depth, seconds);
+            loop.quit();
+        });
+        loop.loop();
+        driver.join();
+
+        LoopStats stats = totalStats(server);
+        printf("bench=cork auto_cork=%d connections=%d depth=%d server_threads=%d seconds=%d replies=%lu "
+               "req_per_s=%.0f server_write_calls=%lu writes_per_reply=%.3f\n",
+               cork, numConnections, depth, serverThreads, seconds, static_cast<unsigned long>(replies),
+               static_cast<double>(replies) / seconds, static_cast<unsigned long>(stats.writeCalls),
+               replies ? static_cast<double>(stats.writeCalls) / replies : 0.0);
+        fflush(stdout);
+    }
+    return 0;
+}
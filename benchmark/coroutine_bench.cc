@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "CoConnection.h"
+#include "Coroutine.h"
+#include "Logger.h"
+
+/**
+ * 协程接口压测
+ * 1. 两步协议"SET <len>\r\n" + len字节数据, 回复"+OK\r\n": 分别用回调状态机和协程(readUntil + read)实现服务端, 对比吞吐
+ * 2. co_await一个立即返回的Task的开销, 以及协程帧的复用情况
+ * 用法: coroutine_bench [连接数] [每连接在途请求数] [数据字节数] [秒数]
+**/
+
+static const uint16_t kCallbackPort = 9963;
+static const uint16_t kCoroutinePort = 9964;
+
+// 回调实现: 每个连接在context中保存解析状态
+struct ParseState {
+    size_t bodyLength = 0;
+    bool inBody = false;
+};
+
+static void onCallbackConnection(const TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+        conn->setTcpNoDelay(true);
+        conn->setContext(ParseState());
+    }
+}
+
+static void onCallbackMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    ParseState *state = std::any_cast<ParseState>(conn->getMutableContext());
+    for (;;) {
+        if (!state->inBody) {
+            const char *crlf = static_cast<const char *>(::memmem(buf->peek(), buf->readableBytes(), "\r\n", 2));
+            if (crlf == nullptr) {
+                return;
+            }
+            state->bodyLength = static_cast<size_t>(atol(buf->peek() + 4));
+            state->inBody = true;
+            buf->retrieve(crlf + 2 - buf->peek());
+        }
+        if (buf->readableBytes() < state->bodyLength) {
+            return;
+        }
+        buf->retrieve(state->bodyLength);
+        state->inBody = false;
+        conn->outputBuffer()->append("+OK\r\n", 5);
+        conn->flushOutput();
+    }
+}
+
+// 协程实现: 同样的协议写成顺序代码
+static Task<> coroutineSession(CoConnection conn) {
+    conn.connection()->setTcpNoDelay(true);
+    for (;;) {
+        std::string header = co_await conn.readUntil("\r\n");
+        if (header.empty()) {
+            break;
+        }
+        std::string body = co_await conn.read(static_cast<size_t>(atol(header.c_str() + 4)));
+        if (!co_await conn.write("+OK\r\n")) {
+            break;
+        }
+    }
+}
+
+// 客户端: 每个连接保持depth个请求在途, 收到一个回复就补发一个
+static uint64_t runClients(uint16_t port, int numConnections, int depth, size_t bodySize, int seconds) {
+    EventLoop loop;
+    std::string request = "SET " + std::to_string(bodySize) + "\r\n" + std::string(bodySize, 'x');
+    std::string burst;
+    for (int i = 0; i < depth; ++i) {
+        burst += request;
+    }
+    uint64_t replies = 0;
+    bool stopped = false;
+    int connected = 0;
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < numConnections; ++i) {
+        clients.emplace_back(new TcpClient(&loop, InetAddress(port), "CoroutineBenchClient"));
+        clients.back()->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                ++connected;
+                conn->setTcpNoDelay(true);
+                conn->send(burst);
+            } else if (--connected == 0 && stopped) {
+                loop.quit();
+            }
+        });
+        clients.back()->setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+            size_t n = std::count(buf->peek(), buf->peek() + buf->readableBytes(), '\n');
+            buf->retrieveAll();
+            if (stopped) {
+                return;
+            }
+            replies += n;
+            for (size_t i = 0; i < n; ++i) {
+                conn->outputBuffer()->append(request.data(), request.size());
+            }
+            conn->flushOutput();
+        });
+        clients.back()->connect();
+    }
+    loop.runAfter(seconds, [&]() {
+        stopped = true;
+        if (connected == 0) {
+            loop.quit();
+            return;
+        }
+        for (auto &client : clients) {
+            client->disconnect();
+        }
+    });
+    loop.loop();
+    return replies;
+}
+
+static Task<int> immediate(int value) {
+    co_return value;
+}
+
+static Task<> awaitLoop(int iterations, long *sum) {
+    for (int i = 0; i < iterations; ++i) {
+        *sum += co_await immediate(i);
+    }
+}
+
+static void benchTaskOverhead() {
+    const int kIterations = 5000000;
+    BlockPool::Stats before = CoroutineFrameAllocator::stats();
+    long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    coSpawn(awaitLoop(kIterations, &sum));
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    BlockPool::Stats after = CoroutineFrameAllocator::stats();
+    printf("bench=coroutine_task iterations=%d ns_per_await=%.1f frames_allocated=%lu frames_reused=%lu checksum=%ld\n",
+           kIterations, ns / kIterations, static_cast<unsigned long>(after.allocated - before.allocated),
+           static_cast<unsigned long>(after.reused - before.reused), sum);
+}
+
+int main(int argc, char *argv[]) {
+    int numConnections = argc > 1 ? atoi(argv[1]) : 16;
+    int depth = argc > 2 ? atoi(argv[2]) : 4;
+    size_t bodySize = static_cast<size_t>(argc > 3 ? atoi(argv[3]) : 128);
+    int seconds = argc > 4 ? atoi(argv[4]) : 3;
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    benchTaskOverhead();
+
+    EventLoop loop;
+    TcpServer callbackServer(&loop, InetAddress(kCallbackPort), "CallbackServer");
+    callbackServer.setConnectionCallback(onCallbackConnection);
+    callbackServer.setMessageCallback(onCallbackMessage);
+    callbackServer.setThreadNum(1);
+    callbackServer.start();
+
+    TcpServer coroutineServer(&loop, InetAddress(kCoroutinePort), "CoroutineServer");
+    coroutineServer.setConnectionCallback(CoConnection::connectionCallback(coroutineSession));
+    coroutineServer.setThreadNum(1);
+    coroutineServer.start();
+
+    std::thread driver([&]() {
+        struct Case { const char *name; uint16_t port; } cases[] = {
+            {"callback", kCallbackPort}, {"coroutine", kCoroutinePort}};
+        for (const Case &c : cases) {
+            BlockPool::Stats before = CoroutineFrameAllocator::stats();
+            uint64_t replies = runClients(c.port, numConnections, depth, bodySize, seconds);
+            BlockPool::Stats after = CoroutineFrameAllocator::stats();
+            printf("bench=coroutine_server impl=%s connections=%d depth=%d body_size=%zu seconds=%d "
+                   "requests=%lu req_per_s=%.0f frames_allocated=%lu frames_reused=%lu\n",
+                   c.name, numConnections, depth, bodySize, seconds, static_cast<unsigned long>(replies),
+                   static_cast<double>(replies) / seconds,
+                   static_cast<unsigned long>(after.allocated - before.allocated),
+                   static_cast<unsigned long>(after.reused - before.reused));
+            fflush(stdout);
+        }
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+    return 0;
+}
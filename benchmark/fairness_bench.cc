@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "LengthHeaderCodec.h"
+#include "Logger.h"
+
+/**
+ * 读配额公平性压测: 服务端只有一个loop, 若干大流量连接持续上传大帧(服务端逐字节计算校验和, 不回复),
+ * 同一loop上的小请求连接做小帧ping-pong, 统计小请求的往返延迟
+ * 先不设配额运行一次, 再用给定的读配额和帧配额运行一次, 对比小请求的p50/p99和上传吞吐
+ * 用法: fairness_bench [上传连接数] [小请求连接数] [秒数] [读配额字节数] [每轮帧配额]
+**/
+
+static const uint16_t kPort = 9968;
+static const size_t kBulkFrameSize = 16 * 1024;
+static const size_t kSmallFrameSize = 16;
+
+struct Result {
+    std::vector<int64_t> rtts; // 小请求往返延迟, 纳秒
+    uint64_t bulkBytes = 0; // 服务端处理的上传字节数
+    LoopStats stats;
+    LoopLatencyStats latency;
+};
+
+static Result runOnce(int bulkConns, int smallConns, int seconds, size_t readBudget, int frameBudget) {
+    Result result;
+    std::atomic<bool> stopped(false);
+    std::atomic<uint64_t> bulkBytes(0);
+    uint32_t checksum = 0;
+    const std::string request(kSmallFrameSize, 's');
+    // 编解码器不保存连接状态, 所有连接共用; 先于loop线程构造, 保证比所有连接活得久
+    LengthHeaderCodec serverCodec([&](const TcpConnectionPtr &conn, std::string_view frame, Timestamp) {
+        if (frame.size() == kSmallFrameSize) {
+            Buffer reply;
+            reply.append(frame.data(), frame.size());
+            serverCodec.send(conn, &reply); // 小请求原样回复
+            return;
+        }
+        for (char c : frame) { // 模拟解析大帧的开销
+            checksum = (checksum ^ static_cast<unsigned char>(c)) * 16777619u;
+        }
+        bulkBytes.fetch_add(frame.size(), std::memory_order_relaxed);
+    });
+    serverCodec.setFrameBudget(frameBudget);
+    // 小请求连接: 收到回复后立即发下一个请求, 发送时间保存在连接上下文中
+    LengthHeaderCodec smallCodec([&](const TcpConnectionPtr &conn, std::string_view, Timestamp) {
+        int64_t now = LatencyHistogram::now();
+        result.rtts.push_back(now - std::any_cast<int64_t>(conn->getContext()));
+        if (!stopped.load(std::memory_order_relaxed)) {
+            conn->setContext(now);
+            smallCodec.send(conn, request);
+        }
+    });
+
+    EventLoopThread serverThread;
+    EventLoop *serverLoop = serverThread.startLoop();
+    TcpServer server(serverLoop, InetAddress(kPort), "FairnessServer", TcpServer::kReusePort);
+    server.setConnectionCallback([](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            conn->setTcpNoDelay(true);
+        }
+    });
+    server.setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp t) {
+        serverCodec.onMessage(conn, buf, t);
+    });
+    server.setReadBudget(readBudget);
+    std::promise<void> listening; // 开始监听后客户端再发起连接
+    serverLoop->runInLoop([&]() {
+        server.start();
+        listening.set_value();
+    });
+    listening.get_future().wait();
+
+    // 上传连接: 发送缓冲区写完就补发一批大帧
+    std::string bulkBatch;
+    {
+        const std::string body(kBulkFrameSize, 'b');
+        Buffer frame;
+        frame.append(body.data(), body.size());
+        frame.prependInt32(static_cast<int32_t>(kBulkFrameSize));
+        for (int i = 0; i < 16; ++i) {
+            bulkBatch.append(frame.peek(), frame.readableBytes());
+        }
+    }
+    EventLoopThread bulkThread;
+    EventLoop *bulkLoop = bulkThread.startLoop();
+    std::vector<std::unique_ptr<TcpClient>> bulkClients;
+    for (int i = 0; i < bulkConns; ++i) {
+        bulkClients.emplace_back(new TcpClient(bulkLoop, InetAddress(kPort), "BulkClient"));
+        bulkClients.back()->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                conn->send(bulkBatch);
+            }
+        });
+        bulkClients.back()->setWriteCompleteCallback([&](const TcpConnectionPtr &conn) {
+            if (!stopped.load(std::memory_order_relaxed)) {
+                conn->send(bulkBatch);
+            }
+        });
+        bulkClients.back()->connect();
+    }
+
+    EventLoopThread smallThread;
+    EventLoop *smallLoop = smallThread.startLoop();
+    std::vector<std::unique_ptr<TcpClient>> smallClients;
+    for (int i = 0; i < smallConns; ++i) {
+        smallClients.emplace_back(new TcpClient(smallLoop, InetAddress(kPort), "SmallClient"));
+        smallClients.back()->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                conn->setTcpNoDelay(true);
+                conn->setContext(LatencyHistogram::now());
+                smallCodec.send(conn, request);
+            }
+        });
+        smallClients.back()->setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp t) {
+            smallCodec.onMessage(conn, buf, t);
+        });
+        smallClients.back()->connect();
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stopped = true;
+    result.bulkBytes = bulkBytes.load();
+    for (const LoopStats &stats : server.loopStats()) result.stats += stats;
+    for (const LoopLatencyStats &stats : server.loopLatencyStats()) result.latency += stats;
+
+    // 客户端在各自的loop中析构, 等析构完成再停止loop
+    std::pair<EventLoop *, std::vector<std::unique_ptr<TcpClient>> *> clientGroups[] = {
+        {bulkLoop, &bulkClients}, {smallLoop, &smallClients}};
+    for (auto &group : clientGroups) {
+        std::promise<void> closed;
+        group.first->runInLoop([&]() {
+            group.second->clear();
+            closed.set_value();
+        });
+        closed.get_future().wait();
+    }
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    int bulkConns = argc > 1 ? atoi(argv[1]) : 8;
+    int smallConns = argc > 2 ? atoi(argv[2]) : 32;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    size_t readBudget = static_cast<size_t>(argc > 4 ? atoi(argv[4]) : 16384);
+    int frameBudget = argc > 5 ? atoi(argv[5]) : 1;
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    struct Case { size_t readBudget; int frameBudget; } cases[] = {{0, 0}, {readBudget, frameBudget}};
+    for (const Case &c : cases) {
+        Result r = runOnce(bulkConns, smallConns, seconds, c.readBudget, c.frameBudget);
+        std::sort(r.rtts.begin(), r.rtts.end());
+        auto percentile = [&r](double p) {
+            return r.rtts.empty() ? 0.0 : r.rtts[static_cast<size_t>(p * (r.rtts.size() - 1))] / 1000.0;
+        };
+        const LatencyHistogram::Snapshot &delay = r.latency.readDelay;
+        printf("bench=fairness read_budget=%zu frame_budget=%d bulk_conns=%d small_conns=%d seconds=%d "
+               "small_req_per_s=%.0f small_p50_us=%.1f small_p99_us=%.1f small_p999_us=%.1f bulk_MBps=%.1f "
+               "reads_deferred=%lu read_delay_p99_us=%.1f\n",
+               c.readBudget, c.frameBudget, bulkConns, smallConns, seconds,
+               static_cast<double>(r.rtts.size()) / seconds, percentile(0.5), percentile(0.99), percentile(0.999),
+               r.bulkBytes / 1e6 / seconds, static_cast<unsigned long>(r.stats.readsDeferred),
+               delay.percentile(0.99) / 1000.0);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "HttpServer.h"
+#include "TcpServer.h"
+#include "Logger.h"
+
+/**
+ * HTTP服务器与回显服务器(example/testserver.cc的逻辑, 不打印日志)的吞吐对比
+ * 每个客户端线程持有一个连接, 一次写入pipeline个请求后读回全部响应
+ * 用法: http_bench [客户端连接数] [pipeline深度] [秒数] [subloop数]
+**/
+
+static const char kRequest[] =
+    "GET /hello HTTP/1.1\r\nHost: localhost\r\nUser-Agent: http_bench\r\nAccept: */*\r\n\r\n";
+static const char kBody[] = "hello, world\n";
+
+static void onRequest(const HttpRequest &, HttpResponse *resp) {
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setContentType("text/plain");
+    resp->setBody(std::string_view(kBody, sizeof kBody - 1));
+}
+
+static void onEcho(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    conn->send(buf);
+}
+
+// 单个客户端: 循环发送pipeline个请求, 读满pipeline个响应
+static void runClient(const InetAddress &addr, int pipeline, size_t responseLen,
+                      const std::atomic<bool> &stop, std::atomic<uint64_t> *requests) {
+    int fd = ::socket(addr.family(), SOCK_STREAM, 0);
+    if (::connect(fd, addr.getSockAddr(), addr.getSockLen()) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+    std::string batch;
+    for (int i = 0; i < pipeline; ++i) {
+        batch.append(kRequest, sizeof kRequest - 1);
+    }
+    std::vector<char> response(responseLen * pipeline);
+    uint64_t done = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (::write(fd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size())) {
+            perror("write");
+            break;
+        }
+        size_t got = 0;
+        while (got < response.size()) {
+            ssize_t n = ::read(fd, response.data() + got, response.size() - got);
+            if (n <= 0) {
+                perror("read");
+                exit(1);
+            }
+            got += n;
+        }
+        done += pipeline;
+    }
+    requests->fetch_add(done);
+    ::close(fd);
+}
+
+static void runLoad(const char *name, const InetAddress &addr, int numClients, int pipeline,
+                    size_t responseLen, int seconds) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> requests(0);
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numClients; ++i) {
+        clients.emplace_back(runClient, addr, pipeline, responseLen, std::cref(stop), &requests);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (auto &t : clients) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double qps = requests.load() / elapsed;
+    printf("bench=%s clients=%d pipeline=%d requests=%lu req_per_s=%.0f response_MB_per_s=%.1f\n",
+           name, numClients, pipeline, static_cast<unsigned long>(requests.load()),
+           qps, qps * responseLen / 1e6);
+}
+
+int main(int argc, char *argv[]) {
+    int numClients = argc > 1 ? atoi(argv[1]) : 4;
+    int pipeline = argc > 2 ? atoi(argv[2]) : 1;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    int numThreads = argc > 4 ? atoi(argv[4]) : 2;
+
+    Logger::setInfoEnabled(false);
+
+    EventLoop loop;
+    InetAddress httpAddr(9982), echoAddr(9983);
+    HttpServer httpServer(&loop, httpAddr, "HttpBench");
+    httpServer.setHttpCallback(onRequest);
+    httpServer.setThreadNum(numThreads);
+    httpServer.start();
+
+    TcpServer echoServer(&loop, echoAddr, "EchoBench");
+    echoServer.setMessageCallback(onEcho);
+    echoServer.setThreadNum(numThreads);
+    echoServer.start();
+
+    // 响应长度固定, 用同样的方式构造一次即可得到
+    Buffer expected;
+    HttpResponse resp(false);
+    onRequest(HttpRequest(), &resp);
+    resp.appendToBuffer(&expected);
+    size_t httpResponseLen = expected.readableBytes();
+
+    std::thread driver([&]() {
+        runLoad("http", httpAddr, numClients, pipeline, httpResponseLen, seconds);
+        runLoad("echo", echoAddr, numClients, pipeline, sizeof kRequest - 1, seconds);
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+    return 0;
+}
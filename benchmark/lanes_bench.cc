@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+
+/**
+ * functor通道压测: 服务端loop上运行echo服务, 另一个线程周期性地向该loop投递一批后台任务(每个忙等若干微秒)
+ * 分别把后台任务放入紧急通道(即原来的queueInLoop)和带配额的批量通道, 对比echo往返延迟、紧急通道排队延迟和后台任务吞吐
+ * 开始前先检查批量通道有剩余时新入队的回调不会被poll阻塞
+ * 用法: lanes_bench [echo连接数] [每批任务数] [每个任务微秒数] [批量通道每轮毫秒配额] [秒数]
+**/
+
+static const uint16_t kPort = 9969;
+
+static void spin(int64_t nanos) {
+    int64_t until = LatencyHistogram::now() + nanos;
+    while (LatencyHistogram::now() < until) {
+    }
+}
+
+// 每轮只执行1个批量回调, 前一批执行期间从其他线程再投递一个, 返回它从投递到执行的毫秒数
+static double carryOverDelayMs() {
+    EventLoopThread thread;
+    EventLoop *loop = thread.startLoop();
+    loop->setBulkBudget(1, 0);
+    for (int i = 0; i < 2; ++i) {
+        loop->queueInLoop([]() { spin(50 * 1000 * 1000); }, EventLoop::kBulk);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::promise<double> ran;
+    int64_t queuedAt = LatencyHistogram::now();
+    loop->queueInLoop([&]() { ran.set_value((LatencyHistogram::now() - queuedAt) / 1e6); }, EventLoop::kBulk);
+    return ran.get_future().get();
+}
+
+struct Result {
+    std::vector<int64_t> rtts; // echo往返延迟, 纳秒
+    uint64_t tasks = 0; // 执行完的后台任务数
+    LoopLatencyStats latency;
+    LoopStats stats;
+};
+
+static Result runOnce(int numClients, int burst, int taskMicros, double budgetMs, int seconds, bool bulkLane) {
+    Result result;
+    std::atomic<bool> stopped(false);
+    std::atomic<uint64_t> tasks(0);
+    const std::string request(16, 'p');
+
+    EventLoopThread serverThread;
+    EventLoop *serverLoop = serverThread.startLoop();
+    if (bulkLane) {
+        serverLoop->setBulkBudget(0, budgetMs / 1000);
+    }
+    TcpServer server(serverLoop, InetAddress(kPort), "LanesServer", TcpServer::kReusePort);
+    server.setConnectionCallback([](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            conn->setTcpNoDelay(true);
+        }
+    });
+    server.setMessageCallback([&stopped](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+        if (stopped.load(std::memory_order_relaxed)) {
+            buf->retrieveAll(); // 客户端即将断开, 不再回复
+            return;
+        }
+        conn->send(buf);
+    });
+    std::promise<void> listening; // 开始监听后客户端再发起连接
+    serverLoop->runInLoop([&]() {
+        server.start();
+        listening.set_value();
+    });
+    listening.get_future().wait();
+
+    // echo客户端: 收齐回复后立即发下一个请求, 发送时间保存在连接上下文中
+    EventLoopThread clientThread;
+    EventLoop *clientLoop = clientThread.startLoop();
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < numClients; ++i) {
+        clients.emplace_back(new TcpClient(clientLoop, InetAddress(kPort), "LanesClient"));
+        clients.back()->setConnectionCallback([&](const TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                conn->setTcpNoDelay(true);
+                conn->setContext(LatencyHistogram::now());
+                conn->send(request);
+            }
+        });
+        clients.back()->setMessageCallback([&](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+            if (buf->readableBytes() < request.size()) {
+                return;
+            }
+            buf->retrieveAll();
+            int64_t now = LatencyHistogram::now();
+            result.rtts.push_back(now - std::any_cast<int64_t>(conn->getContext()));
+            if (!stopped.load(std::memory_order_relaxed)) {
+                conn->setContext(now);
+                conn->send(request);
+            }
+        });
+        clients.back()->connect();
+    }
+
+    // 每10ms投递一批后台任务
+    EventLoop::Priority priority = bulkLane ? EventLoop::kBulk : EventLoop::kUrgent;
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        for (int i = 0; i < burst; ++i) {
+            serverLoop->queueInLoop([&tasks, taskMicros]() {
+                spin(taskMicros * 1000);
+                tasks.fetch_add(1, std::memory_order_relaxed);
+            }, priority);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stopped = true;
+    result.tasks = tasks.load();
+    for (const LoopStats &stats : server.loopStats()) result.stats += stats;
+    for (const LoopLatencyStats &stats : server.loopLatencyStats()) result.latency += stats;
+
+    // 客户端在自己的loop中析构, 等析构完成再退出
+    std::promise<void> closed;
+    clientLoop->runInLoop([&]() {
+        clients.clear();
+        closed.set_value();
+    });
+    closed.get_future().wait();
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    int numClients = argc > 1 ? atoi(argv[1]) : 8;
+    int burst = argc > 2 ? atoi(argv[2]) : 200;
+    int taskMicros = argc > 3 ? atoi(argv[3]) : 20;
+    double budgetMs = argc > 4 ? atof(argv[4]) : 0.5;
+    int seconds = argc > 5 ? atoi(argv[5]) : 3;
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    double delayMs = carryOverDelayMs(); // 前两个回调共100ms, 超过1s说明被poll阻塞
+    printf("bench=lanes check=carry_over delay_ms=%.1f verify=%s\n", delayMs, delayMs < 1000 ? "ok" : "FAILED");
+    fflush(stdout);
+    if (delayMs >= 1000) {
+        return 1;
+    }
+
+    for (bool bulkLane : {false, true}) {
+        Result r = runOnce(numClients, burst, taskMicros, budgetMs, seconds, bulkLane);
+        std::sort(r.rtts.begin(), r.rtts.end());
+        auto percentile = [&r](double p) {
+            return r.rtts.empty() ? 0.0 : r.rtts[static_cast<size_t>(p * (r.rtts.size() - 1))] / 1000.0;
+        };
+        printf("bench=lanes lane=%s clients=%d burst=%d task_us=%d budget_ms=%.2f seconds=%d "
+               "echo_per_s=%.0f echo_p50_us=%.1f echo_p99_us=%.1f urgent_delay_p99_us=%.1f bulk_delay_p99_us=%.1f "
+               "tasks_per_s=%.0f carry_overs=%lu\n",
+               bulkLane ? "bulk" : "urgent", numClients, burst, taskMicros, bulkLane ? budgetMs : 0.0, seconds,
+               static_cast<double>(r.rtts.size()) / seconds, percentile(0.5), percentile(0.99),
+               r.latency.functorDelay.percentile(0.99) / 1000.0, r.latency.bulkFunctorDelay.percentile(0.99) / 1000.0,
+               static_cast<double>(r.tasks) / seconds, static_cast<unsigned long>(r.stats.bulkCarryOvers));
+        fflush(stdout);
+    }
+    return 0;
+}
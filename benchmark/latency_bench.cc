@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "LatencyHistogram.h"
+#include "Logger.h"
+
+/**
+ * 请求/响应延迟压测: 每个连接一次只有一个请求在途, 收齐size字节的回显后立即发下一个请求
+ * 客户端基于本库的loop, 每个客户端线程的往返时间记入自己的LatencyHistogram, 结束后合并求分位数
+ * 依次测试多种消息大小, 每种大小输出一行
+ * 用法: latency_bench [连接数] [秒数] [服务端subloop数] [客户端线程数] [消息字节数...]
+**/
+
+static const uint16_t kPort = 9961;
+
+struct Session {
+    std::string request;
+    size_t received = 0; // 当前请求已收到的回显字节数
+    int64_t sentAt = 0;
+};
+
+struct ClientThread {
+    LatencyHistogram rtt; // 只在该线程中记录
+    bool stopped = false;
+    int connected = 0;
+};
+
+static void sendRequest(const TcpConnectionPtr &conn, Session *session) {
+    session->received = 0;
+    session->sentAt = LatencyHistogram::now();
+    conn->send(session->request);
+}
+
+static void runClientThread(const InetAddress &serverAddr, int numConnections, size_t messageSize,
+                            int seconds, ClientThread *state) {
+    EventLoop loop;
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    std::vector<Session> sessions(numConnections);
+    for (int i = 0; i < numConnections; ++i) {
+        Session *session = &sessions[i];
+        session->request.assign(messageSize, 'x');
+        clients.emplace_back(new TcpClient(&loop, serverAddr, "LatencyClient"));
+        clients.back()->setConnectionCallback([state, session, &loop](const TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                ++state->connected;
+                conn->setTcpNoDelay(true);
+                sendRequest(conn, session);
+            } else if (--state->connected == 0 && state->stopped) {
+                loop.quit();
+            }
+        });
+        clients.back()->setMessageCallback([state, session](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+            session->received += buf->readableBytes();
+            buf->retrieveAll();
+            if (session->received >= session->request.size() && !state->stopped) {
+                state->rtt.record(LatencyHistogram::now() - session->sentAt);
+                sendRequest(conn, session);
+            }
+        });
+        clients.back()->connect();
+    }
+    loop.runAfter(seconds, [state, &clients, &loop]() {
+        state->stopped = true;
+        if (state->connected == 0) {
+            loop.quit();
+            return;
+        }
+        for (auto &client : clients) {
+            client->disconnect();
+        }
+    });
+    loop.loop();
+}
+
+static void runCase(const InetAddress &addr, int numConnections, size_t messageSize, int seconds,
+                    int serverThreads, int clientThreads) {
+    std::vector<std::unique_ptr<ClientThread>> states;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clientThreads; ++i) {
+        states.emplace_back(new ClientThread);
+        int n = numConnections / clientThreads + (i < numConnections % clientThreads ? 1 : 0);
+        threads.emplace_back(runClientThread, addr, n, messageSize, seconds, states.back().get());
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    LatencyHistogram::Snapshot rtt;
+    for (const auto &state : states) {
+        rtt += state->rtt.snapshot();
+    }
+    printf("bench=latency connections=%d message_size=%zu server_threads=%d client_threads=%d requests=%lu "
+           "req_per_s=%.0f mean_us=%.1f p50_us=%.1f p90_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f\n",
+           numConnections, messageSize, serverThreads, clientThreads, static_cast<unsigned long>(rtt.count),
+           static_cast<double>(rtt.count) / seconds, rtt.mean() / 1000, rtt.percentile(0.5) / 1000.0,
+           rtt.percentile(0.9) / 1000.0, rtt.percentile(0.99) / 1000.0, rtt.percentile(0.999) / 1000.0,
+           rtt.max / 1000.0);
+}
+
+int main(int argc, char *argv[]) {
+    int numConnections = argc > 1 ? atoi(argv[1]) : 8;
+    int seconds = argc > 2 ? atoi(argv[2]) : 2;
+    int serverThreads = argc > 3 ? atoi(argv[3]) : 1;
+    int clientThreads = argc > 4 ? atoi(argv[4]) : 1;
+    std::vector<size_t> sizes;
+    for (int i = 5; i < argc; ++i) {
+        sizes.push_back(static_cast<size_t>(atoi(argv[i])));
+    }
+    if (sizes.empty()) {
+        sizes = {64, 1024, 16384};
+    }
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoop loop;
+    InetAddress addr(kPort);
+    TcpServer server(&loop, addr, "LatencyServer");
+    server.setConnectionCallback([](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            conn->setTcpNoDelay(true);
+        }
+    });
+    server.setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+        conn->send(buf);
+    });
+    server.setThreadNum(serverThreads);
+    server.start();
+
+    std::thread driver([&]() {
+        for (size_t size : sizes) {
+            runCase(addr, numConnections, size, seconds, serverThreads, clientThreads);
+        }
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+    return 0;
+}
@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Buffer.h"
+#include "Channel.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "InetAddress.h"
+#include "Timestamp.h"
+#include "Logger.h"
+
+/**
+ * 核心基础组件的微基准: Buffer、queueInLoop跨线程投递、Channel分发、Timestamp、InetAddress、日志宏
+ * 每项先预热一轮, 再重复测量kRepetitions轮, 输出每次操作的纳秒数(中位数和最小值)与内存分配次数
+ * 内存分配次数通过替换全局operator new统计, 包括库内部和其他线程的分配
+ * 用法: micro_bench [名字过滤子串]
+**/
+
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = ::malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    ::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    ::free(p);
+}
+
+static const int kRepetitions = 5;
+static const char *g_filter = nullptr;
+static FILE *g_out = nullptr; // 结果输出, 日志压测期间标准输出被重定向到/dev/null
+
+// 防止编译器把被测代码当作无用计算删掉
+template <typename T>
+static void doNotOptimize(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// body(n)执行n次被测操作
+template <typename Body>
+static void runBench(const char *name, uint64_t iterations, Body body) {
+    if (g_filter != nullptr && ::strstr(name, g_filter) == nullptr) {
+        return;
+    }
+    body(iterations / 10 + 1); // 预热: 填充缓存、触发惰性初始化和缓冲区扩容
+
+    std::vector<double> nsPerOp;
+    uint64_t allocations = 0;
+    for (int rep = 0; rep < kRepetitions; ++rep) {
+        uint64_t allocsBefore = g_allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        body(iterations);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        allocations += g_allocations.load(std::memory_order_relaxed) - allocsBefore;
+        nsPerOp.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / iterations);
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    fprintf(g_out, "bench=micro name=%s iterations=%lu reps=%d ns_per_op=%.1f min_ns_per_op=%.1f allocs_per_op=%.3f\n",
+           name, static_cast<unsigned long>(iterations), kRepetitions, nsPerOp[kRepetitions / 2], nsPerOp[0],
+           static_cast<double>(allocations) / (static_cast<double>(iterations) * kRepetitions));
+    fflush(g_out);
+}
+
+static void benchBuffer() {
+    char data[4096];
+    ::memset(data, 'x', sizeof data);
+
+    Buffer buffer;
+    runBench("buffer_append_retrieve_64", 10000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            buffer.append(data, 64);
+            buffer.retrieve(64);
+        }
+        doNotOptimize(buffer.readableBytes());
+    });
+
+    runBench("buffer_append_retrieve_4k", 2000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            buffer.append(data, 4096);
+            buffer.retrieve(4096);
+        }
+        doNotOptimize(buffer.readableBytes());
+    });
+
+    // 从空缓冲区累积到64K, 包含扩容和搬移
+    runBench("buffer_grow_to_64k", 100000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            Buffer b;
+            for (int j = 0; j < 16; ++j) {
+                b.append(data, 4096);
+            }
+            doNotOptimize(b.readableBytes());
+        }
+    });
+
+    runBench("buffer_retrieve_as_string_64", 5000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            buffer.append(data, 64);
+            std::string s = buffer.retrieveAllAsString();
+            doNotOptimize(s.size());
+        }
+    });
+
+    // 每次先向socketpair写入再readFd读出, 结果包含一次write系统调用
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        perror("socketpair");
+        return;
+    }
+    for (size_t size : {64, 4096}) {
+        std::string name = "buffer_readfd_" + std::string(size == 64 ? "64" : "4k") + "_with_write";
+        runBench(name.c_str(), 100000, [&](uint64_t n) {
+            int savedErrno = 0;
+            for (uint64_t i = 0; i < n; ++i) {
+                if (::write(fds[1], data, size) != static_cast<ssize_t>(size)) {
+                    abort();
+                }
+                buffer.readFd(fds[0], &savedErrno);
+                buffer.retrieveAll();
+            }
+        });
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+static void benchQueueInLoop() {
+    EventLoopThread thread;
+    EventLoop *loop = thread.startLoop();
+
+    // 吞吐: 连续投递n个functor, 等最后一个执行完
+    runBench("queue_in_loop_throughput", 200000, [&](uint64_t n) {
+        std::atomic<uint64_t> done(0);
+        for (uint64_t i = 0; i < n; ++i) {
+            loop->queueInLoop([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load(std::memory_order_acquire) < n) {
+            std::this_thread::yield();
+        }
+    });
+
+    // 延迟: 投递一个functor后等待它执行, 包含eventfd唤醒和loop线程调度
+    runBench("queue_in_loop_roundtrip", 20000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            std::atomic<bool> ran(false);
+            loop->queueInLoop([&ran]() { ran.store(true, std::memory_order_release); });
+            while (!ran.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // runInLoop在loop线程中直接执行
+    runBench("run_in_loop_same_thread", 5000000, [&](uint64_t n) {
+        std::atomic<bool> finished(false);
+        loop->queueInLoop([&]() {
+            uint64_t count = 0;
+            for (uint64_t i = 0; i < n; ++i) {
+                loop->runInLoop([&count]() { ++count; });
+            }
+            doNotOptimize(count);
+            finished.store(true, std::memory_order_release);
+        });
+        while (!finished.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    });
+}
+
+static void benchChannel() {
+    EventLoop loop; // Channel构造需要loop, 这里直接调用handleEvent, 不经过poller
+    int fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    uint64_t reads = 0;
+
+    Channel channel(&loop, fd);
+    channel.setReadCallback([&reads](Timestamp) { ++reads; });
+    channel.set_revents(EPOLLIN);
+    Timestamp receiveTime = Timestamp::now();
+    runBench("channel_handle_event", 20000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            channel.handleEvent(receiveTime);
+        }
+        doNotOptimize(reads);
+    });
+
+    // TcpConnection的channel绑定了owner, 每次分发都要weak_ptr::lock
+    std::shared_ptr<int> owner = std::make_shared<int>(0);
+    Channel tied(&loop, fd);
+    tied.setReadCallback([&reads](Timestamp) { ++reads; });
+    tied.set_revents(EPOLLIN);
+    tied.tie(owner);
+    runBench("channel_handle_event_tied", 20000000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            tied.handleEvent(receiveTime);
+        }
+        doNotOptimize(reads);
+    });
+    ::close(fd);
+}
+
+static void benchTimestampAndAddress() {
+    runBench("timestamp_now", 10000000, [](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            Timestamp t = Timestamp::now();
+            doNotOptimize(t);
+        }
+    });
+    runBench("timestamp_to_string", 200000, [](uint64_t n) {
+        Timestamp t = Timestamp::now();
+        for (uint64_t i = 0; i < n; ++i) {
+            std::string s = t.toString();
+            doNotOptimize(s.size());
+        }
+    });
+
+    InetAddress v4(8080, "192.168.100.200");
+    runBench("inetaddress_to_ip_port_v4", 500000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            std::string s = v4.toIpPort();
+            doNotOptimize(s.size());
+        }
+    });
+    InetAddress v6(8080, "2001:db8::1");
+    runBench("inetaddress_to_ip_port_v6", 500000, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            std::string s = v6.toIpPort();
+            doNotOptimize(s.size());
+        }
+    });
+}
+
+static void benchLogger() {
+    // 日志写到/dev/null, 测的是格式化和输出本身的开销
+    fflush(stdout);
+    int savedStdout = ::dup(STDOUT_FILENO);
+    int devNull = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    ::dup2(devNull, STDOUT_FILENO);
+    ::close(devNull);
+
+    Logger::setInfoEnabled(false);
+    runBench("log_info_disabled", 50000000, [](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            LOG_INFO("fd=%d events=%d\n", static_cast<int>(i), 1);
+        }
+    });
+    Logger::setInfoEnabled(true);
+    runBench("log_info_enabled", 50000, [](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            LOG_INFO("fd=%d events=%d\n", static_cast<int>(i), 1);
+        }
+    });
+    runBench("log_error", 50000, [](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            LOG_ERROR("fd=%d err=%d\n", static_cast<int>(i), 11);
+        }
+    });
+    Logger::setInfoEnabled(false);
+
+    std::cout.flush();
+    ::dup2(savedStdout, STDOUT_FILENO);
+    ::close(savedStdout);
+}
+
+int main(int argc, char *argv[]) {
+    g_filter = argc > 1 ? argv[1] : nullptr;
+    g_out = ::fdopen(::dup(STDOUT_FILENO), "w");
+    Logger::setInfoEnabled(false);
+
+    benchBuffer();
+    benchQueueInLoop();
+    benchChannel();
+    benchTimestampAndAddress();
+    benchLogger();
+    return 0;
+}
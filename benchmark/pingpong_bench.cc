@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+/**
+ * ping-pong吞吐压测: 每个连接建立后先发送一个size字节的消息, 之后客户端和服务端都把收到的数据原样发回
+ * 连接上始终只有size字节在往返, 测的是框架在不同消息大小和连接数下的吞吐(MB/s)和消息速率
+ * 客户端和服务端都基于本库的loop; 默认在同一进程中通过loopback运行, 也可以分开运行
+ * 用法: pingpong_bench [连接数] [消息字节数] [秒数] [服务端subloop数] [客户端线程数]
+ *       pingpong_bench server <端口> [subloop数]
+ *       pingpong_bench client <ip> <端口> [连接数] [消息字节数] [秒数] [客户端线程数]
+**/
+
+static const uint16_t kDefaultPort = 9960;
+
+static void onServerConnection(const TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+        conn->setTcpNoDelay(true);
+    }
+}
+
+static void onEcho(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    conn->send(buf);
+}
+
+// 一个客户端线程: 一个loop和若干连接
+struct ClientThread {
+    uint64_t bytesRead = 0; // 停止时刻之前收到的字节数, 只在该线程中访问
+    bool stopped = false;
+    int connected = 0;
+};
+
+static void runClientThread(const InetAddress &serverAddr, int numConnections, size_t messageSize,
+                            int seconds, ClientThread *state) {
+    EventLoop loop;
+    std::string message(messageSize, 'x');
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < numConnections; ++i) {
+        clients.emplace_back(new TcpClient(&loop, serverAddr, "PingPongClient"));
+        clients.back()->setConnectionCallback([state, &message, &loop](const TcpConnectionPtr &conn) {
+            if (conn->connected()) {
+                ++state->connected;
+                conn->setTcpNoDelay(true);
+                conn->send(message);
+            } else if (--state->connected == 0 && state->stopped) {
+                loop.quit(); // 所有连接都已关闭
+            }
+        });
+        clients.back()->setMessageCallback([state](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+            if (!state->stopped) {
+                state->bytesRead += buf->readableBytes();
+                conn->send(buf);
+            } else {
+                buf->retrieveAll();
+            }
+        });
+        clients.back()->connect();
+    }
+    loop.runAfter(seconds, [state, &clients, &loop]() {
+        state->stopped = true;
+        if (state->connected == 0) {
+            loop.quit();
+            return;
+        }
+        for (auto &client : clients) {
+            client->disconnect();
+        }
+    });
+    loop.loop();
+}
+
+// serverThreads只用于输出, -1表示服务端在其他进程中
+static void runClients(const InetAddress &serverAddr, int numConnections, size_t messageSize,
+                       int seconds, int numThreads, int serverThreads) {
+    std::vector<ClientThread> states(numThreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        // 连接尽量平均分到各线程
+        int n = numConnections / numThreads + (i < numConnections % numThreads ? 1 : 0);
+        threads.emplace_back(runClientThread, serverAddr, n, messageSize, seconds, &states[i]);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    uint64_t bytes = 0;
+    for (const ClientThread &state : states) {
+        bytes += state.bytesRead;
+    }
+    double mbps = bytes / 1048576.0 / seconds;
+    printf("bench=pingpong connections=%d message_size=%zu server_threads=%d client_threads=%d seconds=%d "
+           "bytes=%lu MB_per_s=%.1f msgs_per_s=%.0f\n",
+           numConnections, messageSize, serverThreads, numThreads, seconds, static_cast<unsigned long>(bytes),
+           mbps, static_cast<double>(bytes) / messageSize / seconds);
+}
+
+static void runServer(uint16_t port, int numThreads) {
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "PingPongServer");
+    server.setConnectionCallback(onServerConnection);
+    server.setMessageCallback(onEcho);
+    server.setThreadNum(numThreads);
+    server.start();
+    loop.loop();
+}
+
+int main(int argc, char *argv[]) {
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    if (argc > 1 && ::strcmp(argv[1], "server") == 0) {
+        uint16_t port = static_cast<uint16_t>(argc > 2 ? atoi(argv[2]) : kDefaultPort);
+        runServer(port, argc > 3 ? atoi(argv[3]) : 1);
+        return 0;
+    }
+    if (argc > 1 && ::strcmp(argv[1], "client") == 0) {
+        if (argc < 4) {
+            fprintf(stderr, "usage: pingpong_bench client <ip> <port> [connections] [message_size] [seconds] [threads]\n");
+            return 1;
+        }
+        InetAddress serverAddr(static_cast<uint16_t>(atoi(argv[3])), argv[2]);
+        int numConnections = argc > 4 ? atoi(argv[4]) : 16;
+        size_t messageSize = static_cast<size_t>(argc > 5 ? atoi(argv[5]) : 4096);
+        int seconds = argc > 6 ? atoi(argv[6]) : 3;
+        int numThreads = argc > 7 ? atoi(argv[7]) : 1;
+        runClients(serverAddr, numConnections, messageSize, seconds, numThreads, -1);
+        return 0;
+    }
+
+    int numConnections = argc > 1 ? atoi(argv[1]) : 16;
+    size_t messageSize = static_cast<size_t>(argc > 2 ? atoi(argv[2]) : 4096);
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    int serverThreads = argc > 4 ? atoi(argv[4]) : 1;
+    int clientThreads = argc > 5 ? atoi(argv[5]) : 1;
+
+    EventLoop loop;
+    InetAddress addr(kDefaultPort);
+    TcpServer server(&loop, addr, "PingPongServer");
+    server.setConnectionCallback(onServerConnection);
+    server.setMessageCallback(onEcho);
+    server.setThreadNum(serverThreads);
+    server.start();
+
+    std::thread driver([&]() {
+        runClients(addr, numConnections, messageSize, seconds, clientThreads, serverThreads);
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * RESP流水线压测客户端, 负载为example/kvserver.cc(也可以直接压测redis-server)
+ * 每个客户端线程持有一个连接, 一次写入pipeline条命令(GET/SET按比例混合)后读回全部回复
+ * 用法: 先启动 kvserver 6380 [subloop数], 再运行
+ *       resp_bench [端口] [客户端连接数] [pipeline深度] [秒数] [value字节数] [SET比例%]
+**/
+
+static const int kKeySpace = 100000;
+static const int kNumBatches = 64; // 预先构造的命令批次数, 循环使用
+
+static void appendBulk(std::string *out, const std::string &s) {
+    out->append("$").append(std::to_string(s.size())).append("\r\n").append(s).append("\r\n");
+}
+
+// 跳过一个完整的回复, 数据不完整时返回nullptr
+static const char* skipReply(const char *p, const char *end) {
+    if (p >= end) {
+        return nullptr;
+    }
+    const char *eol = static_cast<const char *>(::memchr(p, '\n', end - p));
+    if (eol == nullptr) {
+        return nullptr;
+    }
+    const char *next = eol + 1;
+    long n = 0;
+    switch (*p) {
+        case '$': // bulk string: $len\r\n data \r\n
+            n = strtol(p + 1, nullptr, 10);
+            if (n < 0) return next;
+            return end - next >= n + 2 ? next + n + 2 : nullptr;
+        case '*': // 数组
+        case '%': // map
+            n = strtol(p + 1, nullptr, 10);
+            if (*p == '%') n *= 2;
+            for (long i = 0; i < n && next != nullptr; ++i) {
+                next = skipReply(next, end);
+            }
+            return next;
+        default: // + - : _ # , 都是单行
+            return next;
+    }
+}
+
+struct ClientResult {
+    uint64_t commands = 0;
+    uint64_t errors = 0;
+    std::vector<double> batchMicros; // 每批命令的往返时间
+};
+
+static void runClient(const sockaddr_in &addr, int pipeline, int valueSize, int setPercent,
+                      unsigned seed, const std::atomic<bool> &stop, ClientResult *result) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (::connect(fd, (const sockaddr *)&addr, sizeof addr) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+    std::mt19937 rng(seed);
+    std::string value(valueSize, 'x');
+    std::vector<std::string> batches(kNumBatches);
+    for (std::string &batch : batches) {
+        for (int i = 0; i < pipeline; ++i) {
+            std::string key = "key:" + std::to_string(rng() % kKeySpace);
+            if (static_cast<int>(rng() % 100) < setPercent) {
+                batch.append("*3\r\n");
+                appendBulk(&batch, "SET");
+                appendBulk(&batch, key);
+                appendBulk(&batch, value);
+            } else {
+                batch.append("*2\r\n");
+                appendBulk(&batch, "GET");
+                appendBulk(&batch, key);
+            }
+        }
+    }
+
+    std::vector<char> input(64 * 1024);
+    size_t batchIndex = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        const std::string &batch = batches[batchIndex++ % kNumBatches];
+        auto start = std::chrono::steady_clock::now();
+        if (::write(fd, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size())) {
+            perror("write");
+            break;
+        }
+        // 读到pipeline个完整回复为止
+        size_t len = 0;
+        size_t parsed = 0;
+        int replies = 0;
+        while (replies < pipeline) {
+            if (len == input.size()) {
+                input.resize(input.size() * 2);
+            }
+            ssize_t n = ::read(fd, input.data() + len, input.size() - len);
+            if (n <= 0) {
+                perror("read");
+                exit(1);
+            }
+            len += n;
+            const char *end = input.data() + len;
+            const char *p = input.data() + parsed;
+            const char *next;
+            while (replies < pipeline && (next = skipReply(p, end)) != nullptr) {
+                if (*p == '-') {
+                    ++result->errors;
+                }
+                p = next;
+                ++replies;
+            }
+            parsed = p - input.data();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        result->batchMicros.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+        result->commands += pipeline;
+    }
+    ::close(fd);
+}
+
+int main(int argc, char *argv[]) {
+    int port = argc > 1 ? atoi(argv[1]) : 6380;
+    int numClients = argc > 2 ? atoi(argv[2]) : 4;
+    int pipeline = argc > 3 ? atoi(argv[3]) : 16;
+    int seconds = argc > 4 ? atoi(argv[4]) : 3;
+    int valueSize = argc > 5 ? atoi(argv[5]) : 32;
+    int setPercent = argc > 6 ? atoi(argv[6]) : 10;
+
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    std::atomic<bool> stop(false);
+    std::vector<ClientResult> results(numClients);
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numClients; ++i) {
+        clients.emplace_back(runClient, std::cref(addr), pipeline, valueSize, setPercent,
+                             static_cast<unsigned>(i + 1), std::cref(stop), &results[i]);
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stop = true;
+    for (auto &t : clients) {
+        t.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t commands = 0, errors = 0;
+    std::vector<double> latencies;
+    for (ClientResult &r : results) {
+        commands += r.commands;
+        errors += r.errors;
+        latencies.insert(latencies.end(), r.batchMicros.begin(), r.batchMicros.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+    printf("bench=resp clients=%d pipeline=%d value_size=%d set_percent=%d commands=%lu errors=%lu "
+           "cmd_per_s=%.0f batch_p50_us=%.1f batch_p99_us=%.1f\n",
+           numClients, pipeline, valueSize, setPercent, static_cast<unsigned long>(commands),
+           static_cast<unsigned long>(errors), commands / elapsed, percentile(0.5), percentile(0.99));
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "HotRestart.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+/**
+ * 重启期间的客户端影响: 客户端线程循环 建连 -> 回显64字节 -> 关闭, 压测进行到一半时重启服务端进程
+ * hot: 启动新进程, 新进程通过HotRestart接管监听socket, 旧进程停止accept并排空后退出
+ * cold: 先终止旧进程(监听socket随之关闭), 再启动新进程重新绑定
+ * 服务端是本程序以serve参数启动的子进程
+ * 用法: restart_bench [客户端线程数] [秒数]
+ *       restart_bench serve <端口> <控制socket> <是否接管> <就绪通知fd>
+**/
+
+extern char **environ;
+
+static const size_t kMessageSize = 64;
+
+static int runServer(uint16_t port, const char *control, bool hot, int readyFd) {
+    Logger::setInfoEnabled(false);
+    EventLoop loop;
+    HotRestart restart(&loop, InetAddress::unixPath(control));
+    if (hot) {
+        restart.takeOver();
+    }
+    TcpServer server(&loop, InetAddress(port), "RestartBench");
+    server.setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+        conn->send(buf);
+    });
+    server.setThreadNum(2);
+    server.start();
+    restart.addServer(&server);
+    restart.setDrainedCallback([&loop]() { loop.quit(); });
+    restart.start();
+    char ready = 1;
+    if (::write(readyFd, &ready, 1) != 1) {
+        return 1;
+    }
+    ::close(readyFd);
+    loop.loop();
+    return 0;
+}
+
+// 启动服务端子进程, 等到它开始accept
+static pid_t spawnServer(uint16_t port, const std::string &control, bool hot) {
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+    ::fcntl(fds[1], F_SETFD, 0); // 只有写端留给子进程
+    std::string portArg = std::to_string(port);
+    std::string fdArg = std::to_string(fds[1]);
+    const char *argv[] = {"/proc/self/exe", "serve", portArg.c_str(), control.c_str(),
+                          hot ? "1" : "0", fdArg.c_str(), nullptr};
+    pid_t pid;
+    if (::posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, const_cast<char **>(argv), environ) != 0) {
+        perror("posix_spawn");
+        exit(1);
+    }
+    ::close(fds[1]);
+    char ready;
+    if (::read(fds[0], &ready, 1) != 1) {
+        fprintf(stderr, "server %d exited before ready\n", pid);
+        exit(1);
+    }
+    ::close(fds[0]);
+    return pid;
+}
+
+struct ClientResult {
+    uint64_t requests = 0;
+    uint64_t refused = 0; // ECONNREFUSED
+    uint64_t resets = 0; // 建连后被重置或提前关闭
+    std::vector<double> micros;
+};
+
+static void runClient(uint16_t port, const std::atomic<bool> &stop, ClientResult *result) {
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    char message[kMessageSize];
+    ::memset(message, 'x', sizeof message);
+    char reply[kMessageSize];
+    while (!stop.load(std::memory_order_relaxed)) {
+        auto start = std::chrono::steady_clock::now();
+        // CLOEXEC: 避免客户端连接泄漏到中途启动的服务端子进程中
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (::connect(fd, (const sockaddr *)&addr, sizeof addr) < 0) {
+            if (errno == ECONNREFUSED) {
+                ++result->refused;
+            } else {
+                ++result->resets;
+            }
+            ::close(fd);
+            continue;
+        }
+        bool ok = ::write(fd, message, sizeof message) == static_cast<ssize_t>(sizeof message);
+        size_t got = 0;
+        while (ok && got < sizeof reply) {
+            ssize_t n = ::read(fd, reply + got, sizeof reply - got);
+            if (n <= 0) {
+                ok = false;
+            } else {
+                got += n;
+            }
+        }
+        ::close(fd);
+        if (!ok) {
+            ++result->resets;
+            continue;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        result->micros.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+        ++result->requests;
+    }
+}
+
+static void runCase(const char *mode, uint16_t port, int numClients, int seconds) {
+    bool hot = ::strcmp(mode, "hot") == 0;
+    std::string control = "@muduo-restart-bench-" + std::to_string(::getpid()) + "-" + mode;
+    pid_t oldServer = spawnServer(port, control, false);
+
+    std::atomic<bool> stop(false);
+    std::vector<ClientResult> results(numClients);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < numClients; ++i) {
+        clients.emplace_back(runClient, port, std::cref(stop), &results[i]);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(seconds * 500));
+
+    auto restartStart = std::chrono::steady_clock::now();
+    pid_t newServer;
+    if (hot) {
+        newServer = spawnServer(port, control, true);
+        ::waitpid(oldServer, nullptr, 0); // 旧进程排空后自行退出
+    } else {
+        ::kill(oldServer, SIGTERM);
+        ::waitpid(oldServer, nullptr, 0);
+        newServer = spawnServer(port, control, false);
+    }
+    double restartMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - restartStart).count();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(seconds * 500));
+    stop = true;
+    for (auto &t : clients) {
+        t.join();
+    }
+    ::kill(newServer, SIGTERM);
+    ::waitpid(newServer, nullptr, 0);
+
+    uint64_t requests = 0, refused = 0, resets = 0;
+    std::vector<double> latencies;
+    for (ClientResult &r : results) {
+        requests += r.requests;
+        refused += r.refused;
+        resets += r.resets;
+        latencies.insert(latencies.end(), r.micros.begin(), r.micros.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+    printf("bench=restart mode=%s clients=%d requests=%lu refused=%lu resets=%lu restart_ms=%.1f "
+           "p50_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f\n",
+           mode, numClients, static_cast<unsigned long>(requests), static_cast<unsigned long>(refused),
+           static_cast<unsigned long>(resets), restartMs, percentile(0.5), percentile(0.99),
+           percentile(0.999), latencies.empty() ? 0.0 : latencies.back());
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && ::strcmp(argv[1], "serve") == 0) {
+        if (argc < 6) {
+            return 1;
+        }
+        return runServer(static_cast<uint16_t>(atoi(argv[2])), argv[3], atoi(argv[4]) != 0, atoi(argv[5]));
+    }
+    int numClients = argc > 1 ? atoi(argv[1]) : 4;
+    int seconds = argc > 2 ? atoi(argv[2]) : 2;
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+    runCase("cold", 9951, numClients, seconds);
+    runCase("hot", 9952, numClients, seconds);
+    return 0;
+}
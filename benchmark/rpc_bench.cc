@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RpcServer.h"
+#include "RpcClient.h"
+#include "EventLoop.h"
+#include "WorkStealingThreadPool.h"
+#include "Logger.h"
+
+/**
+ * RPC框架的吞吐和延迟压测, 服务端和客户端在同一进程中
+ * 每个客户端线程一个loop和一个连接, 连接上保持window个并发调用, 收到响应后立即发起下一个
+ * echo方法在loop中同步应答, async_echo方法交给计算线程池, 从worker线程应答
+ * 最后输出服务端所有loop合并后的回调耗时和functor排队延迟分布
+ * 用法: rpc_bench [客户端连接数] [每连接并发调用数] [秒数] [subloop数] [payload字节数]
+**/
+
+// 单个客户端线程的状态, 只在该线程的loop中访问
+struct ClientState {
+    RpcClient *client = nullptr;
+    std::string method;
+    std::string payload;
+    bool stopping = false;
+    uint64_t calls = 0;
+    uint64_t failures = 0;
+    std::vector<int64_t> latencies; // 微秒
+};
+
+static void issueCall(ClientState *state);
+
+static void onResponse(ClientState *state, int64_t start, RpcStatus status, std::string_view) {
+    state->latencies.push_back(TimerQueue::now() - start);
+    if (status == kRpcOk) {
+        ++state->calls;
+    } else {
+        ++state->failures;
+    }
+    if (!state->stopping) {
+        issueCall(state);
+    } else if (state->client->pendingCalls() == 0) {
+        state->client->getLoop()->quit(); // 所有调用都已返回
+    }
+}
+
+static void issueCall(ClientState *state) {
+    int64_t start = TimerQueue::now();
+    state->client->call(state->method, state->payload, [state, start](RpcStatus status, std::string_view response) {
+        onResponse(state, start, status, response);
+    }, 1000);
+}
+
+static void runClient(const InetAddress &addr, int window, int seconds, ClientState *state) {
+    EventLoop loop;
+    RpcClient client(&loop, addr, "RpcBenchClient");
+    state->client = &client;
+    client.setConnectionCallback([state, window](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            for (int i = 0; i < window; ++i) {
+                issueCall(state);
+            }
+        }
+    });
+    client.connect();
+    loop.runAfter(seconds, [state]() { state->stopping = true; });
+    loop.loop();
+    client.disconnect();
+}
+
+static void runLoad(const char *method, const InetAddress &addr, int numClients, int window,
+                    int seconds, size_t payloadSize) {
+    std::vector<std::unique_ptr<ClientState>> states;
+    std::vector<std::thread> threads;
+    int64_t start = TimerQueue::now();
+    for (int i = 0; i < numClients; ++i) {
+        states.emplace_back(new ClientState);
+        states.back()->method = method;
+        states.back()->payload.assign(payloadSize, 'x');
+        threads.emplace_back(runClient, addr, window, seconds, states.back().get());
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    double elapsed = static_cast<double>(TimerQueue::now() - start) / 1000000;
+
+    uint64_t calls = 0, failures = 0;
+    std::vector<int64_t> latencies;
+    for (auto &state : states) {
+        calls += state->calls;
+        failures += state->failures;
+        latencies.insert(latencies.end(), state->latencies.begin(), state->latencies.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies.empty() ? 0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+    printf("bench=rpc method=%s clients=%d window=%d payload=%zu calls=%lu failures=%lu "
+           "calls_per_s=%.0f p50_us=%ld p99_us=%ld p999_us=%ld\n",
+           method, numClients, window, payloadSize, static_cast<unsigned long>(calls),
+           static_cast<unsigned long>(failures), calls / elapsed,
+           static_cast<long>(percentile(0.5)), static_cast<long>(percentile(0.99)),
+           static_cast<long>(percentile(0.999)));
+}
+
+static void printLoopLatency(TcpServer &server) {
+    LoopLatencyStats total;
+    for (const LoopLatencyStats &stats : server.loopLatencyStats()) {
+        total += stats;
+    }
+    const std::pair<const char *, const LatencyHistogram::Snapshot *> stages[] = {
+        {"event", &total.eventHandling},
+        {"message", &total.messageCallback},
+        {"functor", &total.functorRun},
+        {"functor_delay", &total.functorDelay},
+        {"bulk_functor_delay", &total.bulkFunctorDelay},
+        {"read_delay", &total.readDelay},
+    };
+    for (const auto &stage : stages) {
+        const LatencyHistogram::Snapshot &h = *stage.second;
+        printf("bench=rpc_server_loop stage=%s count=%lu mean_us=%.2f p50_us=%.2f p99_us=%.2f p999_us=%.2f max_us=%.2f\n",
+               stage.first, static_cast<unsigned long>(h.count), h.mean() / 1000, h.percentile(0.5) / 1000.0,
+               h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0, h.max / 1000.0);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int numClients = argc > 1 ? atoi(argv[1]) : 4;
+    int window = argc > 2 ? atoi(argv[2]) : 32;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+    int numThreads = argc > 4 ? atoi(argv[4]) : 2;
+    size_t payloadSize = argc > 5 ? static_cast<size_t>(atoi(argv[5])) : 64;
+
+    Logger::setInfoEnabled(false);
+
+    WorkStealingThreadPool workers("RpcBenchWorkers");
+    workers.start(2);
+
+    EventLoop loop;
+    InetAddress addr(9984);
+    RpcServer server(&loop, addr, "RpcBench");
+    server.registerMethod("echo", [](std::string_view request, RpcResponder responder) {
+        responder.reply(request);
+    });
+    server.registerMethod("async_echo", [&workers](std::string_view request, RpcResponder responder) {
+        workers.submit([responder, data = std::string(request)]() {
+            responder.reply(data);
+        });
+    });
+    server.setThreadNum(numThreads);
+    server.start();
+
+    std::thread driver([&]() {
+        runLoad("echo", addr, numClients, window, seconds, payloadSize);
+        runLoad("async_echo", addr, numClients, window, seconds, payloadSize);
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+    printLoopLatency(server.tcpServer());
+    workers.stop();
+    return 0;
+}
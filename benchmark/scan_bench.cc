@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#include "Buffer.h"
+#include "ByteScan.h"
+
+/**
+ * 分隔符查找的微基准: 1KB~64KB的缓冲区, 分隔符位于末尾, 统计每周期扫描的字节数
+ * x86_64上使用rdtsc计数, 其他平台以纳秒代替周期; CPU不支持AVX2时不输出avx2的结果
+ * 用法: scan_bench [重复次数]
+**/
+
+static uint64_t ticks() {
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static const char kSet[] = " :\r\n";
+
+template <typename Func>
+static void run(const char *name, size_t size, int reps, Func func) {
+    const char *sink = nullptr;
+    for (int i = 0; i < 100; ++i) sink = func(); // 预热
+    uint64_t start = ticks();
+    for (int i = 0; i < reps; ++i) {
+        sink = func();
+        __asm__ __volatile__("" : : "r"(sink) : "memory"); // 防止调用被优化掉
+    }
+    uint64_t elapsed = ticks() - start;
+    printf("bench=%s size=%zu bytes_per_cycle=%.2f\n",
+           name, size, static_cast<double>(size) * reps / elapsed);
+}
+
+// 各实现在随机数据上的结果必须一致
+static bool verify() {
+    srand(1);
+    std::string data(4096 + 77, 'a');
+    for (int round = 0; round < 2000; ++round) {
+        for (size_t i = 0; i < data.size(); ++i) {
+            int r = rand() % 64;
+            data[i] = r == 0 ? '\r' : r == 1 ? '\n' : r == 2 ? ':' : 'a' + r % 26;
+        }
+        const char *b = data.data() + rand() % 64;
+        const char *e = data.data() + data.size() - rand() % 64;
+        const char *expect = ByteScan::findCRLFScalar(b, e);
+        if (ByteScan::findCRLFSse2(b, e) != expect || ByteScan::findCRLFAvx2(b, e) != expect) return false;
+        expect = ByteScan::findAnyOfScalar(b, e, kSet, sizeof kSet - 1);
+        if (ByteScan::findAnyOfSse2(b, e, kSet, sizeof kSet - 1) != expect
+            || ByteScan::findAnyOfAvx2(b, e, kSet, sizeof kSet - 1) != expect) return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int reps = argc > 1 ? atoi(argv[1]) : 20000;
+    printf("impl=%s verify=%s\n", ByteScan::implName(), verify() ? "ok" : "FAILED");
+    bool avx2 = ByteScan::hasAvx2(); // 不支持AVX2时跳过avx2的行, 否则测到的是标量实现
+
+    const size_t sizes[] = { 1024, 4096, 16384, 65536 };
+    for (size_t size : sizes) {
+        // 只有末尾是分隔符, 其余为普通字符
+        Buffer buf(size);
+        std::string text(size - 2, 'x');
+        buf.append(text.data(), text.size());
+        buf.append("\r\n", 2);
+        const char *b = buf.peek();
+        const char *e = b + buf.readableBytes();
+        int n = static_cast<int>(reps * (1024.0 / size)) + 1;
+
+        run("crlf_scalar", size, n, [&]() { return ByteScan::findCRLFScalar(b, e); });
+        run("crlf_sse2", size, n, [&]() { return ByteScan::findCRLFSse2(b, e); });
+        if (avx2) run("crlf_avx2", size, n, [&]() { return ByteScan::findCRLFAvx2(b, e); });
+        run("crlf_buffer", size, n, [&]() { return buf.findCRLF(); });
+        run("anyof_scalar", size, n, [&]() { return ByteScan::findAnyOfScalar(b, e, kSet, sizeof kSet - 1); });
+        run("anyof_sse2", size, n, [&]() { return ByteScan::findAnyOfSse2(b, e, kSet, sizeof kSet - 1); });
+        if (avx2) run("anyof_avx2", size, n, [&]() { return ByteScan::findAnyOfAvx2(b, e, kSet, sizeof kSet - 1); });
+        run("eol_memchr", size, n, [&]() { return buf.findEOL(); });
+    }
+    return 0;
+}
@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "LatencyHistogram.h"
+#include "LoopCounter.h"
+#include "Logger.h"
+
+/**
+ * 连接风暴压测: 按固定速率新建连接, 直到达到目标并发数, 再保持一段时间(空闲或定时收发小消息)
+ * 服务端accept后立即发送1字节问候, 客户端从开始connect到收到问候的时间记为accept延迟(包含重试和排队)
+ * 每秒输出一行: 累计建立数、本秒建立速率、本秒accept延迟分位数、服务端RSS和每连接内存
+ * 客户端通过多个loopback源IP(127.0.0.2起)发起连接, 突破单个源IP约2.8万个临时端口的限制
+ * 单进程的连接数受RLIMIT_NOFILE限制, 启动时提升到硬上限
+ * 用法: storm_bench [连接数] [每秒新建连接数] [保持秒数] [idle|chatty] [源IP数] [客户端线程数] [服务端subloop数]
+ *       storm_bench client <ip> <端口> <服务端pid|0> [连接数] [每秒新建连接数] [保持秒数] [idle|chatty] [源IP数] [客户端线程数]
+ *       storm_bench serve <端口> <subloop数> <就绪通知fd>
+**/
+
+extern char **environ;
+
+static const uint16_t kDefaultPort = 9962;
+static const double kTickSeconds = 0.01; // 新建连接的节拍
+static const double kChatInterval = 1.0; // chatty模式下每个连接的发送间隔
+static const size_t kChatSize = 64;
+static const int kEstablishGraceSeconds = 10; // 按速率应完成的时间之后, 再等多久仍未建满则放弃
+static const int kCloseTimeoutSeconds = 5;
+
+// 提升到硬上限, 返回当前的软上限
+static rlim_t raiseFileLimit() {
+    rlimit rl;
+    if (::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    ::getrlimit(RLIMIT_NOFILE, &rl);
+    return rl.rlim_cur;
+}
+
+// 从/proc/<pid>/status读取VmRSS, 单位KB, 失败返回0
+static uint64_t readRssKb(pid_t pid) {
+    std::string path = "/proc/" + (pid > 0 ? std::to_string(pid) : std::string("self")) + "/status";
+    FILE *fp = ::fopen(path.c_str(), "re");
+    if (fp == nullptr) {
+        return 0;
+    }
+    char line[256];
+    uint64_t kb = 0;
+    while (::fgets(line, sizeof line, fp) != nullptr) {
+        if (::strncmp(line, "VmRSS:", 6) == 0) {
+            kb = ::strtoull(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    ::fclose(fp);
+    return kb;
+}
+
+static int runServer(uint16_t port, int numThreads, int readyFd) {
+    raiseFileLimit();
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "StormServer");
+    server.setConnectionCallback([](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            conn->send(std::string("!")); // 问候, 客户端据此计算accept延迟
+        }
+    });
+    server.setMessageCallback([](const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+        conn->send(buf);
+    });
+    server.setThreadNum(numThreads);
+    server.start();
+    char ready = 1;
+    if (::write(readyFd, &ready, 1) != 1) {
+        return 1;
+    }
+    ::close(readyFd);
+    loop.loop();
+    return 0;
+}
+
+// 启动服务端子进程, 等到它开始accept
+static pid_t spawnServer(uint16_t port, int numThreads) {
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+    ::fcntl(fds[1], F_SETFD, 0); // 只有写端留给子进程
+    std::string portArg = std::to_string(port);
+    std::string threadsArg = std::to_string(numThreads);
+    std::string fdArg = std::to_string(fds[1]);
+    const char *argv[] = {"/proc/self/exe", "serve", portArg.c_str(), threadsArg.c_str(), fdArg.c_str(), nullptr};
+    pid_t pid;
+    if (::posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, const_cast<char **>(argv), environ) != 0) {
+        perror("posix_spawn");
+        exit(1);
+    }
+    ::close(fds[1]);
+    char ready;
+    if (::read(fds[0], &ready, 1) != 1) {
+        fprintf(stderr, "server %d exited before ready\n", pid);
+        exit(1);
+    }
+    ::close(fds[0]);
+    return pid;
+}
+
+struct Options {
+    InetAddress serverAddr;
+    pid_t serverPid = 0; // 0表示不采样服务端内存
+    int connections = 10000;
+    int rate = 5000; // 每秒新建连接数
+    int holdSeconds = 5;
+    bool chatty = false;
+    int sourceIps = 4; // 0表示不绑定源地址
+    int threads = 1;
+};
+
+struct Session {
+    std::unique_ptr<TcpClient> client;
+    TcpConnectionPtr conn; // 已建立的连接, chatty模式下用来发送
+    int64_t startedAt = 0;
+    bool greeted = false;
+};
+
+// 一个客户端线程: 一个loop和若干连接, 计数器和直方图只由该loop线程写, 主线程每秒读取
+struct Worker {
+    int target = 0; // 本线程要建立的连接数
+    int sourceIpOffset = 0;
+    EventLoop *loop = nullptr;
+    bool stopping = false;
+    int open = 0; // 当前未关闭的连接数, 只在loop线程中访问
+    std::vector<std::unique_ptr<Session>> sessions; // 只在loop线程中访问
+
+    LoopCounter started; // 已开始connect的连接数
+    LoopCounter established;
+    LoopCounter greeted;
+    LoopCounter closedEarly; // 建立后在停止前被关闭
+    LatencyHistogram connectLatency; // 开始connect到连接建立
+    LatencyHistogram acceptLatency; // 开始connect到收到问候
+};
+
+static void openOne(const Options &options, Worker *worker) {
+    int index = static_cast<int>(worker->sessions.size());
+    worker->sessions.emplace_back(new Session);
+    Session *session = worker->sessions.back().get();
+    session->client.reset(new TcpClient(worker->loop, options.serverAddr, "StormClient"));
+    if (options.sourceIps > 0) {
+        int host = 2 + (worker->sourceIpOffset + index) % options.sourceIps;
+        session->client->setLocalAddress(InetAddress(0, "127.0.0." + std::to_string(host)));
+    }
+    session->client->setConnectionCallback([worker, session](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            ++worker->open;
+            session->conn = conn;
+            worker->established.add(1);
+            worker->connectLatency.record(LatencyHistogram::now() - session->startedAt);
+        } else {
+            session->conn.reset();
+            if (!worker->stopping) {
+                worker->closedEarly.add(1);
+            }
+            if (--worker->open == 0 && worker->stopping) {
+                worker->loop->quit();
+            }
+        }
+    });
+    session->client->setMessageCallback([worker, session](const TcpConnectionPtr &, Buffer *buf, Timestamp) {
+        buf->retrieveAll();
+        if (!session->greeted) {
+            session->greeted = true;
+            worker->greeted.add(1);
+            worker->acceptLatency.record(LatencyHistogram::now() - session->startedAt);
+        }
+    });
+    session->startedAt = LatencyHistogram::now();
+    worker->started.add(1);
+    session->client->connect();
+}
+
+static void runWorker(const Options &options, Worker *worker, std::atomic<int> *ready) {
+    EventLoop loop;
+    worker->loop = &loop;
+    worker->sessions.reserve(worker->target);
+
+    // 每个节拍按速率补足应新建的连接, 小数部分累积到下一个节拍
+    double perTick = static_cast<double>(options.rate) / options.threads * kTickSeconds;
+    double credit = 0;
+    loop.runEvery(kTickSeconds, [&]() {
+        if (worker->stopping) {
+            return;
+        }
+        credit += perTick;
+        while (credit >= 1 && static_cast<int>(worker->sessions.size()) < worker->target) {
+            openOne(options, worker);
+            credit -= 1;
+        }
+    });
+    if (options.chatty) {
+        std::string message(kChatSize, 'x');
+        loop.runEvery(kChatInterval, [worker, message]() {
+            if (worker->stopping) {
+                return;
+            }
+            for (auto &session : worker->sessions) {
+                if (session->conn) {
+                    session->conn->send(message);
+                }
+            }
+        });
+    }
+    ready->fetch_add(1);
+    loop.loop();
+    worker->sessions.clear(); // loop已退出, 未关闭的连接直接强制关闭
+}
+
+// 在loop线程中调用: 各连接半关闭, 服务端关闭后loop退出; 超时则直接退出
+static void stopWorker(Worker *worker) {
+    worker->stopping = true;
+    if (worker->open == 0) {
+        worker->loop->quit();
+        return;
+    }
+    for (auto &session : worker->sessions) {
+        session->client->disconnect();
+    }
+    EventLoop *loop = worker->loop;
+    loop->runAfter(kCloseTimeoutSeconds, [loop]() { loop->quit(); });
+}
+
+static void summarize(const char *label, const LatencyHistogram::Snapshot &h, char *out, size_t len) {
+    snprintf(out, len, "%s_p50_ms=%.2f %s_p99_ms=%.2f %s_max_ms=%.2f", label, h.percentile(0.5) / 1e6, label,
+             h.percentile(0.99) / 1e6, label, h.max / 1e6);
+}
+
+// 本秒的直方图: 累计快照减去上一秒的累计快照, max取不到区间值, 用区间内最高的非空桶上界代替
+static LatencyHistogram::Snapshot interval(const LatencyHistogram::Snapshot &now,
+                                           const LatencyHistogram::Snapshot &prev) {
+    LatencyHistogram::Snapshot d;
+    if (now.counts.empty()) {
+        return d;
+    }
+    d.counts = now.counts;
+    for (size_t i = 0; i < prev.counts.size(); ++i) {
+        d.counts[i] -= prev.counts[i];
+    }
+    d.count = now.count - prev.count;
+    d.sum = now.sum - prev.sum;
+    for (int i = LatencyHistogram::kNumBuckets - 1; i >= 0; --i) {
+        if (d.counts[i] != 0) {
+            d.max = std::min(LatencyHistogram::bucketUpperBound(i), now.max);
+            break;
+        }
+    }
+    return d;
+}
+
+static void runStorm(const Options &options) {
+    rlim_t limit = raiseFileLimit();
+    if (static_cast<rlim_t>(options.connections) + 64 > limit) {
+        fprintf(stderr, "connections=%d exceeds RLIMIT_NOFILE=%lu, lower it or raise the limit\n",
+                options.connections, static_cast<unsigned long>(limit));
+        exit(1);
+    }
+
+    uint64_t serverBaseKb = options.serverPid > 0 ? readRssKb(options.serverPid) : 0;
+    uint64_t clientBaseKb = readRssKb(0);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<int> ready(0);
+    for (int i = 0; i < options.threads; ++i) {
+        workers.emplace_back(new Worker);
+        Worker *worker = workers.back().get();
+        worker->target = options.connections / options.threads + (i < options.connections % options.threads ? 1 : 0);
+        worker->sourceIpOffset = i;
+        threads.emplace_back(runWorker, std::cref(options), worker, &ready);
+    }
+    while (ready.load() < options.threads) {
+        std::this_thread::yield();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int rampLimit = options.connections / std::max(options.rate, 1) + 1 + kEstablishGraceSeconds;
+    int holdUntil = -1; // 建满(或放弃)后再保持holdSeconds秒
+    uint64_t lastGreeted = 0;
+    LatencyHistogram::Snapshot lastAccept;
+    LatencyHistogram::Snapshot accept, connect;
+    uint64_t started = 0, established = 0, greeted = 0, closedEarly = 0;
+    for (int t = 1; holdUntil < 0 || t <= holdUntil; ++t) {
+        std::this_thread::sleep_until(start + std::chrono::seconds(t));
+        started = established = greeted = closedEarly = 0;
+        accept = LatencyHistogram::Snapshot();
+        connect = LatencyHistogram::Snapshot();
+        for (auto &worker : workers) {
+            started += worker->started.get();
+            established += worker->established.get();
+            greeted += worker->greeted.get();
+            closedEarly += worker->closedEarly.get();
+            accept += worker->acceptLatency.snapshot();
+            connect += worker->connectLatency.snapshot();
+        }
+        LatencyHistogram::Snapshot recent = interval(accept, lastAccept);
+        lastAccept = accept;
+
+        uint64_t serverKb = options.serverPid > 0 ? readRssKb(options.serverPid) : 0;
+        uint64_t clientKb = readRssKb(0);
+        uint64_t open = greeted - std::min(greeted, closedEarly);
+        char latency[192];
+        summarize("accept", recent, latency, sizeof latency);
+        printf("bench=storm t=%d started=%lu established=%lu greeted=%lu rate_per_s=%lu %s "
+               "server_rss_mb=%.1f server_bytes_per_conn=%.0f client_bytes_per_conn=%.0f closed_early=%lu\n",
+               t, static_cast<unsigned long>(started), static_cast<unsigned long>(established),
+               static_cast<unsigned long>(greeted), static_cast<unsigned long>(greeted - lastGreeted), latency,
+               serverKb / 1024.0, open ? (static_cast<double>(serverKb) - serverBaseKb) * 1024 / open : 0.0,
+               open ? (static_cast<double>(clientKb) - clientBaseKb) * 1024 / open : 0.0,
+               static_cast<unsigned long>(closedEarly));
+        fflush(stdout);
+        lastGreeted = greeted;
+
+        if (holdUntil < 0 && (greeted >= static_cast<uint64_t>(options.connections) || t >= rampLimit)) {
+            holdUntil = t + options.holdSeconds;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto &worker : workers) {
+        Worker *w = worker.get();
+        w->loop->runInLoop([w]() { stopWorker(w); });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    uint64_t serverKb = options.serverPid > 0 ? readRssKb(options.serverPid) : 0;
+    char acceptText[192], connectText[192];
+    summarize("accept", accept, acceptText, sizeof acceptText);
+    summarize("connect", connect, connectText, sizeof connectText);
+    printf("bench=storm_summary connections=%d target_rate=%d mode=%s source_ips=%d client_threads=%d "
+           "greeted=%lu closed_early=%lu seconds=%.1f %s %s server_rss_mb=%.1f\n",
+           options.connections, options.rate, options.chatty ? "chatty" : "idle", options.sourceIps,
+           options.threads, static_cast<unsigned long>(greeted), static_cast<unsigned long>(closedEarly),
+           seconds, acceptText, connectText, serverKb / 1024.0);
+}
+
+// 从argv[first]开始依次解析连接数、速率、保持秒数、模式、源IP数、客户端线程数
+static int parseOptions(int argc, char *argv[], int first, Options *options) {
+    int i = first;
+    if (argc > i) options->connections = atoi(argv[i]);
+    if (argc > ++i) options->rate = atoi(argv[i]);
+    if (argc > ++i) options->holdSeconds = atoi(argv[i]);
+    if (argc > ++i) options->chatty = ::strcmp(argv[i], "chatty") == 0;
+    if (argc > ++i) options->sourceIps = atoi(argv[i]);
+    if (argc > ++i) options->threads = std::max(atoi(argv[i]), 1);
+    return ++i;
+}
+
+int main(int argc, char *argv[]) {
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    if (argc > 1 && ::strcmp(argv[1], "serve") == 0) {
+        if (argc < 5) {
+            return 1;
+        }
+        return runServer(static_cast<uint16_t>(atoi(argv[2])), atoi(argv[3]), atoi(argv[4]));
+    }
+
+    Options options;
+    if (argc > 1 && ::strcmp(argv[1], "client") == 0) {
+        if (argc < 5) {
+            fprintf(stderr, "usage: storm_bench client <ip> <port> <server_pid|0> [connections] [rate] "
+                            "[hold_seconds] [idle|chatty] [source_ips] [threads]\n");
+            return 1;
+        }
+        options.serverAddr = InetAddress(static_cast<uint16_t>(atoi(argv[3])), argv[2]);
+        options.serverPid = atoi(argv[4]);
+        parseOptions(argc, argv, 5, &options);
+        if (::strncmp(argv[2], "127.", 4) != 0) {
+            options.sourceIps = 0; // 多源IP只用于loopback
+        }
+        runStorm(options);
+        return 0;
+    }
+
+    int next = parseOptions(argc, argv, 1, &options);
+    int serverThreads = argc > next ? atoi(argv[next]) : 1;
+    options.serverAddr = InetAddress(kDefaultPort);
+    options.serverPid = spawnServer(kDefaultPort, serverThreads);
+    runStorm(options);
+    ::kill(options.serverPid, SIGTERM);
+    ::waitpid(options.serverPid, nullptr, 0);
+    return 0;
+}
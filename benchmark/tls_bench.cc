@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <openssl/ssl.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+#include "TcpServer.h"
+#include "TlsContext.h"
+#include "TlsStream.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+/**
+ * TLS的握手速率和吞吐压测, 服务端为TcpServer回显, 客户端为阻塞socket上的OpenSSL
+ * handshake: 每个客户端线程循环 建连 -> 完整握手(无会话复用) -> 回显1字节 -> 关闭, 与明文建连对比
+ * throughput: 每个客户端一个连接, 循环发送msg_size字节并读回, 对比明文、用户态TLS和kTLS
+ * 证书为启动时生成的自签名P-256证书; cpu为整个进程(客户端+服务端)的CPU时间
+ * 用法: tls_bench [客户端线程数] [秒数] [subloop数] [吞吐测试的消息字节数]
+**/
+
+static void onEcho(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    conn->send(buf);
+}
+
+static double cpuSeconds() {
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static std::string bioToString(BIO *bio) {
+    char *data = nullptr;
+    long len = BIO_get_mem_data(bio, &data);
+    return std::string(data, len);
+}
+
+// 生成自签名证书
+static void makeCertificate(std::string *certPem, std::string *keyPem) {
+    EVP_PKEY *key = nullptr;
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+    EVP_PKEY_keygen_init(pctx);
+    EVP_PKEY_CTX_set_ec_paramgen_curve_nid(pctx, NID_X9_62_prime256v1);
+    EVP_PKEY_keygen(pctx, &key);
+    EVP_PKEY_CTX_free(pctx);
+
+    X509 *cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 86400);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    X509_sign(cert, key, EVP_sha256());
+
+    BIO *bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(bio, cert);
+    *certPem = bioToString(bio);
+    BIO_free(bio);
+    bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PrivateKey(bio, key, nullptr, nullptr, 0, nullptr, nullptr);
+    *keyPem = bioToString(bio);
+    BIO_free(bio);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+}
+
+static int connectTo(const InetAddress &addr) {
+    int fd = ::socket(addr.family(), SOCK_STREAM, 0);
+    if (::connect(fd, addr.getSockAddr(), addr.getSockLen()) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    return fd;
+}
+
+static bool readFull(SSL *ssl, int fd, char *buf, size_t len) {
+    size_t got = 0;
+    while (got < len) {
+        int n = ssl ? SSL_read(ssl, buf + got, static_cast<int>(len - got))
+                    : static_cast<int>(::read(fd, buf + got, len - got));
+        if (n <= 0) {
+            return false;
+        }
+        got += n;
+    }
+    return true;
+}
+
+// TlsContext开启了部分写, SSL_write可能只发送一部分
+static bool writeFull(SSL *ssl, int fd, const char *buf, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        int n = ssl ? SSL_write(ssl, buf + sent, static_cast<int>(len - sent))
+                    : static_cast<int>(::write(fd, buf + sent, len - sent));
+        if (n <= 0) {
+            return false;
+        }
+        sent += n;
+    }
+    return true;
+}
+
+// 一次握手: 建连, 握手, 回显1字节后关闭
+static void runHandshakeClient(const InetAddress &addr, SSL_CTX *ctx, const std::atomic<bool> &stop,
+                               std::atomic<uint64_t> *count) {
+    uint64_t n = 0;
+    char c = 'x';
+    while (!stop.load(std::memory_order_relaxed)) {
+        int fd = connectTo(addr);
+        SSL *ssl = nullptr;
+        if (ctx) {
+            ssl = SSL_new(ctx);
+            SSL_set_fd(ssl, fd);
+            if (SSL_connect(ssl) != 1) {
+                fprintf(stderr, "SSL_connect fail\n");
+                exit(1);
+            }
+        }
+        if (!writeFull(ssl, fd, &c, 1) || !readFull(ssl, fd, &c, 1)) {
+            fprintf(stderr, "echo fail\n");
+            exit(1);
+        }
+        if (ssl) {
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+        }
+        ::close(fd);
+        ++n;
+    }
+    count->fetch_add(n);
+}
+
+static void runThroughputClient(const InetAddress &addr, SSL_CTX *ctx, size_t msgSize,
+                                const std::atomic<bool> &stop, std::atomic<uint64_t> *bytes) {
+    int fd = connectTo(addr);
+    SSL *ssl = nullptr;
+    if (ctx) {
+        ssl = SSL_new(ctx);
+        SSL_set_fd(ssl, fd);
+        if (SSL_connect(ssl) != 1) {
+            fprintf(stderr, "SSL_connect fail\n");
+            exit(1);
+        }
+    }
+    std::string message(msgSize, 'x');
+    std::vector<char> reply(msgSize);
+    uint64_t n = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        if (!writeFull(ssl, fd, message.data(), msgSize) || !readFull(ssl, fd, reply.data(), msgSize)) {
+            fprintf(stderr, "echo fail after %lu bytes\n", static_cast<unsigned long>(n));
+            exit(1);
+        }
+        n += msgSize;
+    }
+    if (ssl) {
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+    }
+    ::close(fd);
+    bytes->fetch_add(n);
+}
+
+// mode: handshake/throughput; transport: plain/tls/ktls
+static void runCase(const char *mode, const char *transport, uint16_t port, int numClients, int seconds,
+                    int numThreads, size_t msgSize, const std::string &certPem, const std::string &keyPem) {
+    bool tls = ::strcmp(transport, "plain") != 0;
+    bool ktls = ::strcmp(transport, "ktls") == 0;
+    bool handshake = ::strcmp(mode, "handshake") == 0;
+
+    std::shared_ptr<TlsContext> serverContext;
+    if (tls) {
+        serverContext = std::make_shared<TlsContext>(TlsContext::kServer);
+        serverContext->useCertificate(certPem, keyPem);
+        serverContext->setKtls(ktls);
+    }
+    TlsContext clientContext(TlsContext::kClient);
+    clientContext.setKtls(ktls);
+
+    EventLoop loop;
+    InetAddress addr(port);
+    TcpServer server(&loop, addr, "TlsBench");
+    std::atomic<int> ktlsSend(0);
+    server.setConnectionCallback([&ktlsSend](const TcpConnectionPtr &conn) {
+        if (conn->connected() && conn->tlsStream() && conn->tlsStream()->ktlsSend()) {
+            ktlsSend = 1;
+        }
+    });
+    server.setMessageCallback(onEcho);
+    if (tls) {
+        server.setTlsContext(serverContext);
+    }
+    server.setThreadNum(numThreads);
+    server.start();
+
+    std::atomic<uint64_t> count(0);
+    double elapsed = 0;
+    double cpu = 0;
+    std::thread driver([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 等待开始监听
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> clients;
+        SSL_CTX *ctx = tls ? clientContext.nativeHandle() : nullptr;
+        double cpuStart = cpuSeconds();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numClients; ++i) {
+            if (handshake) {
+                clients.emplace_back(runHandshakeClient, std::cref(addr), ctx, std::cref(stop), &count);
+            } else {
+                clients.emplace_back(runThroughputClient, std::cref(addr), ctx, msgSize, std::cref(stop), &count);
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        stop = true;
+        for (auto &t : clients) {
+            t.join();
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        cpu = cpuSeconds() - cpuStart;
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+
+    if (handshake) {
+        printf("bench=tls mode=handshake transport=%s clients=%d loops=%d handshakes=%lu "
+               "handshakes_per_s=%.0f cpu_us_per_handshake=%.1f\n",
+               transport, numClients, numThreads, static_cast<unsigned long>(count.load()),
+               count / elapsed, count ? cpu * 1e6 / count : 0.0);
+    } else {
+        double mb = count / 1e6;
+        printf("bench=tls mode=throughput transport=%s ktls_send=%d clients=%d loops=%d msg_size=%zu "
+               "echoed_mb=%.0f mb_per_s=%.1f cpu_ms_per_mb=%.3f\n",
+               transport, ktlsSend.load(), numClients, numThreads, msgSize, mb, mb / elapsed,
+               mb > 0 ? cpu * 1e3 / mb : 0.0);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int numClients = argc > 1 ? atoi(argv[1]) : 4;
+    int seconds = argc > 2 ? atoi(argv[2]) : 2;
+    int numThreads = argc > 3 ? atoi(argv[3]) : 2;
+    size_t msgSize = argc > 4 ? static_cast<size_t>(atoi(argv[4])) : 64 * 1024;
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+    std::string certPem, keyPem;
+    makeCertificate(&certPem, &keyPem);
+    printf("bench=tls kernel_ktls=%d\n", TlsContext::kernelSupportsKtls());
+
+    uint16_t port = 9970;
+    runCase("handshake", "plain", port++, numClients, seconds, numThreads, msgSize, certPem, keyPem);
+    runCase("handshake", "tls", port++, numClients, seconds, numThreads, msgSize, certPem, keyPem);
+    runCase("throughput", "plain", port++, numClients, seconds, numThreads, msgSize, certPem, keyPem);
+    runCase("throughput", "tls", port++, numClients, seconds, numThreads, msgSize, certPem, keyPem);
+    runCase("throughput", "ktls", port++, numClients, seconds, numThreads, msgSize, certPem, keyPem);
+    return 0;
+}
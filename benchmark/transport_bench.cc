@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+/**
+ * 同一台机器上不同传输方式的对比: IPv4 loopback TCP、IPv6 loopback TCP、Unix域socket
+ * 服务端为TcpServer回显, 每个客户端线程持有一个阻塞连接做ping-pong(一次一个消息)
+ * 输出往返延迟分位数、消息速率, 以及整个进程(客户端+服务端)每条消息消耗的CPU时间
+ * 用法: transport_bench [客户端连接数] [秒数] [subloop数] [消息字节数]
+**/
+
+static void onEcho(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    conn->send(buf);
+}
+
+static double cpuSeconds() {
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct ClientResult {
+    uint64_t messages = 0;
+    std::vector<double> rttMicros;
+};
+
+static void runClient(const InetAddress &addr, size_t msgSize, const std::atomic<bool> &stop,
+                      ClientResult *result) {
+    int fd = ::socket(addr.family(), SOCK_STREAM, 0);
+    if (::connect(fd, addr.getSockAddr(), addr.getSockLen()) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    if (!addr.isUnix()) {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    }
+    std::string message(msgSize, 'x');
+    std::vector<char> reply(msgSize);
+    while (!stop.load(std::memory_order_relaxed)) {
+        auto start = std::chrono::steady_clock::now();
+        if (::write(fd, message.data(), msgSize) != static_cast<ssize_t>(msgSize)) {
+            perror("write");
+            break;
+        }
+        size_t got = 0;
+        while (got < msgSize) {
+            ssize_t n = ::read(fd, reply.data() + got, msgSize - got);
+            if (n <= 0) {
+                perror("read");
+                exit(1);
+            }
+            got += n;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        result->rttMicros.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+        ++result->messages;
+    }
+    ::close(fd);
+}
+
+static void runCase(const char *transport, const InetAddress &addr, int numClients, int seconds,
+                    int numThreads, size_t msgSize) {
+    EventLoop loop;
+    TcpServer server(&loop, addr, "TransportBench");
+    server.setMessageCallback(onEcho);
+    server.setThreadNum(numThreads);
+    server.start();
+
+    std::vector<ClientResult> results(numClients);
+    double elapsed = 0;
+    double cpu = 0;
+    std::thread driver([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 等待开始监听
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> clients;
+        double cpuStart = cpuSeconds();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numClients; ++i) {
+            clients.emplace_back(runClient, std::cref(addr), msgSize, std::cref(stop), &results[i]);
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        stop = true;
+        for (auto &t : clients) {
+            t.join();
+        }
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        cpu = cpuSeconds() - cpuStart;
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+
+    uint64_t messages = 0;
+    std::vector<double> latencies;
+    for (ClientResult &r : results) {
+        messages += r.messages;
+        latencies.insert(latencies.end(), r.rttMicros.begin(), r.rttMicros.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+    printf("bench=transport transport=%s clients=%d loops=%d msg_size=%zu messages=%lu msgs_per_s=%.0f "
+           "rtt_p50_us=%.1f rtt_p99_us=%.1f cpu_us_per_msg=%.2f\n",
+           transport, numClients, numThreads, msgSize, static_cast<unsigned long>(messages),
+           messages / elapsed, percentile(0.5), percentile(0.99),
+           messages ? cpu * 1e6 / messages : 0.0);
+}
+
+int main(int argc, char *argv[]) {
+    int numClients = argc > 1 ? atoi(argv[1]) : 4;
+    int seconds = argc > 2 ? atoi(argv[2]) : 2;
+    int numThreads = argc > 3 ? atoi(argv[3]) : 2;
+    size_t msgSize = argc > 4 ? static_cast<size_t>(atoi(argv[4])) : 64;
+
+    Logger::setInfoEnabled(false);
+    runCase("tcp4", InetAddress(9983), numClients, seconds, numThreads, msgSize);
+    runCase("tcp6", InetAddress(9982, "::1"), numClients, seconds, numThreads, msgSize);
+    runCase("unix", InetAddress::unixPath("@muduo-transport-bench"), numClients, seconds, numThreads, msgSize);
+    return 0;
+}
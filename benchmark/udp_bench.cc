@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "UdpServer.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+/**
+ * UdpServer的收发包速率压测, 服务端和客户端在同一进程中
+ * 每个客户端线程一个socket(不同的源端口, 由SO_REUSEPORT分散到各个subloop), 用sendmmsg批量发送
+ * sink: 服务端只计数; echo: 服务端原样回复, 回复经sendmmsg+GSO批量发送
+ * 每种模式分别测试客户端逐包发送(服务端不开GRO)和客户端GSO发送(服务端开GRO)
+ * 用法: udp_bench [客户端线程数] [秒数] [subloop数] [数据报字节数]
+**/
+
+static const int kClientBatch = 64;
+
+// 客户端: 循环发送一批数据报, echo模式下顺便读走回复
+static void runClient(uint16_t port, size_t payload, bool gso, bool drainReplies,
+                      const std::atomic<bool> &stop, std::atomic<uint64_t> *sent) {
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    ::memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::connect(fd, (const sockaddr *)&addr, sizeof addr);
+    int bufSize = 4 * 1024 * 1024;
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufSize, sizeof bufSize);
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufSize, sizeof bufSize);
+
+    std::string data(payload * kClientBatch, 'x');
+    std::vector<mmsghdr> msgs(kClientBatch);
+    std::vector<iovec> iovs(kClientBatch);
+    int numMsgs = kClientBatch;
+    int datagramsPerMsg = 1;
+    if (gso) {
+        // 整批数据报作为一条消息, 由内核按payload分段
+#ifdef UDP_SEGMENT
+        int segment = static_cast<int>(payload);
+        ::setsockopt(fd, SOL_UDP, UDP_SEGMENT, &segment, sizeof segment);
+#endif
+        numMsgs = 1;
+        datagramsPerMsg = static_cast<int>(std::min<size_t>(kClientBatch, 65000 / payload));
+    }
+    for (int i = 0; i < numMsgs; ++i) {
+        ::memset(&msgs[i], 0, sizeof msgs[i]);
+        iovs[i].iov_base = &data[i * payload];
+        iovs[i].iov_len = payload * datagramsPerMsg;
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    std::vector<char> replyBuf(65536 * 8);
+    std::vector<mmsghdr> replies(8);
+    std::vector<iovec> replyIovs(8);
+    for (int i = 0; i < 8; ++i) {
+        ::memset(&replies[i], 0, sizeof replies[i]);
+        replyIovs[i].iov_base = &replyBuf[i * 65536];
+        replyIovs[i].iov_len = 65536;
+        replies[i].msg_hdr.msg_iov = &replyIovs[i];
+        replies[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    uint64_t count = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        int n = ::sendmmsg(fd, msgs.data(), numMsgs, 0);
+        if (n > 0) {
+            count += static_cast<uint64_t>(n) * datagramsPerMsg;
+        }
+        if (drainReplies) {
+            while (::recvmmsg(fd, replies.data(), 8, MSG_DONTWAIT, nullptr) > 0) {
+            }
+        }
+    }
+    sent->fetch_add(count);
+    ::close(fd);
+}
+
+static void runCase(const char *mode, uint16_t port, int numClients, int seconds, int numThreads,
+                    size_t payload, bool gso) {
+    EventLoop loop;
+    UdpServer server(&loop, InetAddress(port), "UdpBench");
+    UdpSocket::Options options;
+    options.gro = gso;
+    options.socketBufferBytes = 8 * 1024 * 1024;
+    server.setOptions(options);
+    bool echo = ::strcmp(mode, "echo") == 0;
+    if (echo) {
+        server.setDatagramCallback([](UdpSocket *socket, const UdpDatagram *datagrams, size_t count, Timestamp) {
+            for (size_t i = 0; i < count; ++i) {
+                socket->send(datagrams[i].peer, datagrams[i].data);
+            }
+        });
+    }
+    server.setThreadNum(numThreads);
+    server.start();
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> sent(0);
+    std::thread driver([&]() {
+        std::vector<std::thread> clients;
+        for (int i = 0; i < numClients; ++i) {
+            clients.emplace_back(runClient, port, payload, gso, echo, std::cref(stop), &sent);
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(seconds));
+        stop = true;
+        for (auto &t : clients) {
+            t.join();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 等待服务端读完
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+
+    UdpSocket::Stats stats = server.stats();
+    printf("bench=udp mode=%s client_gso=%d server_gro=%d clients=%d loops=%d payload=%zu "
+           "sent=%lu received=%lu rx_pps=%.0f rx_per_recvmmsg=%.1f echoed=%lu tx_per_sendmmsg=%.1f send_drops=%lu\n",
+           mode, gso, gso, numClients, numThreads, payload,
+           static_cast<unsigned long>(sent.load()), static_cast<unsigned long>(stats.datagramsReceived),
+           stats.datagramsReceived / static_cast<double>(seconds),
+           stats.recvCalls ? static_cast<double>(stats.datagramsReceived) / stats.recvCalls : 0.0,
+           static_cast<unsigned long>(stats.datagramsSent),
+           stats.sendCalls ? static_cast<double>(stats.datagramsSent) / stats.sendCalls : 0.0,
+           static_cast<unsigned long>(stats.sendDrops));
+}
+
+int main(int argc, char *argv[]) {
+    int numClients = argc > 1 ? atoi(argv[1]) : 4;
+    int seconds = argc > 2 ? atoi(argv[2]) : 2;
+    int numThreads = argc > 3 ? atoi(argv[3]) : 2;
+    size_t payload = argc > 4 ? static_cast<size_t>(atoi(argv[4])) : 256;
+
+    Logger::setInfoEnabled(false);
+    runCase("sink", 9985, numClients, seconds, numThreads, payload, false);
+    runCase("sink", 9986, numClients, seconds, numThreads, payload, true);
+    runCase("echo", 9987, numClients, seconds, numThreads, payload, false);
+    runCase("echo", 9988, numClients, seconds, numThreads, payload, true);
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+
+/**
+ * 跨线程发送压测: 若干工作线程对服务端连接调用send发送小消息, 客户端统计收到的字节数
+ * 输出消息速率, 以及服务端loop每条消息执行的functor数、被唤醒次数和写系统调用次数
+ * 用法: xsend_bench [连接数] [工作线程数] [每线程消息数] [消息字节数]
+**/
+
+static const uint16_t kPort = 9966;
+
+int main(int argc, char *argv[]) {
+    int numConnections = argc > 1 ? atoi(argv[1]) : 16;
+    int numWorkers = argc > 2 ? atoi(argv[2]) : 2;
+    int messagesPerWorker = argc > 3 ? atoi(argv[3]) : 500000;
+    size_t messageSize = static_cast<size_t>(argc > 4 ? atoi(argv[4]) : 32);
+
+    Logger::setInfoEnabled(false);
+    ::signal(SIGPIPE, SIG_IGN);
+
+    EventLoopThread serverThread;
+    EventLoop *serverLoop = serverThread.startLoop();
+    std::mutex mutex;
+    std::vector<TcpConnectionPtr> serverConns;
+    TcpServer server(serverLoop, InetAddress(kPort), "XSendServer");
+    server.setConnectionCallback([&](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            serverConns.push_back(conn);
+        }
+    });
+    server.setThreadNum(1);
+    std::promise<void> listening; // 开始监听后客户端再发起连接
+    serverLoop->runInLoop([&]() {
+        server.start();
+        listening.set_value();
+    });
+    listening.get_future().wait();
+
+    // 客户端只统计收到的字节数
+    EventLoopThread clientThread;
+    EventLoop *clientLoop = clientThread.startLoop();
+    std::atomic<uint64_t> received(0);
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for (int i = 0; i < numConnections; ++i) {
+        clients.emplace_back(new TcpClient(clientLoop, InetAddress(kPort), "XSendClient"));
+        clients.back()->setMessageCallback([&received](const TcpConnectionPtr &, Buffer *buf, Timestamp) {
+            received.fetch_add(buf->readableBytes(), std::memory_order_relaxed);
+            buf->retrieveAll();
+        });
+        clients.back()->connect();
+    }
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (static_cast<int>(serverConns.size()) == numConnections) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    LoopStats before;
+    for (const LoopStats &stats : server.loopStats()) before += stats;
+
+    const std::string message(messageSize, 'x');
+    uint64_t total = static_cast<uint64_t>(numWorkers) * messagesPerWorker;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int w = 0; w < numWorkers; ++w) {
+        workers.emplace_back([&, w]() {
+            for (int i = 0; i < messagesPerWorker; ++i) {
+                serverConns[(w + i) % numConnections]->send(message);
+            }
+        });
+    }
+    for (auto &t : workers) {
+        t.join();
+    }
+    while (received.load(std::memory_order_relaxed) < total * messageSize
+           && std::chrono::steady_clock::now() - start < std::chrono::seconds(30)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    LoopStats after;
+    for (const LoopStats &stats : server.loopStats()) after += stats;
+    double messages = static_cast<double>(total);
+    printf("bench=xsend connections=%d workers=%d messages=%lu message_size=%zu seconds=%.3f msgs_per_s=%.0f "
+           "complete=%d functors_per_msg=%.4f wakeups_per_msg=%.4f writes_per_msg=%.4f\n",
+           numConnections, numWorkers, static_cast<unsigned long>(total), messageSize, seconds, messages / seconds,
+           received.load() == total * messageSize,
+           (after.functors - before.functors) / messages, (after.wakeups - before.wakeups) / messages,
+           (after.writeCalls - before.writeCalls) / messages);
+
+    // 客户端在自己的loop中析构, 等析构完成再退出
+    std::promise<void> closed;
+    clientLoop->runInLoop([&]() {
+        clients.clear();
+        closed.set_value();
+    });
+    closed.get_future().wait();
+    serverConns.clear();
+    return 0;
+}
@@ -0,0 +1,34 @@
+#include <string>
+
+#include "HttpServer.h"
+#include "MetricsServer.h"
+#include "Logger.h"
+
+// 收到任意请求都返回hello, /echo返回请求体
+static void onRequest(const HttpRequest &req, HttpResponse *resp) {
+    resp->setStatusCode(HttpResponse::k200Ok);
+    resp->setContentType("text/plain");
+    if (req.path() == "/echo") {
+        resp->setBody(req.body());
+    } else {
+        resp->setBody(std::string_view("hello, world\n"));
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int numThreads = argc > 1 ? atoi(argv[1]) : 0;
+    Logger::setInfoEnabled(false);
+
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(8000), "HttpServer");
+    server.setHttpCallback(onRequest);
+    server.setThreadNum(numThreads);
+    server.start();
+
+    // 各loop的运行统计: curl http://127.0.0.1:9100/metrics
+    MetricsServer metrics(&loop, InetAddress(9100));
+    metrics.addServer(&server.tcpServer());
+    metrics.start();
+    loop.loop();
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include <charconv>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "RespServer.h"
+#include "Logger.h"
+
+/**
+ * Redis兼容的内存KV服务器, 作为RESP服务器的示例和压测负载(见benchmark/resp_bench.cc)
+ * 支持 PING ECHO GET SET DEL EXISTS INCR DECR MGET MSET DBSIZE FLUSHALL HELLO COMMAND QUIT
+ * 用法: kvserver [端口] [subloop数]
+**/
+
+class KvStore {
+    public:
+        template <typename Func>
+        void get(std::string_view key, Func &&func) {
+            Shard &shard = shardFor(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.map.find(std::string(key));
+            func(it == shard.map.end() ? nullptr : &it->second);
+        }
+
+        void set(std::string_view key, std::string_view value) {
+            Shard &shard = shardFor(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.map[std::string(key)].assign(value.data(), value.size());
+        }
+
+        bool del(std::string_view key) {
+            Shard &shard = shardFor(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            return shard.map.erase(std::string(key)) > 0;
+        }
+
+        // 值不是整数时返回false
+        bool incr(std::string_view key, int64_t delta, int64_t *result) {
+            Shard &shard = shardFor(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            std::string &value = shard.map[std::string(key)];
+            int64_t n = 0;
+            if (!value.empty()) {
+                auto r = std::from_chars(value.data(), value.data() + value.size(), n);
+                if (r.ec != std::errc() || r.ptr != value.data() + value.size()) {
+                    return false;
+                }
+            }
+            n += delta;
+            value = std::to_string(n);
+            *result = n;
+            return true;
+        }
+
+        size_t size() {
+            size_t n = 0;
+            for (Shard &shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                n += shard.map.size();
+            }
+            return n;
+        }
+
+        void clear() {
+            for (Shard &shard : shards_) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.map.clear();
+            }
+        }
+
+    private:
+        static const size_t kNumShards = 64; // 分段加锁, 减少多个loop之间的竞争
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<std::string, std::string> map;
+        };
+
+        Shard& shardFor(std::string_view key) {
+            return shards_[std::hash<std::string_view>()(key) % kNumShards];
+        }
+
+        Shard shards_[kNumShards];
+};
+
+static KvStore g_store;
+
+static void wrongArity(RespWriter *writer) {
+    writer->error("ERR wrong number of arguments");
+}
+
+static void execute(const RespCommand &cmd, RespWriter *writer) {
+    if (cmd.is("GET")) {
+        if (cmd.argc != 2) return wrongArity(writer);
+        // 持锁期间直接把值编码进输出缓冲区, 不额外拷贝
+        g_store.get(cmd[1], [writer](const std::string *value) {
+            if (value) writer->bulk(*value);
+            else writer->null();
+        });
+    } else if (cmd.is("SET")) {
+        if (cmd.argc != 3) return wrongArity(writer);
+        g_store.set(cmd[1], cmd[2]);
+        writer->ok();
+    } else if (cmd.is("PING")) {
+        if (cmd.argc == 1) writer->simpleString("PONG");
+        else if (cmd.argc == 2) writer->bulk(cmd[1]);
+        else wrongArity(writer);
+    } else if (cmd.is("ECHO")) {
+        if (cmd.argc != 2) return wrongArity(writer);
+        writer->bulk(cmd[1]);
+    } else if (cmd.is("DEL") || cmd.is("EXISTS")) {
+        if (cmd.argc < 2) return wrongArity(writer);
+        bool isDel = cmd.is("DEL");
+        int64_t n = 0;
+        for (size_t i = 1; i < cmd.argc; ++i) {
+            if (isDel) {
+                n += g_store.del(cmd[i]);
+            } else {
+                g_store.get(cmd[i], [&n](const std::string *value) { n += value != nullptr; });
+            }
+        }
+        writer->integer(n);
+    } else if (cmd.is("INCR") || cmd.is("DECR")) {
+        if (cmd.argc != 2) return wrongArity(writer);
+        int64_t result = 0;
+        if (g_store.incr(cmd[1], cmd.is("INCR") ? 1 : -1, &result)) {
+            writer->integer(result);
+        } else {
+            writer->error("ERR value is not an integer or out of range");
+        }
+    } else if (cmd.is("MGET")) {
+        if (cmd.argc < 2) return wrongArity(writer);
+        writer->arrayHeader(cmd.argc - 1);
+        for (size_t i = 1; i < cmd.argc; ++i) {
+            g_store.get(cmd[i], [writer](const std::string *value) {
+                if (value) writer->bulk(*value);
+                else writer->null();
+            });
+        }
+    } else if (cmd.is("MSET")) {
+        if (cmd.argc < 3 || cmd.argc % 2 == 0) return wrongArity(writer);
+        for (size_t i = 1; i < cmd.argc; i += 2) {
+            g_store.set(cmd[i], cmd[i + 1]);
+        }
+        writer->ok();
+    } else if (cmd.is("DBSIZE")) {
+        writer->integer(static_cast<int64_t>(g_store.size()));
+    } else if (cmd.is("FLUSHALL") || cmd.is("FLUSHDB")) {
+        g_store.clear();
+        writer->ok();
+    } else if (cmd.is("HELLO")) {
+        // HELLO [protover], 切换RESP2/RESP3
+        if (cmd.argc >= 2) {
+            if (cmd[1] == "2" || cmd[1] == "3") {
+                writer->setProtocol(cmd[1][0] - '0');
+            } else {
+                writer->error("NOPROTO unsupported protocol version");
+                return;
+            }
+        }
+        writer->mapHeader(3);
+        writer->bulk("server");
+        writer->bulk("muduo-kv");
+        writer->bulk("proto");
+        writer->integer(writer->protocol());
+        writer->bulk("mode");
+        writer->bulk("standalone");
+    } else if (cmd.is("COMMAND")) {
+        writer->arrayHeader(0); // redis-cli启动时会发送
+    } else if (cmd.is("QUIT")) {
+        writer->ok();
+        writer->closeAfterReply();
+    } else {
+        writer->error("ERR unknown command");
+    }
+}
+
+static void onBatch(const TcpConnectionPtr &, const RespCommandBatch &batch, RespWriter *writer) {
+    for (size_t i = 0; i < batch.size(); ++i) {
+        execute(batch[i], writer);
+        if (writer->closeRequested()) {
+            break;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uint16_t port = static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 6380);
+    int numThreads = argc > 2 ? atoi(argv[2]) : 0;
+    Logger::setInfoEnabled(false);
+
+    EventLoop loop;
+    RespServer server(&loop, InetAddress(port), "KvServer");
+    server.setBatchCallback(onBatch);
+    server.setThreadNum(numThreads);
+    server.start();
+    loop.loop();
+    return 0;
+}
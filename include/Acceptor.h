@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <string>
 
 #include "NonCopyable.h"
 #include "Channel.h"
@@ -21,13 +22,25 @@ class Acceptor : NonCopyable {
         bool listenning() const { return listenning_; }
         // 开始监听
         void listen();
+        // 停止accept但不关闭监听socket, 用于把监听socket交给新进程后排空, 在loop线程中调用
+        void stopListening();
+        int fd() const { return acceptSocket_.fd(); }
+
+        // 热重启时从旧进程接管的监听socket, 之后构造的Acceptor按本地地址匹配直接使用, 不再重新绑定
+        static void addInheritedSocket(int sockfd);
+        // 关闭没有被任何Acceptor使用的继承socket, 返回关闭的个数
+        static size_t closeUnusedInheritedSockets();
 
     private:
         void handleRead(); // 处理新用户连接
 
+        static int takeInheritedSocket(const InetAddress &listenaddr);
+
         EventLoop *loop_;  // Acceptor属于mainReactor，监听新连接
+        const int inheritedFd_; // 从旧进程继承的监听socket(已经绑定并处于监听状态), 没有时为-1
         Socket acceptSocket_; // 接收新连接的socket
         Channel acceptChannel_; // 监听新连接的channel
         NewConnectionCallback newConnectionCallback_; // 有新连接到来时的回调
         bool listenning_; // 是否正在监听
+        std::string unixPath_; // 监听文件系统路径的Unix域socket时, 析构时删除该文件
 };
\ No newline at end of file
@@ -2,8 +2,14 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "ByteScan.h"
 
 // 缓冲区类
 class Buffer {
@@ -19,6 +25,7 @@ class Buffer {
     size_t readableBytes() const { return writeIndex_ - readIndex_; } // 可读字节数
     size_t writableBytes() const { return buffer_.size() - writeIndex_; } // 可写字节数
     size_t prependableBytes() const { return readIndex_; } // 可预留字节数
+    size_t internalCapacity() const { return buffer_.capacity(); } // 占用的内存
 
     const char* peek() const { return begin() + readIndex_; } // 返回可读数据的起始位置
     void retrieve(size_t len) {
@@ -51,8 +58,71 @@ class Buffer {
         std::copy(data, data + len, begin() + writeIndex_);
         writeIndex_ += len;
     }
+    void append(const void* data, size_t len) { append(static_cast<const char*>(data), len); }
+
+    char* beginWrite() { return begin() + writeIndex_; } // 返回可写空间的起始位置
+    const char* beginWrite() const { return begin() + writeIndex_; }
+    void hasWritten(size_t len) { writeIndex_ += len; } // 直接写入beginWrite()后, 移动写位置
+
+    // 在可读数据前面插入数据, 一般使用kCheapPrepend预留的空间, 不需要搬移已有数据
+    void prepend(const void* data, size_t len) {
+        if (len > prependableBytes()) {
+            // 预留空间不够: 先保证尾部有len字节, 再把可读数据整体右移len字节
+            ensureWritableBytes(len);
+            std::copy_backward(begin() + readIndex_, begin() + writeIndex_, begin() + writeIndex_ + len);
+            readIndex_ += len;
+            writeIndex_ += len;
+        }
+        readIndex_ -= len;
+        const char* d = static_cast<const char*>(data);
+        std::copy(d, d + len, begin() + readIndex_);
+    }
+
+    // 按网络字节序读写整数
+    void appendInt64(int64_t x) {
+        uint32_t be[2] = { htonl(static_cast<uint32_t>(static_cast<uint64_t>(x) >> 32)),
+                           htonl(static_cast<uint32_t>(x)) };
+        append(be, sizeof be);
+    }
+    void appendInt32(int32_t x) { uint32_t be = htonl(static_cast<uint32_t>(x)); append(&be, sizeof be); }
+    void appendInt16(int16_t x) { uint16_t be = htons(static_cast<uint16_t>(x)); append(&be, sizeof be); }
+    void appendInt8(int8_t x) { append(&x, sizeof x); }
+
+    void prependInt32(int32_t x) { uint32_t be = htonl(static_cast<uint32_t>(x)); prepend(&be, sizeof be); }
+    void prependInt16(int16_t x) { uint16_t be = htons(static_cast<uint16_t>(x)); prepend(&be, sizeof be); }
+    void prependInt8(int8_t x) { prepend(&x, sizeof x); }
+
+    // peekIntXX要求readableBytes()不小于对应的字节数
+    int64_t peekInt64() const {
+        uint32_t be[2];
+        ::memcpy(be, peek(), sizeof be);
+        return static_cast<int64_t>((static_cast<uint64_t>(ntohl(be[0])) << 32) | ntohl(be[1]));
+    }
+    int32_t peekInt32() const { uint32_t be; ::memcpy(&be, peek(), sizeof be); return static_cast<int32_t>(ntohl(be)); }
+    int16_t peekInt16() const { uint16_t be; ::memcpy(&be, peek(), sizeof be); return static_cast<int16_t>(ntohs(be)); }
+    int8_t peekInt8() const { return static_cast<int8_t>(*peek()); }
+
+    int64_t readInt64() { int64_t x = peekInt64(); retrieve(sizeof x); return x; }
+    int32_t readInt32() { int32_t x = peekInt32(); retrieve(sizeof x); return x; }
+    int16_t readInt16() { int16_t x = peekInt16(); retrieve(sizeof x); return x; }
+    int8_t readInt8() { int8_t x = peekInt8(); retrieve(sizeof x); return x; }
+
+    // 在可读数据中查找分隔符, 找不到时返回nullptr; start必须位于[peek(), beginWrite()]之间
+    const char* findCRLF() const { return ByteScan::findCRLF(peek(), beginWrite()); }
+    const char* findCRLF(const char* start) const { return ByteScan::findCRLF(start, beginWrite()); }
+    const char* findEOL() const { return findEOL(peek()); }
+    const char* findEOL(const char* start) const {
+        // glibc的memchr已经是向量化实现
+        const void* eol = ::memchr(start, '\n', beginWrite() - start);
+        return static_cast<const char*>(eol);
+    }
+    // 查找chars中任意一个字符第一次出现的位置
+    const char* findAnyOf(std::string_view chars) const { return findAnyOf(chars, peek()); }
+    const char* findAnyOf(std::string_view chars, const char* start) const {
+        return ByteScan::findAnyOf(start, beginWrite(), chars.data(), chars.size());
+    }
 
-    ssize_t readFd(int fd, int* savedErrno); // 从fd读取数据到缓冲区
+    ssize_t readFd(int fd, int* savedErrno, size_t maxBytes = 0); // 从fd读取数据到缓冲区, 最多读maxBytes字节, 0表示不限制
     ssize_t writeFd(int fd, int* savedErrno); // 将缓冲区数据写入fd
 
     private:
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * 文本协议(按行分割/HTTP/RESP)常用的分隔符查找
+ * x86_64上运行时按CPU能力选择AVX2或SSE2实现, 其他平台使用标量实现
+ * 所有函数在[begin, end)中查找, 找不到时返回nullptr
+**/
+namespace ByteScan {
+
+    // 查找"\r\n", 返回'\r'的位置
+    const char* findCRLF(const char *begin, const char *end);
+    // 查找set中任意一个字符第一次出现的位置, set长度为setLen
+    const char* findAnyOf(const char *begin, const char *end, const char *set, size_t setLen);
+
+    // 当前选用的实现名称: "avx2" / "sse2" / "scalar"
+    const char* implName();
+    // 当前CPU是否支持AVX2
+    bool hasAvx2();
+
+    // 各实现的直接入口, 供压测对比; 当前CPU不支持的实现退化为标量实现
+    const char* findCRLFScalar(const char *begin, const char *end);
+    const char* findCRLFSse2(const char *begin, const char *end);
+    const char* findCRLFAvx2(const char *begin, const char *end);
+    const char* findAnyOfScalar(const char *begin, const char *end, const char *set, size_t setLen);
+    const char* findAnyOfSse2(const char *begin, const char *end, const char *set, size_t setLen);
+    const char* findAnyOfAvx2(const char *begin, const char *end, const char *set, size_t setLen);
+}
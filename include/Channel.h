@@ -33,6 +33,7 @@ class Channel : NonCopyable {
 
         int fd() const { return fd_; }
         int events() const { return events_; }
+        int revents() const { return revents_; }
         void set_revents(int revt) { revents_ = revt; }
 
         // 设置fd相应事件状态
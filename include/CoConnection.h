@@ -0,0 +1,86 @@
+#pragma once
+
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Coroutine.h"
+#include "TcpConnection.h"
+#include "Callbacks.h"
+
+/**
+ * 以协程方式使用TcpConnection: co_await conn.read(n) / readUntil(delim) / write(data)
+ * 协程接管连接的消息回调和写完成回调, 未读取的数据留在连接的输入缓冲区中, 读取时直接从中切出, 不经过中间队列
+ * 读写都在连接所属的loop中完成, 协程在其他loop中发起读写时先转回连接的loop, 恢复也总在连接的loop中
+ * 同一连接同一时刻只能有一个读和一个写在等待
+ * 连接断开时等待中的读返回空串, 写返回false; handler结束时连接仍未断开则关闭写端
+**/
+class CoConnection {
+    private:
+        struct State;
+
+    public:
+        using Handler = std::function<Task<>(CoConnection)>;
+
+        // 返回一个连接回调, 设置给TcpServer或TcpClient: 连接建立后在该连接的loop中启动handler(conn)
+        // handler及其捕获的对象需要比所有连接活得久
+        static ConnectionCallback connectionCallback(Handler handler);
+
+        const TcpConnectionPtr& connection() const;
+        bool connected() const; // 连接断开后为false, 只在连接的loop中使用
+
+        class ReadAwaiter {
+            public:
+                bool await_ready();
+                void await_suspend(std::coroutine_handle<> handle);
+                std::string await_resume() { return std::move(result_); }
+
+            private:
+                friend class CoConnection;
+                ReadAwaiter(State *state, size_t length, std::string delimiter)
+                    : state_(state), length_(length), delimiter_(std::move(delimiter)), scanned_(0) {}
+                bool tryComplete(); // 数据已足够或连接已断开时取出结果, 在连接的loop中调用
+
+                State *state_; // 由协程中的CoConnection保证存活
+                size_t length_; // read(n)的n, readUntil时为0
+                std::string delimiter_; // readUntil的分隔符
+                size_t scanned_; // 输入缓冲区中已查找过的字节数, 新数据到来后从这里继续找
+                std::string result_;
+                std::coroutine_handle<> handle_;
+        };
+
+        class WriteAwaiter {
+            public:
+                bool await_ready();
+                void await_suspend(std::coroutine_handle<> handle);
+                bool await_resume() const { return ok_; }
+
+            private:
+                friend class CoConnection;
+                WriteAwaiter(State *state, std::string_view data) : state_(state), data_(data), ok_(false) {}
+                bool start(); // 写入输出缓冲区并尝试发送, 全部交给内核或连接已断开时返回true
+
+                State *state_;
+                std::string_view data_;
+                bool ok_;
+                std::coroutine_handle<> handle_;
+        };
+
+        // 读取恰好length字节; 连接断开且数据不足时返回空串
+        ReadAwaiter read(size_t length) { return ReadAwaiter(state_.get(), length, std::string()); }
+        // 读取到delimiter为止, 返回的数据包含delimiter; 连接断开时返回空串
+        ReadAwaiter readUntil(std::string delimiter) { return ReadAwaiter(state_.get(), 0, std::move(delimiter)); }
+        // 发送data, 数据全部交给内核后恢复, 返回false表示连接已断开; data在co_await期间需保持有效
+        WriteAwaiter write(std::string_view data) { return WriteAwaiter(state_.get(), data); }
+
+        // 线程安全
+        void shutdown();
+        void forceClose();
+
+    private:
+        explicit CoConnection(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+        std::shared_ptr<State> state_; // 由协程持有, 连接回调中只保存weak_ptr
+};
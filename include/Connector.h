@@ -0,0 +1,59 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "NonCopyable.h"
+#include "InetAddress.h"
+#include "TimerQueue.h"
+
+class Channel;
+class EventLoop;
+
+/**
+ * 主动发起非阻塞连接, 连接建立后把sockfd交给TcpClient
+ * 连接失败时按指数退避重试, 重试间隔从kInitRetryDelayMs增长到kMaxRetryDelayMs
+**/
+class Connector : NonCopyable, public std::enable_shared_from_this<Connector> {
+    public:
+        using NewConnectionCallback = std::function<void(int sockfd)>;
+
+        Connector(EventLoop *loop, const InetAddress &serverAddr);
+        ~Connector();
+
+        void setNewConnectionCallback(const NewConnectionCallback &cb) { newConnectionCallback_ = cb; }
+        const InetAddress& serverAddress() const { return serverAddr_; }
+        // 连接前绑定的本地地址(端口一般为0), 用于指定源IP; 需在start之前调用
+        void setLocalAddress(const InetAddress &localAddr) { localAddr_ = localAddr; bindLocal_ = true; }
+
+        void start(); // 线程安全
+        void restart(); // 在loop线程中调用, 重置重试间隔并重新连接
+        void stop(); // 线程安全
+
+    private:
+        enum States { kDisconnected, kConnecting, kConnected };
+        static const int kMaxRetryDelayMs = 30 * 1000;
+        static const int kInitRetryDelayMs = 500;
+
+        void setState(States s) { state_ = s; }
+        void startInLoop();
+        void stopInLoop();
+        void connect();
+        void connecting(int sockfd); // 等待连接完成(可写事件)
+        void handleWrite();
+        void handleError();
+        void retry(int sockfd);
+        int removeAndResetChannel();
+        void resetChannel();
+
+        EventLoop *loop_;
+        InetAddress serverAddr_;
+        InetAddress localAddr_;
+        bool bindLocal_; // 是否绑定localAddr_
+        bool connect_; // 是否需要连接, stop后为false
+        States state_;
+        std::unique_ptr<Channel> channel_; // 连接过程中监听sockfd的可写事件
+        NewConnectionCallback newConnectionCallback_;
+        int retryDelayMs_;
+        TimerId retryTimer_;
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <coroutine>
+#include <optional>
+#include <utility>
+#include <stddef.h>
+
+#include "EventLoop.h"
+#include "PoolAllocator.h"
+#include "Logger.h"
+
+/**
+ * C++20协程支持, 需要以MUDUO_WITH_COROUTINES编译
+ * Task<T>是惰性启动的协程, 被co_await时才开始执行, 结束后通过对称转移直接恢复等待者, 不经过loop排队
+ * 协程帧按大小分级从BlockPool分配, 同一个协程函数反复调用时复用同一批内存块
+**/
+
+// 协程帧分配器, 按64字节到4KB的2的幂分级, 更大的帧直接走::operator new; 线程安全
+class CoroutineFrameAllocator {
+    public:
+        static const size_t kMinFrameSize = 64;
+        static const int kNumClasses = 7; // 64, 128, ..., 4096
+
+        static void* allocate(size_t size);
+        static void deallocate(void *p, size_t size);
+
+        // 所有分级的统计之和
+        static BlockPool::Stats stats();
+
+    private:
+        static int sizeClass(size_t size); // 超出最大分级返回-1
+};
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+    public:
+        static void* operator new(size_t size) { return CoroutineFrameAllocator::allocate(size); }
+        static void operator delete(void *p, size_t size) { CoroutineFrameAllocator::deallocate(p, size); }
+
+        // 结束时恢复等待者; 没有等待者的独立协程(coSpawn)自行销毁协程帧
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                TaskPromiseBase &promise = handle.promise();
+                if (promise.continuation_) {
+                    return promise.continuation_;
+                }
+                if (promise.detached_) {
+                    handle.destroy();
+                }
+                return std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() {
+            LOG_FATAL("%s:%s:%d unhandled exception in coroutine\n", __FILE__, __FUNCTION__, __LINE__);
+        }
+
+        std::coroutine_handle<> continuation_; // co_await该Task的协程
+        bool detached_ = false;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+    public:
+        Task<T> get_return_object();
+        template <typename U>
+        void return_value(U &&value) { value_.emplace(std::forward<U>(value)); }
+        T takeValue() { return std::move(*value_); }
+
+    private:
+        std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+    public:
+        Task<void> get_return_object();
+        void return_void() const noexcept {}
+        void takeValue() const noexcept {}
+};
+
+} // namespace detail
+
+template <typename T>
+class Task {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+        Task& operator=(Task &&other) noexcept {
+            if (this != &other) {
+                if (handle_) handle_.destroy();
+                handle_ = std::exchange(other.handle_, nullptr);
+            }
+            return *this;
+        }
+        Task(const Task &) = delete;
+        Task& operator=(const Task &) = delete;
+        ~Task() {
+            if (handle_) handle_.destroy();
+        }
+
+        // co_await task: 挂起当前协程, 转去执行task, task结束后恢复当前协程并返回结果
+        struct Awaiter {
+            Handle handle;
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation_ = awaiting;
+                return handle;
+            }
+            T await_resume() { return handle.promise().takeValue(); }
+        };
+        Awaiter operator co_await() && noexcept { return Awaiter{handle_}; }
+
+        // 交出协程帧的所有权, 由coSpawn使用
+        Handle release() { return std::exchange(handle_, nullptr); }
+
+    private:
+        friend class detail::TaskPromise<T>;
+        explicit Task(Handle handle) : handle_(handle) {}
+
+        Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+// 在当前线程中立即启动task, 不等待它结束; task结束后自行释放协程帧
+inline void coSpawn(Task<> task) {
+    Task<>::Handle handle = task.release();
+    handle.promise().detached_ = true;
+    handle.resume();
+}
+
+// 在loop线程中启动task, 线程安全
+inline void coSpawn(EventLoop *loop, Task<> task) {
+    Task<>::Handle handle = task.release();
+    handle.promise().detached_ = true;
+    loop->runInLoop([handle]() { handle.resume(); });
+}
+
+// co_await loop.sleep(seconds): 在loop中定时seconds秒后恢复
+class SleepAwaiter {
+    public:
+        SleepAwaiter(EventLoop *loop, double seconds) : loop_(loop), seconds_(seconds) {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            loop_->runAfter(seconds_, [handle]() { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+
+    private:
+        EventLoop *loop_;
+        double seconds_;
+};
+
+// co_await EventLoop::switchTo(loop): 转到loop线程中继续执行, 已在该线程中时不挂起
+class SwitchAwaiter {
+    public:
+        explicit SwitchAwaiter(EventLoop *loop) : loop_(loop) {}
+
+        bool await_ready() const { return loop_->isInLoopThread(); }
+        void await_suspend(std::coroutine_handle<> handle) {
+            loop_->queueInLoop([handle]() { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+
+    private:
+        EventLoop *loop_;
+};
+
+inline SleepAwaiter EventLoop::sleep(double seconds) {
+    return SleepAwaiter(this, seconds);
+}
+
+inline SwitchAwaiter EventLoop::switchTo(EventLoop *loop) {
+    return SwitchAwaiter(loop);
+}
@@ -9,13 +9,24 @@
 #include "NonCopyable.h"
 #include "Timestamp.h"
 #include "CurrentThread.h"
+#include "TimerQueue.h"
+#include "LoopMetrics.h"
 
 class Poller;
 class Channel;
+#ifdef MUDUO_WITH_COROUTINES
+class SleepAwaiter;
+class SwitchAwaiter;
+#endif
 
 class EventLoop : NonCopyable {
     public:
         using Functor = std::function<void()>;
+        // pending functor的通道: 紧急通道每轮全部执行; 批量通道每轮受配额限制, 剩余的留到下一轮, 不推迟IO事件的处理
+        enum Priority {
+            kUrgent, // 控制类和延迟敏感的任务, 默认通道, 连接内部的操作都走这里
+            kBulk, // 后台任务, 如批量清理、统计汇总
+        };
 
         EventLoop();
         ~EventLoop();
@@ -24,11 +35,35 @@ class EventLoop : NonCopyable {
         void quit(); // 退出事件循环
 
         Timestamp pollReturnTime() const { return pollReturnTime_; }
-
-        // 在当前loop中执行cb
-        void runInLoop(Functor cb);
-        // 把cb放入队列, 唤醒loop所在的线程, 执行cb
-        void queueInLoop(Functor cb);
+        int64_t pollReturnNanos() const { return pollReturnNanos_; } // 本轮poll返回的时刻, LatencyHistogram::now()
+        uint64_t iteration() const { return iteration_; } // 当前是第几轮, 只在loop线程中使用
+
+        // 在当前loop中执行cb, 不在loop线程中时按priority排队
+        void runInLoop(Functor cb, Priority priority = kUrgent);
+        // 把cb放入priority通道的队列, 唤醒loop所在的线程, 执行cb; 同一通道内按入队顺序执行
+        void queueInLoop(Functor cb, Priority priority = kUrgent);
+        // 批量通道每轮最多执行maxFunctors个或maxSeconds秒(执行完一个后检查), 0表示不限制; 默认都不限制
+        // 每轮至少执行一个, 有剩余时下一轮poll不阻塞; 线程安全
+        void setBulkBudget(int maxFunctors, double maxSeconds);
+        // 本轮所有活跃channel和pending functor处理完之后执行cb, 只能在loop线程中调用
+        // 用于把一轮中的多次操作合并成一次(如合并发送), 不加锁也不唤醒
+        void runAfterDispatch(Functor cb);
+        // 下一轮poll返回、活跃channel处理完之后执行cb, 有登记的回调时poll不阻塞; 只能在loop线程中调用
+        // 用于读配额用完的连接让出本轮: 已读入缓冲区的数据不会再触发可读事件, 由cb在下一轮继续处理
+        void runNextIteration(Functor cb);
+
+        // 定时器, 线程安全, 回调在loop线程中执行; 时间单位为秒
+        TimerId runAfter(double delay, Functor cb);
+        TimerId runEvery(double interval, Functor cb);
+        void cancel(TimerId timerId);
+
+#ifdef MUDUO_WITH_COROUTINES
+        // 协程接口, 定义见Coroutine.h
+        // co_await loop.sleep(seconds): 挂起当前协程, seconds秒后在本loop中恢复
+        SleepAwaiter sleep(double seconds);
+        // co_await EventLoop::switchTo(loop): 挂起当前协程, 在loop线程中恢复
+        static SwitchAwaiter switchTo(EventLoop *loop);
+#endif
 
         // 通过wakeupFd_唤醒loop
         void wakeup();
@@ -41,26 +76,65 @@ class EventLoop : NonCopyable {
         // 判断EventLoop对象是否在自己的线程里面
         bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
 
+        // 运行统计, 计数器只能在loop线程中修改(pendingFunctors除外)
+        LoopMetrics& metrics() { return metrics_; }
+        // 统计快照, 线程安全
+        LoopStats stats() const { return metrics_.snapshot(); }
+        LoopLatencyStats latencyStats() const { return metrics_.latencySnapshot(); }
+
+        // 单个事件处理、MessageCallback或pending functor超过该耗时则记录日志, 0表示关闭; 线程安全
+        void setSlowCallbackThreshold(double seconds) {
+            slowCallbackNanos_.store(static_cast<int64_t>(seconds * 1e9), std::memory_order_relaxed);
+        }
+        bool isSlowCallback(int64_t nanos) const {
+            int64_t threshold = slowCallbackNanos_.load(std::memory_order_relaxed);
+            return threshold > 0 && nanos >= threshold;
+        }
+
     private:
         void handleRead(); // wakeupfd有数据可读时, 处理函数
         void doPendingFunctors(); // 执行回调函数
+        void doBulkFunctors(); // 按配额执行批量通道的回调
+        void doAfterDispatch(); // 执行runAfterDispatch登记的回调
 
         using ChannelList = std::vector<Channel *>;
 
+        // 排队的回调和入队时间, 用于统计排队延迟
+        struct PendingFunctor {
+            Functor functor;
+            int64_t queuedAt; // LatencyHistogram::now()
+        };
+
         std::atomic<bool> looping_; // 原子操作, 标识当前loop是否在运行
         std::atomic<bool> quit_; // 标识退出loop循环
 
         const pid_t threadId_; // 记录当前loop所属的线程id
 
         Timestamp pollReturnTime_; // poller返回发生事件的channels的时间点
+        int64_t pollReturnNanos_;
+        uint64_t iteration_;
         std::unique_ptr<Poller> poller_; // IO复用的核心对象
 
         int wakeupFd_; // mainLoop通过该文件描述符唤醒subReactor(loop)
         std::unique_ptr<Channel> wakeupChannel_; // 专门负责监听wakeupFd_可读事件的channel
+        std::unique_ptr<TimerQueue> timerQueue_; // 定时器队列
 
         ChannelList activeChannels_; // poller返回的活跃的channel列表
 
         std::atomic_bool callingPendingFunctors_; // 标识当前loop是否有需要执行的回调操作
-        std::vector<Functor> pendingFunctors_; // 存储loop需要执行的所有回调操作
-        std::mutex mutex_; // 互斥锁, 用于保护pendingFunctors_线程安全
+        std::vector<PendingFunctor> pendingFunctors_; // 存储loop需要执行的所有回调操作
+        std::mutex mutex_; // 互斥锁, 用于保护pendingFunctors_和bulkFunctors_线程安全
+        std::vector<PendingFunctor> bulkFunctors_; // 批量通道新入队的回调
+        size_t bulkPending_; // 批量通道尚未执行的回调数, 包括runningBulk_中的, 受mutex_保护
+        std::vector<PendingFunctor> runningBulk_; // 批量通道正在执行的一批, 执行完才取下一批, 只在loop线程中访问
+        size_t runningBulkNext_; // runningBulk_中下一个要执行的回调
+        std::atomic<int> bulkMaxFunctors_; // 批量通道每轮最多执行的回调数, 0表示不限制
+        std::atomic<int64_t> bulkMaxNanos_; // 批量通道每轮最多执行的时间, 0表示不限制
+        std::vector<Functor> afterDispatch_; // 本轮处理完后执行的回调, 只在loop线程中访问
+        std::vector<Functor> runningAfterDispatch_; // 正在执行的回调, 与afterDispatch_交换以复用容量
+        std::vector<Functor> nextIteration_; // 下一轮执行的回调, 只在loop线程中访问
+        std::vector<Functor> runningNextIteration_; // 本轮执行的回调, 与nextIteration_交换以复用容量
+
+        LoopMetrics metrics_; // 运行统计
+        std::atomic<int64_t> slowCallbackNanos_; // 慢回调阈值, 0表示关闭
 };
\ No newline at end of file
@@ -14,10 +14,11 @@ class EventLoopThread : NonCopyable {
     public:
         using ThreadInitCallback = std::function<void(EventLoop *)>;
 
-        EventLoopThread(const ThreadInitCallback &cb = ThreadInitCallback(), const std::string &name = std::string());
+        EventLoopThread(const ThreadInitCallback &cb = ThreadInitCallback(), const std::string &name = std::string(), int cpu = -1);
         ~EventLoopThread();
 
         EventLoop* startLoop(); // 启动线程，创建EventLoop
+        int cpu() const { return cpu_; } // 线程绑定的CPU, -1表示未绑定
 
     private:
         void threadFunc(); // 线程函数
@@ -28,4 +29,5 @@ class EventLoopThread : NonCopyable {
         std::mutex mutex_;
         std::condition_variable cond_;
         ThreadInitCallback callback_; // loop创建后，回调该函数
+        int cpu_; // 线程绑定的CPU, -1表示不绑定
 };
\ No newline at end of file
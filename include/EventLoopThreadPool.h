@@ -6,6 +6,7 @@
 #include <string>
 
 #include "NonCopyable.h"
+#include "LoopMetrics.h"
 
 class EventLoop;
 class EventLoopThread;
@@ -18,10 +19,15 @@ class EventLoopThreadPool : NonCopyable {
         ~EventLoopThreadPool();
 
         void setThreadNum(int numThreads) { numThreads_ = numThreads; } // 设置底层subloop的个数
+        void setCpuAffinity(bool on) { cpuAffinity_ = on; } // 是否将subloop依次绑定到CPU上
         void start(const ThreadInitCallback &cb = ThreadInitCallback()); // 启动线程池
 
         EventLoop* getNextLoop(); // 通过轮询算法选择一个subloop
         std::vector<EventLoop*> getAllLoops(); // 获取所有的subloop
+        EventLoop* getLoopForCpu(int cpu) const; // 获取绑定在cpu上的subloop, 没有则返回nullptr
+        // 各loop的统计快照, 第一个为baseLoop, 之后依次为subloop; 线程安全, 需在start之后调用
+        std::vector<LoopStats> loopStats() const;
+        std::vector<LoopLatencyStats> loopLatencyStats() const; // 顺序同loopStats
 
         bool started() const { return started_; }
         const std::string& name() const { return name_; }
@@ -35,4 +41,6 @@ class EventLoopThreadPool : NonCopyable {
         int next_; // 轮询算法，记录下一个被选中的subloop下标
         std::vector<std::unique_ptr<EventLoopThread>> threads_; // 线程池
         std::vector<EventLoop*> loops_; // 每个线程里面的subloop
+        bool cpuAffinity_; // 是否绑定CPU
+        std::vector<EventLoop*> cpuLoops_; // 下标为CPU编号, 值为绑定在该CPU上的subloop
 };
\ No newline at end of file
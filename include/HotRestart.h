@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NonCopyable.h"
+#include "InetAddress.h"
+#include "TimerQueue.h"
+
+class Acceptor;
+class Channel;
+class EventLoop;
+class TcpServer;
+
+/**
+ * 热重启: 新进程通过Unix域控制socket从旧进程接管监听socket(SCM_RIGHTS), 监听socket始终不关闭,
+ * 交接期间到达的SYN留在同一个accept队列中, 由新进程accept, 不会被RST
+ *
+ * 新进程: takeOver() -> 构造并start所有TcpServer -> start()
+ * 旧进程: 收到新进程的READY后对addServer添加的服务stopAccepting, 等已有连接全部关闭(或超时强制关闭)后调用drainedCallback
+ * 协议: 新进程发送"TAKEOVER\n", 旧进程回复"FDS <n>\n"并附带n个监听fd;
+ *       新进程开始监听后发送"READY\n", 旧进程停止accept、关闭控制socket后断开连接, 新进程随后在controlAddr上监听下一次重启
+ * 除takeOver外的接口都在loop线程中调用
+**/
+class HotRestart : NonCopyable {
+    public:
+        using DrainedCallback = std::function<void()>;
+
+        HotRestart(EventLoop *loop, const InetAddress &controlAddr);
+        ~HotRestart();
+
+        // 在构造TcpServer之前调用, 阻塞地从旧进程接管全部监听socket
+        // 接管的socket按本地地址交给之后构造的TcpServer, 不再重新绑定; 没有旧进程时返回false
+        bool takeOver();
+        // 所有TcpServer::start之后调用: 通知旧进程开始排空, 然后在controlAddr上等待下一次重启
+        void start();
+
+        // 交接时交出这些服务的监听socket, 需在start之前添加
+        void addServer(TcpServer *server) { servers_.push_back(server); }
+        // 交接完成且旧连接全部关闭后调用, 一般在其中退出loop
+        void setDrainedCallback(const DrainedCallback &cb) { drainedCallback_ = cb; }
+        // 排空超过该时间后强制关闭剩余连接, 默认30秒
+        void setDrainTimeout(double seconds) { drainTimeout_ = seconds; }
+        bool draining() const { return draining_; }
+        bool inherited() const { return inherited_; } // 本进程的监听socket是否从旧进程接管
+
+    private:
+        void newControlConnection(int sockfd, const InetAddress &peer);
+        void handleControlRead();
+        void sendListenSockets();
+        void handOver(); // 新进程已开始accept, 本进程停止accept并开始排空
+        void checkDrained();
+        void closeControlConnection();
+
+        EventLoop *loop_;
+        const InetAddress controlAddr_;
+        std::vector<TcpServer*> servers_;
+        std::unique_ptr<Acceptor> controlAcceptor_; // 等待新进程连接
+        int controlFd_; // 与另一个进程的控制连接, 没有时为-1
+        std::unique_ptr<Channel> controlChannel_; // 旧进程中controlFd_的channel
+        std::string controlInput_;
+        bool inherited_;
+        bool draining_;
+        double drainTimeout_;
+        TimerId drainCheckTimer_;
+        TimerId drainDeadlineTimer_;
+        DrainedCallback drainedCallback_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <stddef.h>
+
+#include "HttpRequest.h"
+
+class Buffer;
+
+/**
+ * HTTP请求的增量解析器, 每个连接一个, 直接在输入缓冲区上解析
+ * 在请求完整之前只记录请求头长度/已解析的chunk等偏移量, 不拷贝数据;
+ * 请求完整后再把请求行和请求头解析为指向缓冲区的视图
+ * 只有chunked消息体需要拼接, 拼接用的字符串在同一连接的请求之间复用
+**/
+class HttpContext {
+    public:
+        enum ParseResult {
+            kIncomplete, // 数据不完整, 等待更多数据
+            kComplete, // 解析出一个完整的请求, 通过request()获取
+            kError, // 非法请求
+        };
+
+        static const size_t kMaxHeaderBytes = 64 * 1024; // 请求行+请求头的最大长度
+        static const size_t kMaxBodyBytes = 64 * 1024 * 1024; // 消息体的最大长度
+
+        HttpContext() { reset(); }
+
+        // 从buf的可读数据开头解析一个请求, 返回kComplete后request()在consume()之前有效
+        ParseResult parse(Buffer *buf);
+        // 从buf中移除已解析的请求, 准备解析下一个(pipelining)
+        void consume(Buffer *buf);
+
+        const HttpRequest& request() const { return request_; }
+
+    private:
+        enum State {
+            kExpectHeaders, // 等待完整的请求头
+            kExpectBody, // 等待Content-Length长度的消息体
+            kExpectChunk, // 等待下一个chunk
+        };
+
+        void reset();
+        bool parseHeaders(const char *begin, const char *end); // 解析请求行和请求头, 填充request_
+        ParseResult parseChunks(const char *data, size_t readable); // 解析chunked消息体
+
+        State state_;
+        size_t scanned_; // 已经查找过\r\n\r\n的字节数, 避免重复扫描
+        size_t headerLen_; // 请求头长度(包括末尾空行)
+        size_t contentLength_; // Content-Length
+        bool chunked_; // Transfer-Encoding: chunked
+        size_t chunkPos_; // 下一个chunk相对可读数据开头的偏移
+        size_t requestLen_; // 完整请求的长度
+        const char *headerBase_; // 解析请求头时缓冲区可读数据的起始地址, 用于判断视图是否失效
+        std::string chunkedBody_; // 拼接后的chunked消息体
+        HttpRequest request_;
+};
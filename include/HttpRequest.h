@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string_view>
+#include <stddef.h>
+
+/**
+ * HTTP请求, 所有字段都是指向连接输入缓冲区的视图, 不拷贝数据
+ * 只在HttpServer回调执行期间有效
+**/
+class HttpRequest {
+    public:
+        enum Method { kInvalid, kGet, kPost, kHead, kPut, kDelete, kOptions, kPatch };
+        enum Version { kUnknown, kHttp10, kHttp11 };
+
+        struct Header {
+            std::string_view name;
+            std::string_view value;
+        };
+        static const size_t kMaxHeaders = 64; // 超过该数量的请求头视为非法请求
+
+        HttpRequest() { reset(); }
+
+        void reset() {
+            method_ = kInvalid;
+            version_ = kUnknown;
+            methodString_ = std::string_view();
+            path_ = std::string_view();
+            query_ = std::string_view();
+            body_ = std::string_view();
+            numHeaders_ = 0;
+        }
+
+        Method method() const { return method_; }
+        std::string_view methodString() const { return methodString_; }
+        Version version() const { return version_; }
+        std::string_view path() const { return path_; }
+        std::string_view query() const { return query_; }
+        std::string_view body() const { return body_; }
+
+        size_t numHeaders() const { return numHeaders_; }
+        const Header& header(size_t i) const { return headers_[i]; }
+        // 按名称查找请求头(不区分大小写), 不存在时返回空视图
+        std::string_view getHeader(std::string_view name) const;
+        // HTTP/1.1默认保持连接, HTTP/1.0需要显式Connection: keep-alive
+        bool keepAlive() const;
+
+    private:
+        friend class HttpContext;
+
+        bool setMethod(std::string_view method);
+        bool addHeader(std::string_view name, std::string_view value) {
+            if (numHeaders_ >= kMaxHeaders) return false;
+            headers_[numHeaders_].name = name;
+            headers_[numHeaders_].value = value;
+            ++numHeaders_;
+            return true;
+        }
+
+        Method method_;
+        Version version_;
+        std::string_view methodString_;
+        std::string_view path_;
+        std::string_view query_;
+        std::string_view body_;
+        Header headers_[kMaxHeaders];
+        size_t numHeaders_;
+};
+
+// 不区分大小写比较, 用于HTTP头名称和取值
+bool httpEqualsIgnoreCase(std::string_view a, std::string_view b);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <stddef.h>
+
+class Buffer;
+
+/**
+ * HTTP响应构造器, 状态行/响应头/消息体通过appendToBuffer一次写入同一个输出缓冲区
+ * 响应头保存为视图, 其指向的数据需在appendToBuffer之前保持有效
+**/
+class HttpResponse {
+    public:
+        enum StatusCode {
+            kUnknown = 0,
+            k200Ok = 200,
+            k204NoContent = 204,
+            k301MovedPermanently = 301,
+            k400BadRequest = 400,
+            k404NotFound = 404,
+            k413PayloadTooLarge = 413,
+            k500InternalServerError = 500,
+        };
+        static const size_t kMaxHeaders = 16;
+
+        explicit HttpResponse(bool closeConnection)
+            : statusCode_(kUnknown),
+              closeConnection_(closeConnection),
+              numHeaders_(0) {}
+
+        void setStatusCode(StatusCode code) { statusCode_ = code; }
+        void setStatusMessage(std::string_view message) { statusMessage_ = message; }
+        void setCloseConnection(bool on) { closeConnection_ = on; }
+        bool closeConnection() const { return closeConnection_; }
+
+        void setContentType(std::string_view contentType) { addHeader("Content-Type", contentType); }
+        void addHeader(std::string_view name, std::string_view value);
+
+        // body指向的数据需在appendToBuffer之前保持有效
+        void setBody(std::string_view body) { body_ = body; }
+        // 由响应对象持有消息体
+        void setBody(std::string &&body) { ownedBody_ = std::move(body); body_ = ownedBody_; }
+
+        void appendToBuffer(Buffer *output) const;
+
+    private:
+        struct Header {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        StatusCode statusCode_;
+        std::string_view statusMessage_;
+        bool closeConnection_;
+        Header headers_[kMaxHeaders];
+        size_t numHeaders_;
+        std::string_view body_;
+        std::string ownedBody_;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "NonCopyable.h"
+#include "TcpServer.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+
+/**
+ * 基于TcpServer的HTTP/1.1服务器, 支持keep-alive、pipelining和chunked请求体
+ * 同一批到达的pipelined请求按顺序处理, 响应写入同一个输出缓冲区后一次发送
+**/
+class HttpServer : NonCopyable {
+    public:
+        // 在连接所属的loop中调用, request只在回调期间有效
+        using HttpCallback = std::function<void(const HttpRequest &, HttpResponse *)>;
+
+        HttpServer(EventLoop *loop,
+                   const InetAddress &listenAddr,
+                   const std::string &name,
+                   TcpServer::Option option = TcpServer::kNoReusePort);
+
+        EventLoop* getLoop() const { return server_.getLoop(); }
+        TcpServer& tcpServer() { return server_; }
+
+        void setHttpCallback(const HttpCallback &cb) { httpCallback_ = cb; }
+        void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+        void start();
+
+    private:
+        void onConnection(const TcpConnectionPtr &conn);
+        void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime);
+
+        TcpServer server_;
+        HttpCallback httpCallback_;
+};
@@ -2,21 +2,47 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <string>
 
-// 封装IP地址和端口
+/**
+ * 封装socket地址, 支持IPv4、IPv6和Unix域socket
+ * Unix域socket路径以'@'开头时使用abstract namespace, 不在文件系统中创建文件
+**/
 class InetAddress {
     public:
+        // IP地址和端口, ip中含有':'时按IPv6解析
         explicit InetAddress(uint16_t port = 0, std::string ip = "127.0.0.1");
-        explicit InetAddress(const sockaddr_in &addr)
-            : addr_(addr) {}
+        explicit InetAddress(const sockaddr_in &addr);
+        explicit InetAddress(const sockaddr_in6 &addr);
+        // 由系统调用返回的地址构造
+        InetAddress(const sockaddr *addr, socklen_t len) { setSockAddr(addr, len); }
+
+        // Unix域socket地址, 路径超过sun_path长度时返回无效地址(valid()为false)
+        static InetAddress unixPath(const std::string &path);
+
+        sa_family_t family() const { return addr_.sa_family; }
+        bool isUnix() const { return family() == AF_UNIX; }
+        bool valid() const { return family() != AF_UNSPEC; }
         
-        std::string toIp() const;
-        std::string toIpPort() const;
-        uint16_t toPort() const;
+        std::string toIp() const; // Unix域socket返回路径
+        std::string toIpPort() const; // IPv6为[ip]:port, Unix域socket为unix:path
+        uint16_t toPort() const; // Unix域socket返回0
+
+        const sockaddr *getSockAddr() const { return &addr_; }
+        socklen_t getSockLen() const { return len_; }
+        void setSockAddr(const sockaddr *addr, socklen_t len);
+
+        bool operator==(const InetAddress &rhs) const;
+        bool operator!=(const InetAddress &rhs) const { return !(*this == rhs); }
 
-        const sockaddr_in *getSockAddr() const { return &addr_; }
-        void setSockAddr(const sockaddr_in &addr) { addr_ = addr; }
     private:
-        sockaddr_in addr_;
-};
\ No newline at end of file
+        union {
+            sockaddr addr_;
+            sockaddr_in addr4_;
+            sockaddr_in6 addr6_;
+            sockaddr_un addrUn_;
+        };
+        socklen_t len_; // 地址的有效长度, abstract namespace的名字不以'\0'结尾, 需要按长度处理
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+
+#include "NonCopyable.h"
+#include "LoopCounter.h"
+
+/**
+ * 对数分桶的延迟直方图(HDR风格), 单位纳秒
+ * 每个2的幂区间再等分为kSubBuckets个子桶, 相对误差不超过1/kSubBuckets, 桶数固定, record不分配内存
+ * 只能由一个线程record(一般是loop线程), 任意线程可取快照; 快照可以跨loop合并后再求分位数
+**/
+class LatencyHistogram : NonCopyable {
+    public:
+        static const int kSubBucketBits = 5;
+        static const int kSubBuckets = 1 << kSubBucketBits; // 32个子桶, 误差约3%
+        static const int kMaxBits = 40; // 2^40ns约18分钟, 更大的值计入最后一个桶
+        static const int kNumBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+        // 快照, 可以合并
+        struct Snapshot {
+            std::vector<uint64_t> counts; // 每个桶的计数, 没有数据时为空
+            uint64_t count = 0;
+            uint64_t sum = 0;
+            uint64_t max = 0;
+
+            Snapshot& operator+=(const Snapshot &rhs);
+            // p取[0, 1], 返回该分位数所在桶的上界(不超过max), 没有数据时返回0
+            uint64_t percentile(double p) const;
+            double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+        };
+
+        // 单调时钟, 纳秒
+        static int64_t now() {
+            timespec ts;
+            ::clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+        static int bucketIndex(uint64_t nanos) {
+            if (nanos < static_cast<uint64_t>(kSubBuckets)) {
+                return static_cast<int>(nanos);
+            }
+            int msb = 63 - __builtin_clzll(nanos);
+            int shift = msb - kSubBucketBits;
+            int index = (shift + 1) * kSubBuckets + static_cast<int>((nanos >> shift) & (kSubBuckets - 1));
+            return index < kNumBuckets ? index : kNumBuckets - 1;
+        }
+        static uint64_t bucketUpperBound(int index);
+
+        void record(int64_t nanos) {
+            uint64_t v = nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+            counts_[bucketIndex(v)].add(1);
+            sum_.add(v);
+            if (v > max_.get()) {
+                max_.set(v);
+            }
+        }
+
+        // 线程安全
+        Snapshot snapshot() const;
+
+    private:
+        LoopCounter counts_[kNumBuckets];
+        LoopCounter sum_;
+        LoopCounter max_;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <string_view>
+
+#include "NonCopyable.h"
+#include "Callbacks.h"
+#include "Buffer.h"
+#include "Timestamp.h"
+
+/**
+ * 长度前缀分帧编解码器, 帧格式为 [4字节网络字节序长度][消息体]
+ * 解码直接在inputBuffer_上进行, 以string_view的形式把消息体交给回调, 不拷贝数据
+ * 编码时用Buffer::prepend把长度头写进预留空间, 头和消息体一次写出
+**/
+class LengthHeaderCodec : NonCopyable {
+    public:
+        // frame只在回调执行期间有效, 需要保留时由用户自行拷贝
+        using FrameCallback = std::function<void(const TcpConnectionPtr &, std::string_view frame, Timestamp)>;
+
+        static const size_t kHeaderLen = sizeof(int32_t);
+        static const size_t kDefaultMaxFrameSize = 64 * 1024 * 1024; // 64M
+
+        explicit LengthHeaderCodec(const FrameCallback &cb, size_t maxFrameSize = kDefaultMaxFrameSize)
+            : frameCallback_(cb),
+              maxFrameSize_(maxFrameSize),
+              frameBudget_(0) {}
+
+        // 每次onMessage最多处理frames帧, 剩余的帧通过TcpConnection::deferMessages留到下一轮; 0表示不限制
+        void setFrameBudget(int frames) { frameBudget_ = frames; }
+
+        // 设置为TcpServer的MessageCallback
+        // 长度超过maxFrameSize的帧视为非法数据, 丢弃缓冲区并关闭连接
+        void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime);
+
+        // 编码并发送一条消息
+        void send(const TcpConnectionPtr &conn, std::string_view message);
+        // buf中的可读数据为消息体, 在其前面加上长度头后发送, 消息体不发生拷贝
+        void send(const TcpConnectionPtr &conn, Buffer *message);
+
+    private:
+        FrameCallback frameCallback_;
+        const size_t maxFrameSize_;
+        int frameBudget_;
+};
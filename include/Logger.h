@@ -1,12 +1,14 @@
 #pragma once
 
 #include<string>
+#include<atomic>
 
 #include "NonCopyable.h"
 
 // LOG_INFO等宏定义 LOG_INFO("%s %d", arg1, arg2)
 #define LOG_INFO(logmsgFormat, ...)                       \
     do {                                                  \
+        if (!Logger::infoEnabled()) break;                \
         Logger &logger = Logger::instance();              \
         logger.setLogLevel(INFO);                         \
         char buf[1024] = {0};                             \
@@ -63,6 +65,11 @@ class Logger : NonCopyable {
         void setLogLevel(int level);
         // 写日志
         void log(std::string msg);
+
+        // 是否输出INFO级别日志, 压测时可关闭以免日志开销掩盖被测对象
+        static bool infoEnabled() { return infoEnabled_.load(std::memory_order_relaxed); }
+        static void setInfoEnabled(bool on) { infoEnabled_.store(on, std::memory_order_relaxed); }
     private:
         int logLevel_; // 日志级别
+        static std::atomic<bool> infoEnabled_;
 };
\ No newline at end of file
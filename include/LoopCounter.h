@@ -0,0 +1,21 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * 单写者计数器: 只由一个线程(loop线程, 或持有同一把锁的线程)修改, 任意线程可读
+ * 单写者不需要原子的读-改-写, relaxed的load+store编译为普通的读写指令, 热路径上没有lock前缀
+**/
+class LoopCounter {
+    public:
+        LoopCounter() : value_(0) {}
+
+        void add(uint64_t n) { value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+        void sub(uint64_t n) { value_.store(value_.load(std::memory_order_relaxed) - n, std::memory_order_relaxed); }
+        void set(uint64_t n) { value_.store(n, std::memory_order_relaxed); }
+        uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value_;
+};
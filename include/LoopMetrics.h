@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "LoopCounter.h"
+#include "LatencyHistogram.h"
+
+// 一个EventLoop的运行统计快照
+struct LoopStats {
+    uint64_t iterations = 0; // loop循环次数(poll调用次数)
+    uint64_t events = 0; // poll返回的事件总数
+    uint64_t pollNanos = 0; // 阻塞在poll中的时间
+    uint64_t busyNanos = 0; // 处理事件和回调的时间
+    uint64_t functors = 0; // 执行的pendingFunctors总数
+    uint64_t pendingFunctors = 0; // 当前紧急通道排队的functor数
+    uint64_t bulkFunctors = 0; // 批量通道执行的functor数, 同时计入functors
+    uint64_t pendingBulkFunctors = 0; // 当前批量通道排队的functor数
+    uint64_t bulkCarryOvers = 0; // 批量通道配额用完、剩余functor留到下一轮的次数
+    uint64_t wakeups = 0; // 被其他线程(或回调中)唤醒的次数
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t writeCalls = 0; // 连接上的写系统调用次数
+    uint64_t readsDeferred = 0; // 连接用完读配额让出本轮的次数
+    uint64_t connections = 0; // 当前活跃的连接数
+    uint64_t bufferBytes = 0; // 活跃连接的输入输出缓冲区占用的内存
+
+    LoopStats& operator+=(const LoopStats &rhs) {
+        iterations += rhs.iterations;
+        events += rhs.events;
+        pollNanos += rhs.pollNanos;
+        busyNanos += rhs.busyNanos;
+        functors += rhs.functors;
+        pendingFunctors += rhs.pendingFunctors;
+        bulkFunctors += rhs.bulkFunctors;
+        pendingBulkFunctors += rhs.pendingBulkFunctors;
+        bulkCarryOvers += rhs.bulkCarryOvers;
+        wakeups += rhs.wakeups;
+        bytesRead += rhs.bytesRead;
+        bytesWritten += rhs.bytesWritten;
+        writeCalls += rhs.writeCalls;
+        readsDeferred += rhs.readsDeferred;
+        connections += rhs.connections;
+        bufferBytes += rhs.bufferBytes;
+        return *this;
+    }
+};
+
+// 一个EventLoop的延迟分布快照, 单位纳秒; 可跨loop合并
+struct LoopLatencyStats {
+    LatencyHistogram::Snapshot eventHandling; // 每个Channel::handleEvent的耗时
+    LatencyHistogram::Snapshot messageCallback; // 每次MessageCallback的耗时
+    LatencyHistogram::Snapshot functorRun; // 每个pending functor的耗时
+    LatencyHistogram::Snapshot functorDelay; // 紧急通道的functor从queueInLoop到开始执行的等待时间
+    LatencyHistogram::Snapshot bulkFunctorDelay; // 批量通道的functor从queueInLoop到开始执行的等待时间
+    LatencyHistogram::Snapshot readDelay; // 连接从可读(或被推迟)到MessageCallback开始执行的等待时间
+
+    LoopLatencyStats& operator+=(const LoopLatencyStats &rhs) {
+        eventHandling += rhs.eventHandling;
+        messageCallback += rhs.messageCallback;
+        functorRun += rhs.functorRun;
+        functorDelay += rhs.functorDelay;
+        bulkFunctorDelay += rhs.bulkFunctorDelay;
+        readDelay += rhs.readDelay;
+        return *this;
+    }
+};
+
+// EventLoop内部的计数器, 字段含义同LoopStats/LoopLatencyStats
+struct LoopMetrics {
+    LoopCounter iterations;
+    LoopCounter events;
+    LoopCounter pollNanos;
+    LoopCounter busyNanos;
+    LoopCounter functors;
+    LoopCounter pendingFunctors; // 在EventLoop::mutex_保护下修改
+    LoopCounter bulkFunctors;
+    LoopCounter pendingBulkFunctors; // 在EventLoop::mutex_保护下修改
+    LoopCounter bulkCarryOvers;
+    LoopCounter wakeups;
+    LoopCounter bytesRead;
+    LoopCounter bytesWritten;
+    LoopCounter writeCalls;
+    LoopCounter readsDeferred;
+    LoopCounter connections;
+    LoopCounter bufferBytes;
+
+    LatencyHistogram eventHandling;
+    LatencyHistogram messageCallback;
+    LatencyHistogram functorRun;
+    LatencyHistogram functorDelay;
+    LatencyHistogram bulkFunctorDelay;
+    LatencyHistogram readDelay;
+
+    // 线程安全, 各字段分别读取, 彼此之间不保证是同一时刻的值
+    LoopStats snapshot() const {
+        LoopStats s;
+        s.iterations = iterations.get();
+        s.events = events.get();
+        s.pollNanos = pollNanos.get();
+        s.busyNanos = busyNanos.get();
+        s.functors = functors.get();
+        s.pendingFunctors = pendingFunctors.get();
+        s.bulkFunctors = bulkFunctors.get();
+        s.pendingBulkFunctors = pendingBulkFunctors.get();
+        s.bulkCarryOvers = bulkCarryOvers.get();
+        s.wakeups = wakeups.get();
+        s.bytesRead = bytesRead.get();
+        s.bytesWritten = bytesWritten.get();
+        s.writeCalls = writeCalls.get();
+        s.readsDeferred = readsDeferred.get();
+        s.connections = connections.get();
+        s.bufferBytes = bufferBytes.get();
+        return s;
+    }
+
+    // 线程安全
+    LoopLatencyStats latencySnapshot() const {
+        LoopLatencyStats s;
+        s.eventHandling = eventHandling.snapshot();
+        s.messageCallback = messageCallback.snapshot();
+        s.functorRun = functorRun.snapshot();
+        s.functorDelay = functorDelay.snapshot();
+        s.bulkFunctorDelay = bulkFunctorDelay.snapshot();
+        s.readDelay = readDelay.snapshot();
+        return s;
+    }
+};
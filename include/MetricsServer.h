@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "NonCopyable.h"
+#include "HttpServer.h"
+
+/**
+ * 以Prometheus文本格式导出TcpServer各loop的运行统计, GET /metrics
+ * 统计来自EventLoop的单写者计数器, 生成时不需要进入各loop线程
+ * 一般与被导出的TcpServer共用mainLoop, 单独监听一个管理端口
+**/
+class MetricsServer : NonCopyable {
+    public:
+        MetricsServer(EventLoop *loop, const InetAddress &listenAddr, const std::string &name = "MetricsServer");
+
+        // 导出server的所有loop, 需在start之前调用; server的生命周期要长于MetricsServer
+        void addServer(TcpServer *server) { servers_.push_back(server); }
+        void start() { http_.start(); }
+
+        // 生成Prometheus文本格式, 线程安全
+        std::string render() const;
+
+    private:
+        void onRequest(const HttpRequest &request, HttpResponse *response);
+
+        HttpServer http_;
+        std::vector<TcpServer *> servers_;
+};
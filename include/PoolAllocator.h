@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <stddef.h>
+
+#include "NonCopyable.h"
+
+/**
+ * 固定大小内存块池, 回收的内存块挂在空闲链表上供下次分配复用
+ * 块大小由第一次分配决定, 之后大小不同的请求直接走::operator new
+ * 分配和释放可能在不同线程(mainLoop创建连接, subLoop销毁连接), 用互斥锁保护空闲链表
+**/
+class BlockPool : NonCopyable {
+    public:
+        // 统计信息
+        struct Stats {
+            uint64_t reused; // 从空闲链表复用的次数
+            uint64_t allocated; // 向系统申请新内存块的次数
+            size_t freeBlocks; // 空闲链表中的内存块数
+        };
+
+        explicit BlockPool(size_t maxFreeBlocks = 4096);
+        ~BlockPool();
+
+        void* allocate(size_t size);
+        void deallocate(void *p, size_t size);
+
+        Stats stats() const;
+
+    private:
+        struct FreeBlock {
+            FreeBlock *next;
+        };
+
+        mutable std::mutex mutex_;
+        size_t blockSize_; // 内存块大小, 0表示还未分配过
+        FreeBlock *freeList_; // 空闲链表
+        size_t freeCount_; // 空闲链表长度
+        const size_t maxFreeBlocks_; // 空闲链表最大长度, 超出的内存块直接释放
+        std::atomic<uint64_t> reused_;
+        std::atomic<uint64_t> allocated_;
+};
+
+// 基于BlockPool的标准分配器, 配合std::allocate_shared把对象和控制块放在同一块池化内存中
+template <typename T>
+class PoolAllocator {
+    public:
+        using value_type = T;
+
+        explicit PoolAllocator(std::shared_ptr<BlockPool> pool) : pool_(std::move(pool)) {}
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U> &other) : pool_(other.pool()) {}
+
+        T* allocate(size_t n) { return static_cast<T *>(pool_->allocate(n * sizeof(T))); }
+        void deallocate(T *p, size_t n) { pool_->deallocate(p, n * sizeof(T)); }
+
+        const std::shared_ptr<BlockPool>& pool() const { return pool_; }
+
+    private:
+        std::shared_ptr<BlockPool> pool_; // 控制块中保存分配器, 保证池在最后一个对象释放前存活
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.pool() == b.pool(); }
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.pool() != b.pool(); }
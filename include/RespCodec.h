@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+class Buffer;
+
+/**
+ * RESP(Redis序列化协议)的命令解析和回复编码
+ * 客户端命令在RESP2/RESP3中都是bulk string数组, 也兼容telnet风格的inline命令
+ * 解析结果是指向输入缓冲区的视图, 不拷贝参数; 回复直接编码进输出缓冲区
+**/
+
+// 一条命令, 参数视图指向输入缓冲区
+struct RespCommand {
+    const std::string_view *argv;
+    size_t argc;
+
+    std::string_view name() const { return argv[0]; }
+    std::string_view operator[](size_t i) const { return argv[i]; }
+    // 命令名比较, 忽略大小写
+    bool is(std::string_view name) const;
+};
+
+// 一批pipelined命令, 内部数组在同一连接的多批命令之间复用
+class RespCommandBatch {
+    public:
+        size_t size() const { return commands_.size(); }
+        bool empty() const { return commands_.empty(); }
+        RespCommand operator[](size_t i) const {
+            const Range &r = commands_[i];
+            return RespCommand{args_.data() + r.first, r.count};
+        }
+        void clear() { args_.clear(); commands_.clear(); }
+
+    private:
+        friend class RespParser;
+
+        struct Range {
+            size_t first; // 第一个参数在args_中的下标
+            size_t count; // 参数个数
+        };
+
+        std::vector<std::string_view> args_;
+        std::vector<Range> commands_;
+};
+
+class RespParser {
+    public:
+        enum ParseResult {
+            kIncomplete, // 数据不完整, 等待更多数据
+            kComplete, // 解析出至少一条命令
+            kError, // 协议错误
+        };
+
+        static const size_t kMaxBulkLen = 64 * 1024 * 1024; // 单个参数的最大长度
+        static const size_t kMaxArgs = 1024 * 1024; // 单条命令的最大参数个数
+        static const size_t kMaxInlineLen = 64 * 1024; // inline命令的最大长度
+
+        RespParser() : parsed_(0), error_("") {}
+
+        // 从buf的可读数据开头解析所有完整的命令追加到batch, 不移除数据
+        // 返回kComplete后batch中的视图在consume()之前有效
+        ParseResult parse(const Buffer *buf, RespCommandBatch *batch);
+        // 从buf中移除已解析的命令
+        void consume(Buffer *buf);
+        // 协议错误的描述
+        const char* error() const { return error_; }
+
+    private:
+        ParseResult parseOne(const char *begin, const char *end, RespCommandBatch *batch, size_t *consumed);
+        ParseResult parseInline(const char *begin, const char *end, RespCommandBatch *batch, size_t *consumed);
+
+        size_t parsed_; // 已解析的字节数
+        const char *error_; // 最近一次协议错误
+};
+
+/**
+ * RESP回复编码器, 直接写入输出缓冲区
+ * RESP3独有的类型(null/map/boolean/double)在RESP2连接上编码为等价的RESP2类型
+**/
+class RespWriter {
+    public:
+        explicit RespWriter(Buffer *output, int protocol = 2)
+            : output_(output), protocol_(protocol), closeAfterReply_(false) {}
+
+        // 协议版本, HELLO命令可以切换为3
+        int protocol() const { return protocol_; }
+        void setProtocol(int protocol) { protocol_ = protocol; }
+        Buffer* output() const { return output_; }
+        // 本批回复发送后关闭连接(如QUIT)
+        void closeAfterReply() { closeAfterReply_ = true; }
+        bool closeRequested() const { return closeAfterReply_; }
+
+        void simpleString(std::string_view s); // +OK
+        void error(std::string_view message); // -ERR message
+        void integer(int64_t value); // :1
+        void bulk(std::string_view s); // $3\r\nfoo
+        void null(); // RESP2: $-1, RESP3: _
+        void nullArray(); // RESP2: *-1, RESP3: _
+        void arrayHeader(size_t count); // *n, 之后写入n个元素
+        void mapHeader(size_t count); // RESP2: *2n, RESP3: %n, 之后写入n对键值
+        void boolean(bool value); // RESP2: :1/:0, RESP3: #t/#f
+        void doubleValue(double value); // RESP2: bulk string, RESP3: ,1.5
+
+        // 常用的固定回复
+        void ok() { simpleString("OK"); }
+
+    private:
+        void header(char type, int64_t value); // 类型字符 + 整数 + \r\n
+
+        Buffer *output_;
+        int protocol_;
+        bool closeAfterReply_;
+};
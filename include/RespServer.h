@@ -0,0 +1,39 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "NonCopyable.h"
+#include "TcpServer.h"
+#include "RespCodec.h"
+
+/**
+ * 基于TcpServer的RESP服务器, 可以作为Redis兼容服务的网络层
+ * 一次可读事件中到达的所有完整命令作为一批交给回调, 参数是指向输入缓冲区的视图,
+ * 回复由回调通过RespWriter直接编码进连接的输出缓冲区, 整批处理完后统一发送
+**/
+class RespServer : NonCopyable {
+    public:
+        // 在连接所属的loop中调用, 回调需要按顺序为batch中的每条命令写入一个回复
+        // batch中的视图只在回调期间有效
+        using BatchCallback = std::function<void(const TcpConnectionPtr &, const RespCommandBatch &, RespWriter *)>;
+
+        RespServer(EventLoop *loop,
+                   const InetAddress &listenAddr,
+                   const std::string &name,
+                   TcpServer::Option option = TcpServer::kNoReusePort);
+
+        EventLoop* getLoop() const { return server_.getLoop(); }
+        TcpServer& tcpServer() { return server_; }
+
+        void setBatchCallback(const BatchCallback &cb) { batchCallback_ = cb; }
+        void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+        void start();
+
+    private:
+        void onConnection(const TcpConnectionPtr &conn);
+        void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime);
+
+        TcpServer server_;
+        BatchCallback batchCallback_;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <functional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "NonCopyable.h"
+#include "TcpClient.h"
+#include "LengthHeaderCodec.h"
+#include "RpcMessage.h"
+#include "TimerQueue.h"
+
+/**
+ * RPC客户端, 一个连接上复用任意多个并发调用, 按请求id匹配乱序到达的响应
+ * 截止时间保存在最小堆中, 只为最早的截止时间设置一个定时器
+ * 除call外的接口和所有回调都在loop线程中执行
+**/
+class RpcClient : NonCopyable {
+    public:
+        // response只在回调期间有效; status不为kRpcOk时response为错误信息或为空
+        using ResponseCallback = std::function<void(RpcStatus status, std::string_view response)>;
+
+        RpcClient(EventLoop *loop, const InetAddress &serverAddr, const std::string &name);
+        ~RpcClient();
+
+        EventLoop* getLoop() const { return loop_; }
+        void connect() { client_.connect(); }
+        void disconnect() { client_.disconnect(); }
+        void enableRetry() { client_.enableRetry(); }
+        bool connected() const { return connection_ != nullptr; }
+        // 连接建立和断开时回调, 断开前未完成的调用已经以kRpcConnectionLost结束
+        void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
+
+        // 发起调用, 线程安全; 回调在loop线程中执行
+        // timeoutMs为0表示没有截止时间; 未连接时回调立即以kRpcConnectionLost结束
+        void call(std::string_view method, std::string_view request, ResponseCallback cb, int timeoutMs = 0);
+
+        // 等待响应的调用数
+        size_t pendingCalls() const { return pending_.size(); }
+
+    private:
+        struct PendingCall {
+            ResponseCallback callback;
+            int64_t deadline; // 0表示没有截止时间
+        };
+        using Deadline = std::pair<int64_t, uint64_t>; // (截止时间, 请求id)
+        static constexpr int64_t kMinTimerIntervalUs = 1000; // 超时最多延迟1ms处理
+
+        void callInLoop(std::string_view method, std::string_view request, ResponseCallback &cb, int timeoutMs);
+        void onConnection(const TcpConnectionPtr &conn);
+        void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime);
+        void onFrame(const TcpConnectionPtr &conn, std::string_view frame, Timestamp receiveTime);
+        void complete(uint64_t id, RpcStatus status, std::string_view response);
+        void failAll(RpcStatus status); // 连接断开, 结束所有未完成的调用
+        void scheduleDeadlineTimer(); // 按最早的截止时间设置定时器
+        void handleDeadlines(); // 截止时间到, 结束超时的调用
+
+        EventLoop *loop_;
+        TcpClient client_;
+        LengthHeaderCodec codec_;
+        ConnectionCallback connectionCallback_;
+        TcpConnectionPtr connection_; // 当前连接, 只在loop中访问
+        bool dispatching_; // 正在处理收到的响应, 期间发起的调用在处理结束后统一发送
+        uint64_t nextId_;
+        std::unordered_map<uint64_t, PendingCall> pending_;
+        // 已完成调用的截止时间惰性删除, 积压过多时按pending_重建
+        std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines_;
+        TimerId deadlineTimer_;
+        int64_t timerExpiration_; // 当前定时器的到期时间, 0表示没有定时器
+};
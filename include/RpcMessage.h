@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string_view>
+#include <stddef.h>
+#include <stdint.h>
+
+class Buffer;
+
+// RPC调用结果
+enum RpcStatus : uint8_t {
+    kRpcOk = 0,
+    kRpcMethodNotFound = 1, // 服务端没有注册该方法
+    kRpcDeadlineExceeded = 2, // 超过截止时间
+    kRpcConnectionLost = 3, // 连接断开或未连接
+    kRpcBadRequest = 4, // 请求格式错误
+    kRpcApplicationError = 5, // 服务端处理失败, 响应体为错误信息
+};
+
+const char* rpcStatusName(RpcStatus status);
+
+/**
+ * RPC消息信封, 所有整数为网络字节序, 整条消息外层是LengthHeaderCodec的4字节长度头
+ * 请求: [type=1 u8][id u64][timeoutMs u32][methodLen u8][method][payload]
+ * 响应: [type=2 u8][id u64][status u8][payload]
+ * 同一连接上的请求按id匹配响应, 响应可以乱序返回
+**/
+struct RpcMessage {
+    enum Type : uint8_t {
+        kRequest = 1,
+        kResponse = 2,
+    };
+    static const size_t kRequestHeaderLen = 1 + 8 + 4 + 1;
+    static const size_t kResponseHeaderLen = 1 + 8 + 1;
+    static const size_t kMaxMethodLen = 255;
+
+    Type type;
+    uint64_t id;
+    uint32_t timeoutMs; // 请求的超时时间, 0表示没有截止时间
+    RpcStatus status; // 响应状态
+    std::string_view method; // 请求的方法名
+    std::string_view payload;
+
+    // 解码一帧(不含长度头), 视图指向frame; 格式错误时返回false
+    bool decode(std::string_view frame);
+
+    // 把带长度头的完整消息追加到output
+    static void appendRequest(Buffer *output, uint64_t id, std::string_view method,
+                              uint32_t timeoutMs, std::string_view payload);
+    static void appendResponse(Buffer *output, uint64_t id, RpcStatus status, std::string_view payload);
+};
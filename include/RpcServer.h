@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "NonCopyable.h"
+#include "TcpServer.h"
+#include "LengthHeaderCodec.h"
+#include "RpcMessage.h"
+
+/**
+ * 请求的应答句柄, 可以拷贝, 可以在任意线程中使用
+ * 每个请求只能调用一次reply或fail; 超过截止时间的应答直接丢弃(客户端已按超时处理)
+**/
+class RpcResponder {
+    public:
+        RpcResponder(const TcpConnectionPtr &conn, uint64_t id, int64_t deadline)
+            : conn_(conn), id_(id), deadline_(deadline) {}
+
+        void reply(std::string_view response) const { send(kRpcOk, response); }
+        void fail(RpcStatus status, std::string_view message = std::string_view()) const { send(status, message); }
+
+        uint64_t id() const { return id_; }
+        // 截止时间(TimerQueue::now()时钟, 微秒), 0表示没有截止时间
+        int64_t deadline() const { return deadline_; }
+        // 是否已超过截止时间, 长耗时的处理可以据此提前放弃
+        bool expired() const;
+
+    private:
+        void send(RpcStatus status, std::string_view payload) const;
+
+        std::weak_ptr<TcpConnection> conn_;
+        uint64_t id_;
+        int64_t deadline_;
+};
+
+/**
+ * 基于TcpServer的RPC服务端, 方法按名字注册
+ * 同一连接上的多个请求并发处理, 处理函数可以同步应答, 也可以把RpcResponder交给其他线程异步应答
+ * 一次可读事件中同步完成的应答写入同一个输出缓冲区后一次发送
+**/
+class RpcServer : NonCopyable {
+    public:
+        // 在连接所属的loop中调用, request只在调用期间有效
+        using MethodHandler = std::function<void(std::string_view request, RpcResponder responder)>;
+
+        RpcServer(EventLoop *loop,
+                  const InetAddress &listenAddr,
+                  const std::string &name,
+                  TcpServer::Option option = TcpServer::kNoReusePort);
+
+        EventLoop* getLoop() const { return server_.getLoop(); }
+        TcpServer& tcpServer() { return server_; }
+
+        // 注册方法, 需在start之前调用; 方法名最长255字节
+        void registerMethod(const std::string &name, const MethodHandler &handler);
+        void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+        void start();
+
+    private:
+        void onConnection(const TcpConnectionPtr &conn);
+        void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime);
+        void onFrame(const TcpConnectionPtr &conn, std::string_view frame, Timestamp receiveTime);
+
+        TcpServer server_;
+        LengthHeaderCodec codec_;
+        // start之后只读, 各loop并发查找不需要加锁; std::less<>支持用string_view查找
+        std::map<std::string, MethodHandler, std::less<>> methods_;
+};
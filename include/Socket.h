@@ -22,6 +22,10 @@ class Socket : NonCopyable {
         void setReuseAddr(bool on);
         void setReusePort(bool on);
         void setKeepAlive(bool on);
+
+        // 获取收包所在的CPU/NAPI队列, 不支持时返回-1
+        static int incomingCpu(int sockfd);
+        static int incomingNapiId(int sockfd);
     private:
         const int sockfd_;
 };
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <atomic>
+
+#include "NonCopyable.h"
+#include "TcpConnection.h"
+#include "InetAddress.h"
+#include "Callbacks.h"
+
+class Connector;
+class EventLoop;
+
+/**
+ * TCP客户端, 管理一个到服务器的连接, 连接由loop_负责读写
+ * 开启重试后连接断开会自动重连
+**/
+class TcpClient : NonCopyable {
+    public:
+        TcpClient(EventLoop *loop, const InetAddress &serverAddr, const std::string &nameArg);
+        ~TcpClient(); // 需要在loop线程中析构, 或者loop已经退出
+
+        void connect();
+        void disconnect(); // 关闭写端, 等待对端关闭
+        void stop(); // 停止连接过程
+
+        // 当前连接, 未连接时为空, 线程安全
+        TcpConnectionPtr connection() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return connection_;
+        }
+
+        EventLoop* getLoop() const { return loop_; }
+        const std::string& name() const { return name_; }
+        // 指定源地址(端口一般为0), 需在connect之前调用
+        void setLocalAddress(const InetAddress &localAddr);
+        bool retry() const { return retry_; }
+        void enableRetry() { retry_ = true; }
+
+        // 设置回调, 需在connect之前调用
+        void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
+        void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
+        void setWriteCompleteCallback(const WriteCompleteCallback &cb) { writeCompleteCallback_ = cb; }
+#ifdef MUDUO_WITH_TLS
+        // 连接建立后先完成TLS握手, serverName用于SNI和证书主机名校验, 需在connect之前调用
+        void enableTls(const std::shared_ptr<TlsContext> &context, const std::string &serverName = std::string()) {
+            tlsContext_ = context;
+            tlsServerName_ = serverName;
+        }
+#endif
+
+    private:
+        void newConnection(int sockfd); // 在loop线程中调用
+        void removeConnection(const TcpConnectionPtr &conn); // 在loop线程中调用
+
+        EventLoop *loop_;
+        std::shared_ptr<Connector> connector_;
+        const std::string name_;
+        ConnectionCallback connectionCallback_;
+        MessageCallback messageCallback_;
+        WriteCompleteCallback writeCompleteCallback_;
+#ifdef MUDUO_WITH_TLS
+        std::shared_ptr<TlsContext> tlsContext_;
+        std::string tlsServerName_;
+#endif
+        std::atomic<bool> retry_; // 断开后是否重连
+        std::atomic<bool> connect_; // 是否处于连接状态(用户调用了connect且没有调用disconnect/stop)
+        uint64_t nextConnId_; // 只在loop中访问
+        mutable std::mutex mutex_;
+        TcpConnectionPtr connection_; // 由mutex_保护
+};
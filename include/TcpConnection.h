@@ -3,21 +3,34 @@
 #include <memory>
 #include <string>
 #include <atomic>
+#include <deque>
+#include <any>
+#include <utility>
 
 #include "NonCopyable.h"
 #include "InetAddress.h"
 #include "Callbacks.h"
 #include "Buffer.h"
 #include "Timestamp.h"
+#include "Socket.h"
+#include "Channel.h"
 
-class Channel;
 class EventLoop;
-class Socket;
+class WorkStealingThreadPool;
+class TlsContext;
+class TlsStream;
+
+// 只读的共享负载, 广播时所有连接的输出队列引用同一份数据, 不逐连接拷贝
+using SharedPayload = std::shared_ptr<const std::string>;
 
 class TcpConnection : NonCopyable, public std::enable_shared_from_this<TcpConnection> {
     public:
+        using OffloadWork = std::function<void()>; // 在计算线程池中执行的任务
+        using OffloadDoneCallback = std::function<void(const TcpConnectionPtr &)>; // 任务完成后在本连接的loop中执行
+
         TcpConnection(EventLoop *loop,
                       const std::string &name,
+                      uint64_t id,
                       int sockfd,
                       const InetAddress &localaddr,
                       const InetAddress &peeraddr);
@@ -25,14 +38,78 @@ class TcpConnection : NonCopyable, public std::enable_shared_from_this<TcpConnec
 
         EventLoop* getLoop() const { return loop_; }
         const std::string& name() const { return name_; }
+        uint64_t id() const { return id_; } // 连接id, 由TcpServer分配
         const InetAddress& localAddress() const { return localaddr_; }
         const InetAddress& peerAddress() const { return peeraddr_; }
         bool connected() const { return state_ == kConnected; }
 
-        // 发送数据
+        // 发送数据, 线程安全; 其他线程发送的消息进入本连接的无锁队列, loop一次取走全部并用一次writev发出, 顺序不变
         void send(const std::string &buf);
+        void send(std::string &&buf); // 其他线程发送时不拷贝消息
+        // 发送buf中的全部可读数据并清空buf, 在loop线程中调用时不产生额外拷贝
+        void send(Buffer *buf);
+        // 发送共享负载, 线程安全; 输出缓冲区为空时只引用payload直到写完, 否则拷贝到输出缓冲区之后以保持顺序
+        // 其他线程调用时与send进入同一个无锁队列, 两者交替调用也保持顺序
+        void sendShared(const SharedPayload &payload);
+        // 尚未发送的字节数, 包括引用的共享负载; 只能在loop线程中使用
+        size_t outputBytes() const { return outputBuffer_.readableBytes() + sharedBytes_; }
+        // 直接访问输入缓冲区, 只能在loop线程中使用; 未被消费的数据留在其中, 与下次读到的数据合并
+        Buffer* inputBuffer() { return &inputBuffer_; }
+        // 直接访问输出缓冲区, 只能在loop线程中使用; 上层协议把回复直接编码进去, 再调用flushOutput()发送
+        Buffer* outputBuffer() { return &outputBuffer_; }
+        // 发送输出缓冲区中尚未发送的数据, 只能在loop线程中调用
+        void flushOutput();
+        // 自动合并发送: loop线程中的send只追加到输出缓冲区, 本轮事件和functor处理完后每个连接只写一次
+        // 流水线请求逐条回复时系统调用数从每条一次降为每轮一次; 需要立即发送时调用flushOutput(); 在loop线程中调用
+        void setAutoCork(bool on) { autoCork_ = on; }
+        bool autoCork() const { return autoCork_; }
+        // 读配额: 每轮最多读取bytes字节, 0表示不限制(默认); 在loop线程中调用
+        // 用完配额的连接让出本轮, 未读的数据留在内核中, 水平触发的可读事件下一轮仍会返回, TLS已解密的数据由loop在下一轮继续读
+        // 防止少数大流量连接占满一轮, 使同一loop上的小请求连接等待
+        void setReadBudget(size_t bytes) { readBudget_ = bytes; }
+        size_t readBudget() const { return readBudget_; }
+        // 在MessageCallback中调用: 本轮的消息配额已用完, 输入缓冲区中剩余的数据下一轮再交给MessageCallback, 不必等新数据到达
+        // 推迟的数据处理完之前不再从socket读取, 由TCP流控限制对端; 对端关闭时剩余的数据在连接断开回调之前处理完
+        // 按消息数限制每轮处理量的编解码器使用, 见LengthHeaderCodec::setFrameBudget
+        void deferMessages();
         // 关闭连接
         void shutdown(); 
+        // 直接关闭连接, 不等待输出缓冲区发送完毕, 线程安全
+        void forceClose();
+        // 关闭Nagle算法, 请求/响应类协议降低小包延迟
+        void setTcpNoDelay(bool on) { socket_.setTcpNoDelay(on); }
+
+#ifdef MUDUO_WITH_TLS
+        // 在connectEstablished之前调用, 连接先完成TLS握手, 握手成功后才调用连接建立回调
+        // 握手期间连接处于kConnecting状态, send的数据被丢弃
+        void startTls(TlsContext *context, const std::string &serverName = std::string());
+        const TlsStream* tlsStream() const { return tls_.get(); } // 明文连接为空
+#endif
+
+        // 连接上下文, 上层协议(如HTTP)用来保存每个连接的解析状态, 只在loop中访问
+        void setContext(const std::any &context) { context_ = context; }
+        const std::any& getContext() const { return context_; }
+        std::any* getMutableContext() { return &context_; }
+
+        // 开始/停止读取该连接上的数据, 线程安全
+        void startRead();
+        void stopRead();
+        bool isReading() const { return reading_; }
+
+        // 读背压: 输出缓冲区超过highMark时自动停止读取, handleWrite发送到lowMark以下时恢复读取
+        // 默认作用于自身, highMark为0表示关闭; 在loop线程中调用
+        void setReadBackpressure(size_t highMark, size_t lowMark) {
+            backpressureHighMark_ = highMark;
+            backpressureLowMark_ = lowMark;
+        }
+        // 转发场景下设置数据来源的连接, 本连接输出积压时停止读取peer而不是自身
+        void setBackpressurePeer(const TcpConnectionPtr &peer) { backpressurePeer_ = peer; }
+
+        // 把work交给计算线程池执行, 完成后通过runInLoop在本连接的loop中调用done
+        // 同一连接的任务按提交顺序依次执行, done也按相同顺序调用
+        // 没有设置计算线程池时, work和done直接在loop中执行
+        void offload(OffloadWork work, OffloadDoneCallback done);
+        void setComputePool(const std::shared_ptr<WorkStealingThreadPool> &pool) { computePool_ = pool; }
 
         // 设置回调函数
         void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
@@ -58,20 +135,55 @@ class TcpConnection : NonCopyable, public std::enable_shared_from_this<TcpConnec
         void setState(StateE state) { state_ = state; }
 
         void handleRead(Timestamp receiveTime); // 可读事件的回调
+        void readAndDeliver(Timestamp receiveTime, int64_t readyAt); // 按读配额读取并调用MessageCallback
+        void deliverInput(Timestamp receiveTime, int64_t readyAt); // 调用MessageCallback, readyAt用于统计等待时间
+        void drainDeferredInput(); // 对端关闭前处理完被推迟的数据
+        void scheduleDeferredRead(int64_t deferredAt); // 下一轮继续处理让出本轮的连接
+        void continueDeferredRead(int64_t deferredAt);
         void handleWrite(); // 可写事件的回调
         void handleClose(); // 关闭事件的回调
         void handleError(); // 错误事件的回调
 
+        ssize_t readSocket(int *savedErrno); // 读到inputBuffer_, TLS连接读出的是解密后的数据
+        ssize_t writeSocket(const void *data, size_t len, int *savedErrno); // 明文和kTLS直接write, 否则经SSL_write加密
+        ssize_t writevSocket(const struct iovec *iov, int iovcnt, int *savedErrno); // 只用于明文和kTLS
+        ssize_t writeOutput(int *savedErrno); // 先发送共享负载再发送输出缓冲区, 并移除已发送的部分
+#ifdef MUDUO_WITH_TLS
+        void handshakeTls(); // 推进握手, 完成后进入kConnected状态
+#endif
         void sendInLoop(const void *data, size_t len);
+        void appendCorked(const void *data, size_t len); // 自动合并模式下的sendInLoop
+        void pushOutbound(std::string &&data, SharedPayload shared = SharedPayload()); // 其他线程的send/sendShared
+        void drainOutbound(); // 在loop中发送其他线程send的全部消息
+        void appendOutput(const char *data, size_t len); // 追加到输出缓冲区, 检查高水位
+        void checkHighWaterMark(size_t len); // 即将追加len字节, 越过高水位时排队高水位回调
+        void scheduleCorkedFlush(); // 自动合并模式下登记本轮结束时的flush
+        void sendSharedInLoop(const SharedPayload &payload);
+        void queueSharedOutput(const SharedPayload &payload, size_t offset); // 引用payload中offset之后的数据, 要求outputBuffer_为空
+        bool canShareOutput() const; // 输出队列能否引用共享负载, SSL_write加密的连接只能拷贝
         void shutdownInLoop();
+        void forceCloseInLoop();
+        void startReadInLoop();
+        void stopReadInLoop();
+        void pauseReadInLoop(); // 背压暂停读取, 可被多个来源叠加
+        void resumeReadInLoop(); // 撤销一次背压暂停
+        void updateReadingInLoop(); // 按reading_和readPauseCount_更新channel的读事件
+        void applyBackpressure(); // 输出积压, 暂停读取目标连接
+        void releaseBackpressure(); // 积压缓解或连接关闭, 恢复目标连接的读取
+        void offloadInLoop(const OffloadWork &work, const OffloadDoneCallback &done);
+        void submitNextOffload(); // 把队首任务提交给计算线程池
+        void offloadDone(); // 队首任务执行完毕, 在loop中调用
+        void updateBufferMetrics(); // 缓冲区容量变化时更新loop的内存统计
         
         EventLoop *loop_; // 该连接属于哪个EventLoop
         const std::string name_; // 连接名称，唯一标识该连接
+        const uint64_t id_; // 连接id
         std::atomic_int state_; // 连接状态
         bool reading_; // 标识是否正在读
 
-        std::unique_ptr<Socket> socket_; // 该TcpConnection管理一个socket
-        std::unique_ptr<Channel> channel_; // 该TcpConnection管理一个channel
+        // socket和channel直接内嵌, 与TcpConnection在同一次内存分配中构造
+        Socket socket_; // 该TcpConnection管理一个socket
+        Channel channel_; // 该TcpConnection管理一个channel
         
         const InetAddress localaddr_; // 本地地址
         const InetAddress peeraddr_; // 对端地址
@@ -84,8 +196,50 @@ class TcpConnection : NonCopyable, public std::enable_shared_from_this<TcpConnec
         CloseCallback closeCallback_; // 连接关闭的回调
         size_t highWaterMark_; // 高水位标记
 
+        size_t readBudget_; // 每轮最多读取的字节数, 0表示不限制
+        bool deferredReadScheduled_; // 已登记下一轮继续处理
+        bool deferredReadPending_; // 让出本轮后读取被暂停, 恢复读取时再继续处理
+        bool inputDeferred_; // MessageCallback推迟了输入缓冲区中的数据, 处理完之前不再读取新数据
+        uint64_t deliveredIteration_; // 最近一次调用MessageCallback的轮次
+
+        bool autoCork_; // 自动合并发送
+        bool flushScheduled_; // 已登记本轮结束时的flush
+
+        size_t backpressureHighMark_; // 输出缓冲区超过该值时停止读取, 0表示关闭读背压
+        size_t backpressureLowMark_; // 输出缓冲区降到该值以下时恢复读取
+        std::weak_ptr<TcpConnection> backpressurePeer_; // 背压作用的连接, 为空时作用于自身
+        std::weak_ptr<TcpConnection> pausedTarget_; // 当前被本连接暂停读取的连接
+        bool backpressureApplied_; // 本连接是否正在施加背压
+        int readPauseCount_; // 本连接被暂停读取的次数, 只在loop中访问
+
         // 读缓冲区
         Buffer inputBuffer_;
         // 写缓冲区
         Buffer outputBuffer_;
+        // 引用的共享负载及其已发送的字节数, 总在outputBuffer_之前发送: 只在outputBuffer_为空时追加
+        std::deque<std::pair<SharedPayload, size_t>> sharedOutput_;
+        size_t sharedBytes_; // sharedOutput_中尚未发送的字节数
+        size_t bufferBytes_; // 已计入loop统计的缓冲区内存
+        bool countedInLoop_; // 是否已计入loop的活跃连接数
+
+        std::any context_; // 连接上下文
+
+        // 其他线程send/sendShared的消息, 无锁栈: 生产者CAS压栈, loop一次取走整个栈后反转恢复发送顺序
+        struct OutboundMessage {
+            std::string data;
+            SharedPayload shared; // 非空时发送共享负载, data为空
+            OutboundMessage *next;
+
+            const char* bytes() const { return shared ? shared->data() : data.data(); }
+            size_t size() const { return shared ? shared->size() : data.size(); }
+        };
+        std::atomic<OutboundMessage *> outbound_;
+
+#ifdef MUDUO_WITH_TLS
+        std::unique_ptr<TlsStream> tls_; // 为空表示明文连接
+#endif
+
+        std::shared_ptr<WorkStealingThreadPool> computePool_; // 计算线程池
+        // 等待执行的计算任务, 只在loop中访问; 队首任务正在计算线程池中执行
+        std::deque<std::pair<OffloadWork, OffloadDoneCallback>> offloadQueue_;
 };
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <memory>
 #include <atomic>
 #include <unordered_map>
+#include <vector>
+#include <mutex>
 
 #include "NonCopyable.h"
 #include "TcpConnection.h"
@@ -12,26 +14,64 @@
 #include "Acceptor.h"
 #include "EventLoop.h"
 #include "EventLoopThreadPool.h"
+#include "WorkStealingThreadPool.h"
+#include "PoolAllocator.h"
 #include "Callbacks.h"
 #include "Buffer.h"
 
 class TcpServer{
     public:
         using ThreadInitCallback = std::function<void(EventLoop *)>;
+        using BroadcastFilter = std::function<bool(const TcpConnectionPtr &)>; // 返回true的连接才发送
         enum Option {
             kNoReusePort, // 不使用端口复用
             kReusePort, // 端口复用
         };
+        // 新连接分发到subloop的策略
+        enum SteeringPolicy {
+            kRoundRobin, // 轮询
+            kIncomingCpu, // 按SO_INCOMING_CPU分发到绑定在该CPU上的subloop, subloop依次绑定到进程允许的CPU, 收包中断应落在这些CPU上
+            kIncomingNapiId, // 按SO_INCOMING_NAPI_ID分发, 同一收包队列的连接落在同一subloop
+        };
+        // 分发命中统计
+        struct SteeringStats {
+            uint64_t hits; // 找到匹配的subloop
+            uint64_t misses; // 拿到了CPU/NAPI信息, 但没有匹配的subloop
+            uint64_t unavailable; // 内核没有提供CPU/NAPI信息
+        };
 
         TcpServer(EventLoop *loop, const InetAddress &listenaddr, const std::string &nameArg, Option option = kNoReusePort);
         ~TcpServer();
 
         EventLoop *getLoop() const { return loop_; }
+        const std::string& name() const { return name_; }
+        const std::string& ipPort() const { return ipPort_; }
 
         // 设置底层subloop的个数
         void setThreadNum(int numThreads);
+        // 设置计算线程池的线程数, 0表示不启用(TcpConnection::offload直接在loop中执行)
+        void setComputeThreadNum(int numThreads) { computeThreadNum_ = numThreads; }
+        // 获取计算线程池, 可用于查看队列深度和窃取统计
+        const std::shared_ptr<WorkStealingThreadPool>& computePool() const { return computePool_; }
+        // 设置新连接分发策略, 需在start之前调用
+        void setSteeringPolicy(SteeringPolicy policy);
+#ifdef MUDUO_WITH_TLS
+        // 所有新连接先完成TLS握手再调用连接建立回调, 需在start之前调用
+        void setTlsContext(const std::shared_ptr<TlsContext> &context) { tlsContext_ = context; }
+#endif
+        // 获取分发命中统计
+        SteeringStats steeringStats() const;
         // 启动服务器
         void start();
+        // 停止接受新连接, 监听socket保持打开(热重启时已交给新进程), 已有连接不受影响, 线程安全
+        void stopAccepting();
+        // 强制关闭所有连接, 线程安全
+        void forceCloseAll();
+        // 向所有连接(或filter选出的连接)发送同一份payload, 线程安全
+        // 每个loop只投递一个任务, 在该loop中逐个连接sendShared, 各连接的输出队列引用同一份payload而不拷贝
+        // filter在各连接所属的loop中调用; 返回投递任务的loop数
+        size_t broadcast(const SharedPayload &payload, const BroadcastFilter &filter = BroadcastFilter());
+        int listenFd() const { return acceptor_->fd(); }
 
         // 设置线程初始化回调
         void setThreadInitCallback(const ThreadInitCallback &cb) { threadInitCallback_ = cb; }
@@ -42,13 +82,43 @@ class TcpServer{
         // 设置写完成回调
         void setWriteCompleteCallback(const WriteCompleteCallback &cb) { writeCompleteCallback_ = cb; }
 
+        // 按连接id查找存活的连接, 线程安全, 不存在时返回空指针
+        TcpConnectionPtr getConnection(uint64_t id) const;
+        // 当前存活的连接数, 线程安全
+        size_t connectionCount() const;
+        // 所有loop的连接内存池统计之和
+        BlockPool::Stats connectionPoolStats() const;
+        // 各loop的运行统计, 第一个为mainLoop, 之后依次为subloop; 线程安全
+        std::vector<LoopStats> loopStats() const { return threadPool_->loopStats(); }
+        // 各loop的延迟分布, 顺序同loopStats; 合并后可求整个服务器的分位数
+        std::vector<LoopLatencyStats> loopLatencyStats() const { return threadPool_->loopLatencyStats(); }
+        // 慢回调阈值(秒), 作用于mainLoop和所有subloop, 0表示关闭; 需在start之前调用
+        void setSlowCallbackThreshold(double seconds) { slowCallbackThreshold_ = seconds; }
+        // 新连接开启自动合并发送, 见TcpConnection::setAutoCork; 需在start之前调用
+        void setAutoCork(bool on) { autoCork_ = on; }
+        // 新连接每轮的读配额(字节), 见TcpConnection::setReadBudget; 需在start之前调用
+        void setReadBudget(size_t bytes) { readBudget_ = bytes; }
+
     private:
         void newConnection(int sockfd, const InetAddress &peerAddr); // 有新连接到来
         void removeConnection(const TcpConnectionPtr &conn); // 连接关闭，移除连接
-        void removeConnectionInLoop(const TcpConnectionPtr &conn); // 在IO线程中移除连接
+        void addConnectionInLoop(size_t shard, const TcpConnectionPtr &conn); // 在IO线程中登记连接
+        void broadcastInLoop(size_t shard, const SharedPayload &payload, const BroadcastFilter &filter);
+        EventLoop* selectLoop(int sockfd); // 按分发策略为新连接选择subloop
+
+        using ConnectionMap = std::unordered_map<uint64_t, TcpConnectionPtr>;
+
+        /**
+         * 连接按所属的EventLoop分片保存, 每个subloop只增删自己分片中的连接, 不再经过mainLoop
+         * 连接id的高16位为分片下标, 低48位为序号, 任意线程都能按id直接定位到分片
+        **/
+        struct ConnectionShard {
+            mutable std::mutex mutex; // 保护connections, 只用于跨线程查找时的互斥
+            ConnectionMap connections;
+            std::shared_ptr<BlockPool> pool; // 该loop的连接内存池, TcpConnection关闭后内存回收到这里
+        };
+        static const int kSeqBits = 48; // 连接id低48位是shard内的序号, 高16位是shard下标
 
-        using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
-        
         EventLoop *loop_; // 该TcpServer属于mainReactor，负责监听新连接
 
         const std::string ipPort_; // 服务器监听的ip:port
@@ -57,14 +127,29 @@ class TcpServer{
         std::unique_ptr<Acceptor> acceptor_; // 运行在mainReactor，监听新连接
 
         std::shared_ptr<EventLoopThreadPool> threadPool_; // one loop per thread
+        int computeThreadNum_; // 计算线程池的线程数
+        std::shared_ptr<WorkStealingThreadPool> computePool_; // 计算线程池, 处理从回调中卸载的CPU密集任务
 
         ThreadInitCallback threadInitCallback_; // 线程初始化回调
         ConnectionCallback connectionCallback_; // 有新连接时的回调
         MessageCallback messageCallback_; // 有读写消息时的回调
         WriteCompleteCallback writeCompleteCallback_; // 消息发送完成后的回调
+#ifdef MUDUO_WITH_TLS
+        std::shared_ptr<TlsContext> tlsContext_; // 为空时为明文服务
+#endif
 
         std::atomic_int started_; // 原子操作，记录服务器是否启动
     
-        int nextConnId_; // 下一个连接的id
-        ConnectionMap connections_; // 保存所有的连接
+        uint64_t nextConnId_; // 下一个连接的序号, 只在mainLoop中访问
+        std::vector<std::unique_ptr<ConnectionShard>> shards_; // 每个loop一个分片, start时创建
+        std::unordered_map<EventLoop*, size_t> loopShards_; // loop => 分片下标
+
+        double slowCallbackThreshold_; // 慢回调阈值, 秒
+        bool autoCork_; // 新连接是否自动合并发送
+        size_t readBudget_; // 新连接每轮的读配额, 0表示不限制
+        SteeringPolicy steeringPolicy_; // 新连接分发策略
+        std::unordered_map<int, EventLoop*> napiLoops_; // NAPI ID => subloop, 只在mainLoop中访问
+        std::atomic<uint64_t> steerHits_;
+        std::atomic<uint64_t> steerMisses_;
+        std::atomic<uint64_t> steerUnavailable_;
 };
\ No newline at end of file
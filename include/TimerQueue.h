@@ -0,0 +1,57 @@
+#pragma once
+
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <atomic>
+#include <stdint.h>
+
+#include "NonCopyable.h"
+#include "Channel.h"
+
+class EventLoop;
+
+// 定时器id, 0表示无效
+using TimerId = uint64_t;
+
+/**
+ * 基于timerfd的定时器队列, 每个EventLoop一个, 定时器回调在loop线程中执行
+ * 定时器按(到期时间, id)排序, timerfd始终设置为最早到期的时间
+ * 时间使用CLOCK_MONOTONIC, 单位为微秒
+**/
+class TimerQueue : NonCopyable {
+    public:
+        using TimerCallback = std::function<void()>;
+
+        explicit TimerQueue(EventLoop *loop);
+        ~TimerQueue();
+
+        // 添加定时器, 线程安全; when为到期时间, interval大于0时为周期定时器
+        TimerId addTimer(TimerCallback cb, int64_t when, int64_t interval);
+        // 取消定时器, 线程安全; 可以在定时器自己的回调中取消
+        void cancel(TimerId timerId);
+
+        // 当前单调时钟时间(微秒)
+        static int64_t now();
+
+    private:
+        struct Timer {
+            TimerCallback callback;
+            int64_t when; // 到期时间
+            int64_t interval; // 周期, 0表示一次性定时器
+        };
+        using Entry = std::pair<int64_t, TimerId>; // (到期时间, id)
+
+        void addTimerInLoop(TimerId timerId, Timer &timer);
+        void cancelInLoop(TimerId timerId);
+        void handleRead(); // timerfd可读, 执行到期的定时器
+        void resetTimerfd(); // 按最早的到期时间重新设置timerfd
+
+        EventLoop *loop_;
+        const int timerfd_;
+        Channel timerfdChannel_;
+        std::atomic<TimerId> nextId_;
+        std::set<Entry> timers_; // 按到期时间排序, 只在loop中访问
+        std::unordered_map<TimerId, Timer> active_; // 未取消的定时器
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+#include "NonCopyable.h"
+
+typedef struct ssl_ctx_st SSL_CTX;
+
+/**
+ * TLS配置, 封装OpenSSL的SSL_CTX, 多个连接共享同一个TlsContext
+ * 开启kTLS时, 握手完成后由内核负责记录层加解密, TcpConnection的发送路径不经过OpenSSL
+ * 配置接口需在连接使用之前调用
+**/
+class TlsContext : NonCopyable {
+    public:
+        enum Mode { kServer, kClient };
+
+        explicit TlsContext(Mode mode);
+        ~TlsContext();
+
+        Mode mode() const { return mode_; }
+        SSL_CTX* nativeHandle() const { return ctx_; }
+
+        // 加载PEM格式的证书链和私钥, 服务端必须设置
+        bool useCertificateFile(const std::string &certFile, const std::string &keyFile);
+        bool useCertificate(const std::string &certPem, const std::string &keyPem); // 内存中的PEM
+        // 加载CA证书并校验对端证书, 客户端还会校验证书中的主机名
+        bool loadVerifyLocations(const std::string &caFile);
+        void setVerifyPeer(bool on);
+        bool verifyPeer() const { return verifyPeer_; }
+
+        // 握手完成后尝试开启kTLS, 默认开启; 内核或加密套件不支持时自动回退到用户态加解密
+        void setKtls(bool on);
+        bool ktls() const { return ktls_; }
+
+        // 当前内核是否支持TCP_ULP "tls"
+        static bool kernelSupportsKtls();
+
+    private:
+        const Mode mode_;
+        SSL_CTX *ctx_;
+        bool verifyPeer_;
+        bool ktls_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <sys/types.h>
+
+#include "NonCopyable.h"
+
+typedef struct ssl_st SSL;
+
+class Buffer;
+class TlsContext;
+
+/**
+ * 一个连接上的TLS状态, 非阻塞地完成握手并加解密应用数据
+ * 读写接口的返回值与read/write相同: 没有数据可读/内核缓冲区满时返回-1且savedErrno为EWOULDBLOCK
+ * 只在连接所属的loop线程中使用
+**/
+class TlsStream : NonCopyable {
+    public:
+        enum HandshakeState {
+            kHandshakeDone,
+            kHandshakeWantRead, // 等待可读事件后继续握手
+            kHandshakeWantWrite, // 等待可写事件后继续握手
+            kHandshakeFailed
+        };
+
+        // serverName只用于客户端, 设置SNI并在开启校验时检查证书主机名
+        TlsStream(TlsContext *context, int sockfd, const std::string &serverName = std::string());
+        ~TlsStream();
+
+        HandshakeState handshake();
+        bool established() const { return established_; }
+
+        // 握手完成后内核是否接管了发送/接收方向的记录层
+        bool ktlsSend() const { return ktlsSend_; }
+        bool ktlsRecv() const { return ktlsRecv_; }
+        const char* version() const;
+        const char* cipher() const;
+
+        // 读出所有已到达的明文追加到buf, 最多读maxBytes字节(0表示不限制), 返回0表示对端关闭
+        ssize_t read(Buffer *buf, int *savedErrno, size_t maxBytes = 0);
+        // 已解密但还未读出的明文, 这部分数据不会再触发可读事件
+        bool hasPending() const;
+        // 加密并发送, 返回已被接受的明文字节数
+        // 返回EWOULDBLOCK后, 下一次调用必须从未被接受的第一个字节开始且长度不能变短
+        ssize_t write(const void *data, size_t len, int *savedErrno);
+        // 发送close_notify
+        void shutdown();
+        // read读到了对端的close_notify, 已读出的数据处理完后应关闭连接
+        bool peerClosed() const { return peerClosed_; }
+
+    private:
+        SSL *ssl_;
+        bool established_;
+        bool ktlsSend_;
+        bool ktlsRecv_;
+        bool peerClosed_;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+
+#include "NonCopyable.h"
+#include "InetAddress.h"
+#include "UdpSocket.h"
+
+class EventLoop;
+class EventLoopThreadPool;
+
+/**
+ * UDP服务器, 每个loop一个绑定在同一地址上的SO_REUSEPORT socket, 由内核按四元组哈希分散数据报
+ * 收发都按批处理, 见UdpSocket
+**/
+class UdpServer : NonCopyable {
+    public:
+        using ThreadInitCallback = std::function<void(EventLoop *)>;
+        using DatagramCallback = UdpSocket::DatagramCallback;
+
+        UdpServer(EventLoop *loop, const InetAddress &listenAddr, const std::string &nameArg);
+        ~UdpServer();
+
+        EventLoop* getLoop() const { return loop_; }
+        const std::string& name() const { return name_; }
+
+        // 设置subloop的个数, 0表示只在loop中收发
+        void setThreadNum(int numThreads);
+        void setThreadInitCallback(const ThreadInitCallback &cb) { threadInitCallback_ = cb; }
+        // 需在start之前设置
+        void setOptions(const UdpSocket::Options &options) { options_ = options; }
+        void setDatagramCallback(const DatagramCallback &cb) { datagramCallback_ = cb; }
+        void start();
+
+        // 所有socket的统计之和, 线程安全
+        UdpSocket::Stats stats() const;
+
+    private:
+        EventLoop *loop_;
+        const InetAddress listenAddr_;
+        const std::string name_;
+        std::unique_ptr<EventLoopThreadPool> threadPool_;
+        ThreadInitCallback threadInitCallback_;
+        UdpSocket::Options options_;
+        DatagramCallback datagramCallback_;
+        std::atomic_int started_;
+        std::vector<UdpSocket *> sockets_; // 每个loop一个, 在各自的loop中析构
+};
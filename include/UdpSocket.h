@@ -0,0 +1,122 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <atomic>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <stdint.h>
+
+#include "NonCopyable.h"
+#include "InetAddress.h"
+#include "Timestamp.h"
+#include "Channel.h"
+
+class EventLoop;
+class UdpSocket;
+
+// 收到的一个数据报, data指向UdpSocket的接收缓冲区, 只在回调期间有效
+struct UdpDatagram {
+    std::string_view data;
+    InetAddress peer;
+};
+
+/**
+ * 一个loop上的UDP socket, 收发都按批处理
+ * 接收: recvmmsg一次读取最多batchSize个数据报; 开启UDP_GRO后内核合并的大包按段长拆回数据报
+ * 发送: send先排队, 回调返回后(或队列满时)用sendmmsg一次发出;
+ *       发往同一对端的连续等长数据报合并为一条消息, 通过UDP_SEGMENT(GSO)交给内核分段
+ * 所有接口只能在所属的loop线程中调用
+**/
+class UdpSocket : NonCopyable {
+    public:
+        // 一批数据报的回调, 在loop线程中调用; 回调中的send在回调返回后统一发送
+        using DatagramCallback = std::function<void(UdpSocket *, const UdpDatagram *datagrams, size_t count, Timestamp)>;
+
+        struct Options {
+            int batchSize = 64; // 一次recvmmsg/sendmmsg的最大消息数
+            size_t maxDatagramSize = 2048; // 不开启GRO时每个接收槽的大小
+            bool gro = true; // 开启UDP_GRO, 接收槽扩大为64K
+            bool gso = true; // 发送时使用UDP_SEGMENT合并
+            size_t maxQueuedBytes = 4 * 1024 * 1024; // 发送队列上限, 超过后丢弃新数据报
+            int socketBufferBytes = 0; // SO_RCVBUF/SO_SNDBUF, 0表示使用系统默认值
+        };
+
+        struct Stats {
+            uint64_t datagramsReceived;
+            uint64_t recvCalls; // recvmmsg调用次数
+            uint64_t datagramsSent;
+            uint64_t sendCalls; // sendmmsg调用次数
+            uint64_t sendDrops; // 发送队列满或发送失败丢弃的数据报
+        };
+
+        // sockfd为已绑定的非阻塞UDP socket, 由UdpSocket负责关闭
+        UdpSocket(EventLoop *loop, int sockfd, const Options &options);
+        ~UdpSocket();
+
+        EventLoop* getLoop() const { return loop_; }
+        int fd() const { return sockfd_; }
+        bool groEnabled() const { return groEnabled_; }
+        bool gsoEnabled() const { return gsoEnabled_; } // 发送路径不支持GSO时在第一次失败后关闭
+
+        void setDatagramCallback(const DatagramCallback &cb) { datagramCallback_ = cb; }
+        void start(); // 开始监听可读事件
+        void stop();
+
+        // 排队发送一个数据报, 在本轮回调或本轮loop结束时统一发送
+        void send(const InetAddress &peer, std::string_view data);
+        // 立即发送队列中的所有数据报, 内核缓冲区满时剩余部分等可写事件再发送
+        void flush();
+
+        // 线程安全
+        Stats stats() const;
+
+    private:
+        // 排队中的数据报, 数据在sendBuffer_中
+        struct Outgoing {
+            size_t offset;
+            size_t len;
+            sockaddr_in6 peer; // 足够存放IPv4或IPv6地址
+            socklen_t peerLen;
+        };
+
+        void handleRead(Timestamp receiveTime);
+        void handleWrite();
+        void compactSendQueue(); // 部分发送后丢弃已发送的数据报
+
+        EventLoop *loop_;
+        const int sockfd_;
+        Channel channel_;
+        const Options options_;
+        bool groEnabled_;
+        bool gsoEnabled_; // 只在loop线程中修改
+        size_t slotSize_; // 每个接收槽的大小
+        DatagramCallback datagramCallback_;
+        bool inCallback_; // 正在执行回调, 回调返回后统一发送
+        bool flushQueued_; // 已经安排了在本轮loop结束时发送
+
+        // 接收用的数组, 构造时分配, 之后复用
+        std::vector<char> recvBuffer_;
+        std::vector<mmsghdr> recvMsgs_;
+        std::vector<iovec> recvIovecs_;
+        std::vector<sockaddr_in6> recvAddrs_;
+        std::vector<char> recvControl_;
+        std::vector<UdpDatagram> datagrams_;
+
+        // 发送队列
+        std::string sendBuffer_;
+        std::vector<Outgoing> outgoing_;
+        size_t sent_; // outgoing_中已发送的数据报数
+        std::vector<mmsghdr> sendMsgs_;
+        std::vector<iovec> sendIovecs_;
+        std::vector<char> sendControl_;
+        std::vector<size_t> msgDatagrams_; // 每条消息包含的数据报数
+
+        std::atomic<uint64_t> datagramsReceived_;
+        std::atomic<uint64_t> recvCalls_;
+        std::atomic<uint64_t> datagramsSent_;
+        std::atomic<uint64_t> sendCalls_;
+        std::atomic<uint64_t> sendDrops_;
+};
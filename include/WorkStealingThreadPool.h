@@ -0,0 +1,72 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "NonCopyable.h"
+#include "Thread.h"
+
+/**
+ * 计算线程池, 用于把MessageCallback中的CPU密集型任务(解析/压缩/加密等)移出IO线程
+ * 每个worker有自己的双端队列: 本worker提交的任务从队尾入队出队(LIFO, 缓存友好),
+ * 空闲worker从其他worker的队头窃取任务(FIFO)
+ * 外部线程(如IO线程)提交的任务进入共享的注入队列, 空闲worker按提交顺序取走一批放入自己的队列,
+ * 自己先执行较早的任务, 其余的可被其他worker窃取; 先提交的连接不会被后来的饿死
+**/
+class WorkStealingThreadPool : NonCopyable {
+    public:
+        using Task = std::function<void()>;
+
+        // 运行统计
+        struct Stats {
+            size_t queueDepth; // 所有队列中待执行的任务数
+            size_t injectorDepth; // 注入队列中待执行的任务数
+            uint64_t executed; // 已执行的任务数
+            uint64_t steals; // 从其他worker窃取的任务数
+            std::vector<size_t> workerDepths; // 每个worker队列的深度
+        };
+
+        explicit WorkStealingThreadPool(const std::string &name = std::string("ComputePool"));
+        ~WorkStealingThreadPool();
+
+        void start(int numThreads); // 启动numThreads个worker
+        void stop(); // 停止并等待所有worker退出, 已提交的任务先执行完; 停止后不能再次启动
+
+        // 提交任务, 线程安全; 线程池未运行时直接在调用线程中执行
+        void submit(Task task);
+
+        Stats stats() const;
+        bool running() const { return running_; }
+        const std::string& name() const { return name_; }
+
+    private:
+        struct Worker {
+            mutable std::mutex mutex; // 保护tasks
+            std::deque<Task> tasks; // 该worker的任务队列
+            std::atomic<uint64_t> executed{0};
+            std::atomic<uint64_t> steals{0};
+            std::unique_ptr<Thread> thread;
+        };
+
+        void workerFunc(size_t index); // worker线程函数
+        bool popLocal(size_t index, Task *task); // 从自己队尾取任务
+        bool popInjector(size_t index, Task *task); // 从注入队列队头取一批任务, 执行第一个, 其余放入自己的队列
+        bool steal(size_t index, Task *task); // 从其他worker队头窃取任务
+
+        std::string name_;
+        std::atomic<bool> running_;
+        std::vector<std::unique_ptr<Worker>> workers_;
+        mutable std::mutex injectorMutex_; // 保护injector_, 以及submit/stop对running_的检查和修改
+        std::deque<Task> injector_; // 外部线程提交的任务, FIFO
+
+        std::atomic<size_t> pending_; // 所有队列中待执行的任务数
+        std::atomic<int> idle_; // 正在休眠的worker数
+        std::mutex sleepMutex_;
+        std::condition_variable sleepCond_;
+};
@@ -3,13 +3,21 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
 
 #include "Acceptor.h"
 #include "Logger.h"
 #include "InetAddress.h"
 
-static int createNonblocking() {
-    int sockfd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+static int createNonblocking(const InetAddress &listenaddr) {
+    if (!listenaddr.valid()) {
+        LOG_FATAL("%s:%s:%d invalid listen address\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+    sa_family_t family = listenaddr.family();
+    // Unix域socket的protocol只能为0
+    int sockfd = ::socket(family, SOCK_STREAM, family == AF_UNIX ? 0 : IPPROTO_TCP);
     if (sockfd < 0) {
         LOG_FATAL("%s:%s:%d listen socket create err:%d\n",
                   __FILE__, __FUNCTION__, __LINE__, errno);
@@ -30,14 +38,65 @@ static int createNonblocking() {
     return sockfd;
 }
 
+// 从旧进程接管、还没有被Acceptor使用的监听socket
+static std::mutex g_inheritedMutex;
+static std::vector<int> g_inheritedSockets;
+
+void Acceptor::addInheritedSocket(int sockfd) {
+    std::lock_guard<std::mutex> lock(g_inheritedMutex);
+    g_inheritedSockets.push_back(sockfd);
+}
+
+int Acceptor::takeInheritedSocket(const InetAddress &listenaddr) {
+    std::lock_guard<std::mutex> lock(g_inheritedMutex);
+    for (auto it = g_inheritedSockets.begin(); it != g_inheritedSockets.end(); ++it) {
+        sockaddr_storage local;
+        socklen_t len = sizeof local;
+        ::memset(&local, 0, sizeof local);
+        if (::getsockname(*it, (sockaddr *)&local, &len) == 0
+            && InetAddress((sockaddr *)&local, len) == listenaddr) {
+            int sockfd = *it;
+            g_inheritedSockets.erase(it);
+            return sockfd;
+        }
+    }
+    return -1;
+}
+
+size_t Acceptor::closeUnusedInheritedSockets() {
+    std::lock_guard<std::mutex> lock(g_inheritedMutex);
+    size_t n = g_inheritedSockets.size();
+    for (int sockfd : g_inheritedSockets) {
+        ::close(sockfd);
+    }
+    g_inheritedSockets.clear();
+    return n;
+}
+
 Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenaddr, bool reuseport)
     : loop_(loop),
-      acceptSocket_(createNonblocking()), // 创建非阻塞socket
+      inheritedFd_(takeInheritedSocket(listenaddr)),
+      acceptSocket_(inheritedFd_ >= 0 ? inheritedFd_ : createNonblocking(listenaddr)), // 创建非阻塞socket
       acceptChannel_(loop, acceptSocket_.fd()),
       listenning_(false) {
-    acceptSocket_.setReuseAddr(true); // 设置地址重用
-    acceptSocket_.setReusePort(reuseport); // 设置端口重用
-    acceptSocket_.bindAddress(listenaddr); // 绑定地址
+    if (listenaddr.isUnix()) {
+        // 文件系统路径在进程退出后仍然存在, 绑定前删除上次遗留的socket文件
+        std::string path = listenaddr.toIp();
+        if (!path.empty() && path[0] != '@') {
+            if (inheritedFd_ < 0) {
+                ::unlink(path.c_str());
+            }
+            unixPath_ = path;
+        }
+    } else if (inheritedFd_ < 0) {
+        acceptSocket_.setReuseAddr(true); // 设置地址重用
+        acceptSocket_.setReusePort(reuseport); // 设置端口重用
+    }
+    if (inheritedFd_ < 0) {
+        acceptSocket_.bindAddress(listenaddr); // 绑定地址
+    } else {
+        LOG_INFO("Acceptor inherited listen socket fd=%d %s\n", inheritedFd_, listenaddr.toIpPort().c_str());
+    }
 
     // 设置有新连接到来时的回调
     acceptChannel_.setReadCallback(std::bind(&Acceptor::handleRead, this));
@@ -46,6 +105,9 @@ Acceptor::Acceptor(EventLoop *loop, const InetAddress &listenaddr, bool reusepor
 Acceptor::~Acceptor() {
     acceptChannel_.disableAll(); // 禁用所有事件
     acceptChannel_.remove(); // 从Poller中删除
+    if (!unixPath_.empty()) {
+        ::unlink(unixPath_.c_str()); // 删除绑定时创建的socket文件
+    }
 }
 
 void Acceptor::listen() {
@@ -54,6 +116,13 @@ void Acceptor::listen() {
     acceptChannel_.enableReading(); // acceptChannel_注册到Poller中，监听读事件
 }
 
+void Acceptor::stopListening() {
+    listenning_ = false;
+    acceptChannel_.disableAll();
+    // 监听socket已交给新进程, 本进程析构时不能删除socket文件
+    unixPath_.clear();
+}
+
 // listenfd有读事件发生，表示有新用户连接
 void Acceptor::handleRead() {
     InetAddress peeraddr;
@@ -10,7 +10,7 @@
  * 方式追加入buffer_。既考虑了避免系统调用带来开销，又不影响数据的接收。
 **/
 
-ssize_t Buffer::readFd(int fd, int* savedErrno) {
+ssize_t Buffer::readFd(int fd, int* savedErrno, size_t maxBytes) {
     char extrabuf[65536] = {0}; // 栈上空间 64k
     /*
     struct iovec {
@@ -20,16 +20,17 @@ ssize_t Buffer::readFd(int fd, int* savedErrno) {
     */
     struct iovec vec[2]; // 使用iovec开辟两个缓冲区
     const size_t writable = writableBytes();
+    const size_t limit = maxBytes > 0 ? maxBytes : SIZE_MAX;
 
     // 第一块缓冲区指向可写空间
     vec[0].iov_base = begin() + writeIndex_;
-    vec[0].iov_len = writable;
+    vec[0].iov_len = std::min(writable, limit);
     // 第二块缓冲区指向栈上空间
     vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof extrabuf;
+    vec[1].iov_len = std::min(sizeof extrabuf, limit - vec[0].iov_len);
 
     // 当缓冲区空间足够时，只读入buffer_，否则读入buffer_和栈上空间
-    const int iovcnt = (writable < sizeof extrabuf) ? 2 : 1;
+    const int iovcnt = (writable < sizeof extrabuf && vec[1].iov_len > 0) ? 2 : 1;
     const ssize_t n = ::readv(fd, vec, iovcnt);
     if (n < 0) {
         *savedErrno = errno;
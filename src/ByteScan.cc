@@ -0,0 +1,203 @@
+#include <string.h>
+
+#include "ByteScan.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define MUDUO_BYTESCAN_X86 1
+#endif
+
+namespace ByteScan {
+
+static const size_t kMaxSimdSet = 16; // 向量实现支持的字符集合大小上限
+
+const char* findCRLFScalar(const char *begin, const char *end) {
+    for (const char *p = begin; p + 1 < end; ++p) {
+        if (p[0] == '\r' && p[1] == '\n') {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+const char* findAnyOfScalar(const char *begin, const char *end, const char *set, size_t setLen) {
+    bool table[256];
+    ::memset(table, 0, sizeof table);
+    for (size_t i = 0; i < setLen; ++i) {
+        table[static_cast<unsigned char>(set[i])] = true;
+    }
+    for (const char *p = begin; p < end; ++p) {
+        if (table[static_cast<unsigned char>(*p)]) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+#ifdef MUDUO_BYTESCAN_X86
+
+// 每次比较16字节: 当前位置是'\r'且下一个位置是'\n'
+const char* findCRLFSse2(const char *begin, const char *end) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char *p = begin;
+    while (end - p >= 17) {
+        __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1));
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(cur, cr), _mm_cmpeq_epi8(next, lf)));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return findCRLFScalar(p, end);
+}
+
+// AVX2实现只在确认CPU支持后调用
+__attribute__((target("avx2")))
+static const char* findCRLFAvx2Impl(const char *begin, const char *end) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char *p = begin;
+    while (end - p >= 33) {
+        __m256i cur = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(cur, cr), _mm256_cmpeq_epi8(next, lf))));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return findCRLFSse2(p, end);
+}
+
+const char* findAnyOfSse2(const char *begin, const char *end, const char *set, size_t setLen) {
+    if (setLen == 0 || setLen > kMaxSimdSet) {
+        return findAnyOfScalar(begin, end, set, setLen);
+    }
+    __m128i needles[kMaxSimdSet];
+    for (size_t i = 0; i < setLen; ++i) {
+        needles[i] = _mm_set1_epi8(set[i]);
+    }
+    const char *p = begin;
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i hit = _mm_cmpeq_epi8(v, needles[0]);
+        for (size_t i = 1; i < setLen; ++i) {
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, needles[i]));
+        }
+        int mask = _mm_movemask_epi8(hit);
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return findAnyOfScalar(p, end, set, setLen);
+}
+
+__attribute__((target("avx2")))
+static const char* findAnyOfAvx2Impl(const char *begin, const char *end, const char *set, size_t setLen) {
+    if (setLen == 0 || setLen > kMaxSimdSet) {
+        return findAnyOfScalar(begin, end, set, setLen);
+    }
+    __m256i needles[kMaxSimdSet];
+    for (size_t i = 0; i < setLen; ++i) {
+        needles[i] = _mm256_set1_epi8(set[i]);
+    }
+    const char *p = begin;
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i hit = _mm256_cmpeq_epi8(v, needles[0]);
+        for (size_t i = 1; i < setLen; ++i) {
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, needles[i]));
+        }
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return findAnyOfSse2(p, end, set, setLen);
+}
+
+static bool detectAvx2() {
+    __builtin_cpu_init(); // 可能在静态初始化阶段调用, 需要先初始化CPU信息
+    return __builtin_cpu_supports("avx2");
+}
+
+bool hasAvx2() {
+    static const bool supported = detectAvx2();
+    return supported;
+}
+
+// 直接入口在不支持AVX2的CPU上退化为标量实现, 避免SIGILL
+const char* findCRLFAvx2(const char *begin, const char *end) {
+    return hasAvx2() ? findCRLFAvx2Impl(begin, end) : findCRLFScalar(begin, end);
+}
+
+const char* findAnyOfAvx2(const char *begin, const char *end, const char *set, size_t setLen) {
+    return hasAvx2() ? findAnyOfAvx2Impl(begin, end, set, setLen) : findAnyOfScalar(begin, end, set, setLen);
+}
+
+#else
+
+bool hasAvx2() { return false; }
+const char* findCRLFSse2(const char *begin, const char *end) { return findCRLFScalar(begin, end); }
+const char* findCRLFAvx2(const char *begin, const char *end) { return findCRLFScalar(begin, end); }
+const char* findAnyOfSse2(const char *begin, const char *end, const char *set, size_t setLen) {
+    return findAnyOfScalar(begin, end, set, setLen);
+}
+const char* findAnyOfAvx2(const char *begin, const char *end, const char *set, size_t setLen) {
+    return findAnyOfScalar(begin, end, set, setLen);
+}
+
+#endif
+
+using FindCRLFFunc = const char* (*)(const char *, const char *);
+using FindAnyOfFunc = const char* (*)(const char *, const char *, const char *, size_t);
+
+// 运行时选择实现, 程序启动时确定一次
+struct Kernels {
+    FindCRLFFunc findCRLF;
+    FindAnyOfFunc findAnyOf;
+    const char *name;
+
+    Kernels() {
+#ifdef MUDUO_BYTESCAN_X86
+        if (hasAvx2()) {
+            findCRLF = findCRLFAvx2Impl;
+            findAnyOf = findAnyOfAvx2Impl;
+            name = "avx2";
+        } else {
+            // x86_64都支持SSE2
+            findCRLF = findCRLFSse2;
+            findAnyOf = findAnyOfSse2;
+            name = "sse2";
+        }
+#else
+        findCRLF = findCRLFScalar;
+        findAnyOf = findAnyOfScalar;
+        name = "scalar";
+#endif
+    }
+};
+
+static const Kernels &kernels() {
+    static const Kernels k;
+    return k;
+}
+
+const char* findCRLF(const char *begin, const char *end) {
+    return kernels().findCRLF(begin, end);
+}
+
+const char* findAnyOf(const char *begin, const char *end, const char *set, size_t setLen) {
+    return kernels().findAnyOf(begin, end, set, setLen);
+}
+
+const char* implName() {
+    return kernels().name;
+}
+
+}
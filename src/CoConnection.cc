@@ -0,0 +1,187 @@
+#include <string.h>
+
+#include "CoConnection.h"
+#include "ByteScan.h"
+#include "EventLoop.h"
+
+struct CoConnection::State {
+    TcpConnectionPtr conn;
+    bool closed = false;
+    ReadAwaiter *reader = nullptr; // 等待中的读
+    WriteAwaiter *writer = nullptr; // 等待中的写
+
+    ~State() {
+        if (!closed) {
+            conn->shutdown(); // handler已结束
+        }
+    }
+
+    void onMessage() {
+        if (reader && reader->tryComplete()) {
+            std::coroutine_handle<> handle = reader->handle_;
+            reader = nullptr;
+            handle.resume();
+        }
+    }
+
+    void onWriteComplete() {
+        // 之前一次直接发送完成的写也会排队通知, 只有输出缓冲区真正发送完才恢复
+        if (writer && conn->outputBytes() == 0) {
+            WriteAwaiter *w = writer;
+            writer = nullptr;
+            w->ok_ = true;
+            w->handle_.resume();
+        }
+    }
+
+    void onClose() {
+        closed = true;
+        ReadAwaiter *r = reader;
+        WriteAwaiter *w = writer;
+        reader = nullptr;
+        writer = nullptr;
+        if (r) {
+            r->tryComplete();
+            r->handle_.resume();
+        }
+        if (w) {
+            w->ok_ = false;
+            w->handle_.resume();
+        }
+    }
+};
+
+ConnectionCallback CoConnection::connectionCallback(Handler handler) {
+    return [handler](const TcpConnectionPtr &conn) {
+        if (conn->connected()) {
+            std::shared_ptr<State> state = std::make_shared<State>();
+            state->conn = conn;
+            std::weak_ptr<State> weakState(state);
+            conn->setContext(weakState); // 断开时据此找到State
+            conn->setMessageCallback([weakState](const TcpConnectionPtr &, Buffer *, Timestamp) {
+                if (std::shared_ptr<State> s = weakState.lock()) {
+                    s->onMessage();
+                }
+            });
+            conn->setWriteCompleteCallback([weakState](const TcpConnectionPtr &) {
+                if (std::shared_ptr<State> s = weakState.lock()) {
+                    s->onWriteComplete();
+                }
+            });
+            coSpawn(handler(CoConnection(state)));
+        } else {
+            std::weak_ptr<State> *weakState = std::any_cast<std::weak_ptr<State>>(conn->getMutableContext());
+            if (weakState) {
+                if (std::shared_ptr<State> s = weakState->lock()) {
+                    s->onClose();
+                }
+            }
+        }
+    };
+}
+
+const TcpConnectionPtr& CoConnection::connection() const {
+    return state_->conn;
+}
+
+bool CoConnection::connected() const {
+    return !state_->closed;
+}
+
+void CoConnection::shutdown() {
+    state_->conn->shutdown();
+}
+
+void CoConnection::forceClose() {
+    state_->conn->forceClose();
+}
+
+bool CoConnection::ReadAwaiter::tryComplete() {
+    Buffer *buf = state_->conn->inputBuffer();
+    if (delimiter_.empty()) {
+        if (buf->readableBytes() >= length_) {
+            result_ = buf->retrieveAsString(length_);
+            return true;
+        }
+    } else {
+        const char *begin = buf->peek();
+        const char *end = begin + buf->readableBytes();
+        const char *found = nullptr;
+        if (delimiter_ == "\r\n") {
+            found = ByteScan::findCRLF(begin + scanned_, end);
+        } else {
+            found = static_cast<const char *>(::memmem(begin + scanned_, end - begin - scanned_,
+                                                       delimiter_.data(), delimiter_.size()));
+        }
+        if (found) {
+            size_t len = found - begin + delimiter_.size();
+            result_.assign(begin, len);
+            buf->retrieve(len);
+            return true;
+        }
+        // 分隔符可能跨越两次读到的数据, 保留末尾delimiter_.size() - 1字节下次重新查找
+        size_t readable = buf->readableBytes();
+        scanned_ = readable >= delimiter_.size() ? readable - delimiter_.size() + 1 : 0;
+    }
+    if (state_->closed) {
+        result_.clear(); // 数据不足且不会再有新数据
+        return true;
+    }
+    return false;
+}
+
+bool CoConnection::ReadAwaiter::await_ready() {
+    return state_->conn->getLoop()->isInLoopThread() && tryComplete();
+}
+
+void CoConnection::ReadAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    EventLoop *loop = state_->conn->getLoop();
+    if (loop->isInLoopThread()) {
+        state_->reader = this;
+        return;
+    }
+    // 协程在其他loop中, 转回连接的loop再读
+    loop->queueInLoop([this]() {
+        if (tryComplete()) {
+            handle_.resume();
+        } else {
+            state_->reader = this;
+        }
+    });
+}
+
+bool CoConnection::WriteAwaiter::start() {
+    if (state_->closed) {
+        ok_ = false;
+        return true;
+    }
+    TcpConnection *conn = state_->conn.get();
+    conn->outputBuffer()->append(data_.data(), data_.size());
+    conn->flushOutput();
+    if (conn->outputBytes() == 0) {
+        ok_ = true;
+        return true;
+    }
+    return false;
+}
+
+bool CoConnection::WriteAwaiter::await_ready() {
+    return state_->conn->getLoop()->isInLoopThread() && start();
+}
+
+void CoConnection::WriteAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    EventLoop *loop = state_->conn->getLoop();
+    if (loop->isInLoopThread()) {
+        state_->writer = this; // start()已在await_ready中调用
+        return;
+    }
+    loop->queueInLoop([this]() {
+        if (start()) {
+            handle_.resume();
+        } else {
+            state_->writer = this;
+        }
+    });
+}
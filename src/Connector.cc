@@ -0,0 +1,220 @@
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+#include "Connector.h"
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+static int createNonblocking(sa_family_t family) {
+    int sockfd = ::socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, family == AF_UNIX ? 0 : IPPROTO_TCP);
+    if (sockfd < 0) {
+        LOG_FATAL("%s:%s:%d socket create err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+    return sockfd;
+}
+
+static int getSocketError(int sockfd) {
+    int optval = 0;
+    socklen_t optlen = sizeof optval;
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
+        return errno;
+    }
+    return optval;
+}
+
+// 本地端口和目标端口相同时, 内核可能让socket连接到自己
+// Unix域socket的客户端地址是未命名的, 不会出现自连接
+static bool isSelfConnect(int sockfd) {
+    sockaddr_storage local, peer;
+    socklen_t localLen = sizeof local;
+    socklen_t peerLen = sizeof peer;
+    ::memset(&local, 0, sizeof local);
+    ::memset(&peer, 0, sizeof peer);
+    ::getsockname(sockfd, (sockaddr *)&local, &localLen);
+    ::getpeername(sockfd, (sockaddr *)&peer, &peerLen);
+    if (local.ss_family == AF_INET) {
+        const sockaddr_in *l = (const sockaddr_in *)&local;
+        const sockaddr_in *p = (const sockaddr_in *)&peer;
+        return l->sin_port == p->sin_port && l->sin_addr.s_addr == p->sin_addr.s_addr;
+    } else if (local.ss_family == AF_INET6) {
+        const sockaddr_in6 *l = (const sockaddr_in6 *)&local;
+        const sockaddr_in6 *p = (const sockaddr_in6 *)&peer;
+        return l->sin6_port == p->sin6_port
+            && ::memcmp(&l->sin6_addr, &p->sin6_addr, sizeof l->sin6_addr) == 0;
+    }
+    return false;
+}
+
+Connector::Connector(EventLoop *loop, const InetAddress &serverAddr)
+    : loop_(loop),
+      serverAddr_(serverAddr),
+      bindLocal_(false),
+      connect_(false),
+      state_(kDisconnected),
+      retryDelayMs_(kInitRetryDelayMs),
+      retryTimer_(0) {
+}
+
+Connector::~Connector() {
+    if (channel_) {
+        LOG_ERROR("Connector::dtor[%p] channel is not reset\n", this);
+    }
+}
+
+void Connector::start() {
+    connect_ = true;
+    loop_->runInLoop(std::bind(&Connector::startInLoop, shared_from_this()));
+}
+
+void Connector::startInLoop() {
+    if (connect_) {
+        connect();
+    }
+}
+
+void Connector::stop() {
+    connect_ = false;
+    loop_->queueInLoop(std::bind(&Connector::stopInLoop, shared_from_this()));
+}
+
+void Connector::stopInLoop() {
+    if (retryTimer_ != 0) {
+        loop_->cancel(retryTimer_);
+        retryTimer_ = 0;
+    }
+    if (state_ == kConnecting) {
+        setState(kDisconnected);
+        int sockfd = removeAndResetChannel();
+        ::close(sockfd);
+    }
+}
+
+void Connector::restart() {
+    setState(kDisconnected);
+    retryDelayMs_ = kInitRetryDelayMs;
+    connect_ = true;
+    startInLoop();
+}
+
+void Connector::connect() {
+    if (!serverAddr_.valid()) {
+        LOG_ERROR("Connector::connect invalid server address\n");
+        return;
+    }
+    int sockfd = createNonblocking(serverAddr_.family());
+    if (bindLocal_) {
+#ifdef IP_BIND_ADDRESS_NO_PORT
+        // 端口推迟到connect时按四元组分配, 每个源IP都有完整的临时端口范围
+        int on = 1;
+        ::setsockopt(sockfd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &on, sizeof on);
+#endif
+        if (::bind(sockfd, localAddr_.getSockAddr(), localAddr_.getSockLen()) < 0) {
+            int savedErrno = errno;
+            LOG_ERROR("Connector::connect bind %s error:%d\n", localAddr_.toIpPort().c_str(), savedErrno);
+            if (savedErrno == EADDRINUSE || savedErrno == EADDRNOTAVAIL) {
+                retry(sockfd);
+            } else {
+                ::close(sockfd);
+            }
+            return;
+        }
+    }
+    int ret = ::connect(sockfd, serverAddr_.getSockAddr(), serverAddr_.getSockLen());
+    int savedErrno = (ret == 0) ? 0 : errno;
+    switch (savedErrno) {
+        case 0:
+        case EINPROGRESS:
+        case EINTR:
+        case EISCONN:
+            connecting(sockfd);
+            break;
+
+        case EAGAIN:
+        case EADDRINUSE:
+        case EADDRNOTAVAIL:
+        case ECONNREFUSED:
+        case ENETUNREACH:
+            retry(sockfd); // 暂时性错误, 稍后重试
+            break;
+
+        default:
+            LOG_ERROR("Connector::connect error:%d\n", savedErrno);
+            ::close(sockfd);
+            break;
+    }
+}
+
+void Connector::connecting(int sockfd) {
+    setState(kConnecting);
+    channel_.reset(new Channel(loop_, sockfd));
+    channel_->setWriteCallback(std::bind(&Connector::handleWrite, this));
+    channel_->setErrorCallback(std::bind(&Connector::handleError, this));
+    channel_->enableWriting(); // 连接完成或失败时sockfd可写
+}
+
+int Connector::removeAndResetChannel() {
+    channel_->disableAll();
+    channel_->remove();
+    int sockfd = channel_->fd();
+    // 当前可能正在channel的回调中, 不能直接析构channel
+    loop_->queueInLoop(std::bind(&Connector::resetChannel, shared_from_this()));
+    return sockfd;
+}
+
+void Connector::resetChannel() {
+    channel_.reset();
+}
+
+void Connector::handleWrite() {
+    if (state_ != kConnecting) {
+        return;
+    }
+    int sockfd = removeAndResetChannel();
+    int err = getSocketError(sockfd);
+    if (err) {
+        LOG_ERROR("Connector::handleWrite - SO_ERROR = %d\n", err);
+        retry(sockfd);
+    } else if (isSelfConnect(sockfd)) {
+        LOG_ERROR("Connector::handleWrite - Self connect\n");
+        retry(sockfd);
+    } else {
+        setState(kConnected);
+        if (connect_ && newConnectionCallback_) {
+            newConnectionCallback_(sockfd);
+        } else {
+            ::close(sockfd);
+        }
+    }
+}
+
+void Connector::handleError() {
+    if (state_ == kConnecting) {
+        int sockfd = removeAndResetChannel();
+        LOG_ERROR("Connector::handleError - SO_ERROR = %d\n", getSocketError(sockfd));
+        retry(sockfd);
+    }
+}
+
+void Connector::retry(int sockfd) {
+    ::close(sockfd);
+    setState(kDisconnected);
+    if (connect_) {
+        LOG_INFO("Connector::retry - Retry connecting to %s in %d milliseconds\n",
+                 serverAddr_.toIpPort().c_str(), retryDelayMs_);
+        // 定时器持有weak_ptr, Connector析构后不再重试
+        std::weak_ptr<Connector> weakThis(shared_from_this());
+        retryTimer_ = loop_->runAfter(retryDelayMs_ / 1000.0, [weakThis]() {
+            if (std::shared_ptr<Connector> self = weakThis.lock()) {
+                self->retryTimer_ = 0;
+                self->startInLoop();
+            }
+        });
+        retryDelayMs_ = std::min(retryDelayMs_ * 2, kMaxRetryDelayMs);
+    }
+}
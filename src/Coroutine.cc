@@ -0,0 +1,47 @@
+#include <new>
+
+#include "Coroutine.h"
+
+// 不析构: 静态对象析构之后仍可能有协程帧被释放
+static BlockPool* framePools() {
+    static BlockPool *pools = new BlockPool[CoroutineFrameAllocator::kNumClasses];
+    return pools;
+}
+
+int CoroutineFrameAllocator::sizeClass(size_t size) {
+    int index = 0;
+    size_t classSize = kMinFrameSize;
+    while (classSize < size) {
+        classSize <<= 1;
+        ++index;
+    }
+    return index < kNumClasses ? index : -1;
+}
+
+void* CoroutineFrameAllocator::allocate(size_t size) {
+    int index = sizeClass(size);
+    if (index < 0) {
+        return ::operator new(size);
+    }
+    return framePools()[index].allocate(kMinFrameSize << index);
+}
+
+void CoroutineFrameAllocator::deallocate(void *p, size_t size) {
+    int index = sizeClass(size);
+    if (index < 0) {
+        ::operator delete(p);
+        return;
+    }
+    framePools()[index].deallocate(p, kMinFrameSize << index);
+}
+
+BlockPool::Stats CoroutineFrameAllocator::stats() {
+    BlockPool::Stats total = {0, 0, 0};
+    for (int i = 0; i < kNumClasses; ++i) {
+        BlockPool::Stats stats = framePools()[i].stats();
+        total.reused += stats.reused;
+        total.allocated += stats.allocated;
+        total.freeBlocks += stats.freeBlocks;
+    }
+    return total;
+}
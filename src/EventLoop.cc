@@ -39,10 +39,18 @@ EventLoop::EventLoop()
     : looping_(false)
     , quit_(false)
     , threadId_(CurrentThread::tid())
+    , pollReturnNanos_(0)
+    , iteration_(0)
     , poller_(Poller::newDefaultPoller(this))
     , wakeupFd_(createEventfd())
     , wakeupChannel_(new Channel(this, wakeupFd_))
-    , callingPendingFunctors_(false) {
+    , timerQueue_(new TimerQueue(this))
+    , callingPendingFunctors_(false)
+    , bulkPending_(0)
+    , runningBulkNext_(0)
+    , bulkMaxFunctors_(0)
+    , bulkMaxNanos_(0)
+    , slowCallbackNanos_(0) {
         LOG_DEBUG("EventLoop created %p in thread %d\n", this, threadId_);
         if (t_loopInThisThread) {
             LOG_FATAL("Another EventLoop %p exists in this thread %d\n", t_loopInThisThread, threadId_);
@@ -71,13 +79,41 @@ void EventLoop::loop() {
 
     while(!quit_) {
         activeChannels_.clear();
-        // 监听IO事件, 返回发生事件的channels
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        ++iteration_;
+        int64_t pollStart = LatencyHistogram::now();
+        // 监听IO事件, 返回发生事件的channels; 有推迟到本轮的回调或批量通道有剩余时不阻塞
+        bool idle = nextIteration_.empty() && runningBulk_.empty();
+        pollReturnTime_ = poller_->poll(idle ? kPollTimeMs : 0, &activeChannels_);
+        int64_t dispatchStart = LatencyHistogram::now();
+        pollReturnNanos_ = dispatchStart;
+        runningNextIteration_.swap(nextIteration_); // 本轮中再登记的回调留到下一轮
+        int64_t start = dispatchStart;
         for (Channel *channel : activeChannels_) {
+            // channel可能在自己的回调中被移除, 日志需要的信息提前取出
+            int fd = channel->fd();
+            int revents = channel->revents();
             channel->handleEvent(pollReturnTime_); // 调用channel的事件处理函数
+            int64_t end = LatencyHistogram::now();
+            metrics_.eventHandling.record(end - start);
+            if (isSlowCallback(end - start)) {
+                LOG_ERROR("EventLoop %p slow event handling fd=%d revents=%d took %.3fms\n",
+                          this, fd, revents, (end - start) / 1e6);
+            }
+            start = end;
         }
+        // 上一轮推迟的回调排在本轮就绪的channel之后
+        for (const Functor &cb : runningNextIteration_) {
+            cb();
+        }
+        runningNextIteration_.clear();
+        doAfterDispatch(); // 先于pending functor, 事件回调中合并的发送不必等待其他functor
         // 执行回调操作
         doPendingFunctors();
+
+        metrics_.iterations.add(1);
+        metrics_.events.add(activeChannels_.size());
+        metrics_.pollNanos.add(dispatchStart - pollStart);
+        metrics_.busyNanos.add(LatencyHistogram::now() - dispatchStart);
     }
 }
 
@@ -97,26 +133,54 @@ void EventLoop::quit() {
     }
 }
 
-void EventLoop::runInLoop(Functor cb) {
+void EventLoop::runInLoop(Functor cb, Priority priority) {
     if (isInLoopThread()) { // 在当前loop所在的线程调用
         cb();
     } else {
-        queueInLoop(cb); // 放入队列, 唤醒loop所在的线程, 执行cb
+        queueInLoop(std::move(cb), priority); // 放入队列, 唤醒loop所在的线程, 执行cb
     }
 }
 
+void EventLoop::setBulkBudget(int maxFunctors, double maxSeconds) {
+    bulkMaxFunctors_.store(maxFunctors, std::memory_order_relaxed);
+    bulkMaxNanos_.store(static_cast<int64_t>(maxSeconds * 1e9), std::memory_order_relaxed);
+}
+
+TimerId EventLoop::runAfter(double delay, Functor cb) {
+    int64_t when = TimerQueue::now() + static_cast<int64_t>(delay * 1000000);
+    return timerQueue_->addTimer(std::move(cb), when, 0);
+}
+
+TimerId EventLoop::runEvery(double interval, Functor cb) {
+    int64_t micros = static_cast<int64_t>(interval * 1000000);
+    return timerQueue_->addTimer(std::move(cb), TimerQueue::now() + micros, micros);
+}
+
+void EventLoop::cancel(TimerId timerId) {
+    timerQueue_->cancel(timerId);
+}
+
 void EventLoop::handleRead() {
     uint64_t one = 1;
     ssize_t n = read(wakeupFd_, &one, sizeof(one));
     if (n != sizeof(one)) {
         LOG_ERROR("EventLoop::handleRead() reads %lu bytes instead of 8\n", n);
+    } else {
+        metrics_.wakeups.add(one); // eventfd的值是两次读取之间wakeup的次数
     }
 }
 
-void EventLoop::queueInLoop(Functor cb) {
+void EventLoop::queueInLoop(Functor cb, Priority priority) {
+    int64_t queuedAt = LatencyHistogram::now();
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb);
+        if (priority == kBulk) {
+            bulkFunctors_.push_back(PendingFunctor{std::move(cb), queuedAt});
+            metrics_.pendingBulkFunctors.set(++bulkPending_);
+        } else {
+            pendingFunctors_.push_back(PendingFunctor{std::move(cb), queuedAt});
+            metrics_.pendingFunctors.set(pendingFunctors_.size());
+        }
     }
 
     // 如果不在当前loop线程中, 或者正在执行回调操作, 则唤醒loop所在的线程
@@ -139,16 +203,92 @@ bool EventLoop::hasChannel(Channel *channel) {
 }
 
 void EventLoop::doPendingFunctors() {
-    std::vector<Functor> functors;
+    std::vector<PendingFunctor> functors;
     callingPendingFunctors_ = true;
 
     {
         std::unique_lock<std::mutex> lock(mutex_);
         functors.swap(pendingFunctors_); // 交换, 减少临界区时间
+        metrics_.pendingFunctors.set(0);
+        if (runningBulk_.empty()) {
+            runningBulk_.swap(bulkFunctors_); // 上一批执行完才取新的一批, 保持入队顺序
+        }
     }
 
-    for (const Functor &functor : functors) {
-        functor(); // 执行回调操作
+    int64_t start = LatencyHistogram::now();
+    for (const PendingFunctor &pending : functors) {
+        metrics_.functorDelay.record(start - pending.queuedAt);
+        pending.functor(); // 执行回调操作
+        int64_t end = LatencyHistogram::now();
+        metrics_.functorRun.record(end - start);
+        if (isSlowCallback(end - start)) {
+            LOG_ERROR("EventLoop %p slow pending functor took %.3fms\n", this, (end - start) / 1e6);
+        }
+        start = end;
     }
+    metrics_.functors.add(functors.size());
+    doBulkFunctors(); // 紧急通道之后执行, 受配额限制
+    // functor中登记的回调; 仍处于callingPendingFunctors_期间, 其中queueInLoop的functor会唤醒下一轮
+    doAfterDispatch();
     callingPendingFunctors_ = false;
+}
+
+void EventLoop::doBulkFunctors() {
+    if (runningBulk_.empty()) {
+        return;
+    }
+    int maxFunctors = bulkMaxFunctors_.load(std::memory_order_relaxed);
+    int64_t maxNanos = bulkMaxNanos_.load(std::memory_order_relaxed);
+    int64_t begin = LatencyHistogram::now();
+    int64_t start = begin;
+    size_t count = 0;
+    while (runningBulkNext_ < runningBulk_.size()) {
+        PendingFunctor &pending = runningBulk_[runningBulkNext_++];
+        metrics_.bulkFunctorDelay.record(start - pending.queuedAt);
+        pending.functor();
+        pending.functor = nullptr; // 剩余的回调留到下一轮, 已执行的先释放捕获的对象
+        int64_t end = LatencyHistogram::now();
+        metrics_.functorRun.record(end - start);
+        if (isSlowCallback(end - start)) {
+            LOG_ERROR("EventLoop %p slow bulk functor took %.3fms\n", this, (end - start) / 1e6);
+        }
+        start = end;
+        ++count;
+        if ((maxFunctors > 0 && count >= static_cast<size_t>(maxFunctors))
+            || (maxNanos > 0 && end - begin >= maxNanos)) {
+            break; // 配额用完, 回到poll处理IO事件
+        }
+    }
+    metrics_.functors.add(count);
+    metrics_.bulkFunctors.add(count);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (runningBulkNext_ == runningBulk_.size()) {
+        // 执行期间新入队的回调立即接上: 它们的wakeup已在本轮被消耗, 留在bulkFunctors_中poll会一直阻塞
+        runningBulk_.clear();
+        runningBulkNext_ = 0;
+        runningBulk_.swap(bulkFunctors_);
+    } else {
+        metrics_.bulkCarryOvers.add(1);
+    }
+    bulkPending_ -= count;
+    metrics_.pendingBulkFunctors.set(bulkPending_);
+}
+
+void EventLoop::runAfterDispatch(Functor cb) {
+    afterDispatch_.push_back(std::move(cb));
+}
+
+void EventLoop::runNextIteration(Functor cb) {
+    nextIteration_.push_back(std::move(cb));
+}
+
+void EventLoop::doAfterDispatch() {
+    // 回调中可能再次登记, 直到没有新的回调
+    while (!afterDispatch_.empty()) {
+        runningAfterDispatch_.swap(afterDispatch_);
+        for (const Functor &cb : runningAfterDispatch_) {
+            cb();
+        }
+        runningAfterDispatch_.clear();
+    }
 }
\ No newline at end of file
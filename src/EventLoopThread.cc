@@ -1,13 +1,18 @@
+#include <pthread.h>
+#include <sched.h>
+
 #include "EventLoopThread.h"
 #include "EventLoop.h"
+#include "Logger.h"
 
-EventLoopThread::EventLoopThread(const ThreadInitCallback &cb, const std::string &name)
+EventLoopThread::EventLoopThread(const ThreadInitCallback &cb, const std::string &name, int cpu)
     : loop_(nullptr),
       exiting_(false),
       thread_(std::bind(&EventLoopThread::threadFunc, this), name),
       mutex_(),
       cond_(),
-      callback_(cb) {
+      callback_(cb),
+      cpu_(cpu) {
 }
 
 EventLoopThread::~EventLoopThread() {
@@ -32,6 +37,18 @@ EventLoop* EventLoopThread::startLoop() {
 
 // 下面的函数在单独的新线程中运行
 void EventLoopThread::threadFunc() {
+#ifdef __linux__
+    if (cpu_ >= 0) {
+        // 将loop线程绑定到指定CPU, 便于按网卡队列所在的CPU分发连接
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu_, &cpuset);
+        if (::pthread_setaffinity_np(::pthread_self(), sizeof cpuset, &cpuset) != 0) {
+            LOG_ERROR("EventLoopThread bind cpu %d fail\n", cpu_);
+            cpu_ = -1;
+        }
+    }
+#endif
     EventLoop loop; // 创建EventLoop对象, 和上面的线程一一对应, 即 one loop per thread
 
     if (callback_) {
@@ -1,7 +1,9 @@
+#include <sched.h>
 #include <memory>
 
 #include "EventLoopThreadPool.h"
 #include "EventLoopThread.h"
+#include "EventLoop.h"
 #include "Logger.h"
 
 EventLoopThreadPool::EventLoopThreadPool(EventLoop *baseLoop, const std::string &nameArg)
@@ -9,7 +11,8 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop *baseLoop, const std::string
       name_(nameArg),
       started_(false),
       numThreads_(0),
-      next_(0) {
+      next_(0),
+      cpuAffinity_(false) {
 }
 
 EventLoopThreadPool::~EventLoopThreadPool() {
@@ -17,16 +20,49 @@ EventLoopThreadPool::~EventLoopThreadPool() {
     // 不需要delete EventLoop, 因为EventLoopThread的线程函数中会自动delete
 }
 
+// 进程允许运行的CPU(受cpuset/taskset限制), 按编号升序
+static std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    if (::sched_getaffinity(0, sizeof cpuset, &cpuset) != 0) {
+        LOG_ERROR("EventLoopThreadPool sched_getaffinity fail\n");
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &cpuset)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
 void EventLoopThreadPool::start(const ThreadInitCallback &cb) {
     started_ = true;
 
+    // 只在允许的CPU中依次分配, 网卡收包队列的中断需绑定到同一组CPU上分发才能命中
+    std::vector<int> cpus;
+    if (cpuAffinity_) {
+        cpus = allowedCpus();
+    }
     for (int i = 0; i < numThreads_; ++i) {
         char buf[name_.size() + 32];
         snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
-        EventLoopThread *t = new EventLoopThread(cb, buf);
+        int cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        EventLoopThread *t = new EventLoopThread(cb, buf, cpu);
         threads_.emplace_back(t);
         EventLoop *loop = t->startLoop(); // 启动线程，创建EventLoop
         loops_.push_back(loop);
+
+        // 记录CPU => subloop, 同一CPU上有多个subloop时取第一个
+        if (t->cpu() >= 0) {
+            if (static_cast<int>(cpuLoops_.size()) <= t->cpu()) {
+                cpuLoops_.resize(t->cpu() + 1, nullptr);
+            }
+            if (cpuLoops_[t->cpu()] == nullptr) {
+                cpuLoops_[t->cpu()] = loop;
+            }
+        }
     }
 
     if (numThreads_ == 0 && cb) {
@@ -49,10 +85,37 @@ EventLoop* EventLoopThreadPool::getNextLoop() {
     return loop;
 }
 
+EventLoop* EventLoopThreadPool::getLoopForCpu(int cpu) const {
+    if (cpu < 0 || cpu >= static_cast<int>(cpuLoops_.size())) {
+        return nullptr;
+    }
+    return cpuLoops_[cpu];
+}
+
 std::vector<EventLoop*> EventLoopThreadPool::getAllLoops() {
     if (loops_.empty()) {
         return std::vector<EventLoop *>(1, baseLoop_);
     } else {
         return loops_;
     }
+}
+
+std::vector<LoopStats> EventLoopThreadPool::loopStats() const {
+    std::vector<LoopStats> stats;
+    stats.reserve(loops_.size() + 1);
+    stats.push_back(baseLoop_->stats());
+    for (EventLoop *loop : loops_) {
+        stats.push_back(loop->stats());
+    }
+    return stats;
+}
+
+std::vector<LoopLatencyStats> EventLoopThreadPool::loopLatencyStats() const {
+    std::vector<LoopLatencyStats> stats;
+    stats.reserve(loops_.size() + 1);
+    stats.push_back(baseLoop_->latencyStats());
+    for (EventLoop *loop : loops_) {
+        stats.push_back(loop->latencyStats());
+    }
+    return stats;
 }
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "HotRestart.h"
+#include "Acceptor.h"
+#include "Channel.h"
+#include "EventLoop.h"
+#include "TcpServer.h"
+#include "Logger.h"
+
+static const int kMaxHandoverFds = 64; // 一次交接的监听socket上限(SCM_RIGHTS单条消息最多253个)
+static const double kDrainCheckInterval = 0.05;
+
+static bool writeAll(int sockfd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(sockfd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+HotRestart::HotRestart(EventLoop *loop, const InetAddress &controlAddr)
+    : loop_(loop),
+      controlAddr_(controlAddr),
+      controlFd_(-1),
+      inherited_(false),
+      draining_(false),
+      drainTimeout_(30.0),
+      drainCheckTimer_(0),
+      drainDeadlineTimer_(0) {
+}
+
+HotRestart::~HotRestart() {
+    if (drainCheckTimer_ != 0) loop_->cancel(drainCheckTimer_);
+    if (drainDeadlineTimer_ != 0) loop_->cancel(drainDeadlineTimer_);
+    closeControlConnection();
+}
+
+bool HotRestart::takeOver() {
+    int sockfd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sockfd < 0) {
+        LOG_ERROR("HotRestart::takeOver socket err:%d\n", errno);
+        return false;
+    }
+    if (::connect(sockfd, controlAddr_.getSockAddr(), controlAddr_.getSockLen()) < 0) {
+        ::close(sockfd); // 没有旧进程
+        return false;
+    }
+    // 旧进程在自己的loop中应答, 设置超时避免旧进程卡住时新进程永远等待
+    timeval timeout = {5, 0};
+    ::setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+
+    static const char kRequest[] = "TAKEOVER\n";
+    if (!writeAll(sockfd, kRequest, sizeof kRequest - 1)) {
+        ::close(sockfd);
+        return false;
+    }
+
+    char line[64] = {0};
+    char control[CMSG_SPACE(sizeof(int) * kMaxHandoverFds)];
+    iovec iov = {line, sizeof line - 1};
+    msghdr msg;
+    ::memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof control;
+    ssize_t n = ::recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+    if (n <= 0 || ::strncmp(line, "FDS ", 4) != 0) {
+        LOG_ERROR("HotRestart::takeOver bad reply from %s\n", controlAddr_.toIpPort().c_str());
+        ::close(sockfd);
+        return false;
+    }
+    int count = 0;
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            int num = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            for (int i = 0; i < num; ++i) {
+                int fd;
+                ::memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof fd);
+                Acceptor::addInheritedSocket(fd);
+                ++count;
+            }
+        }
+    }
+    if (count != ::atoi(line + 4) || (msg.msg_flags & MSG_CTRUNC)) {
+        LOG_ERROR("HotRestart::takeOver expect %d fds, got %d\n", ::atoi(line + 4), count);
+    }
+    LOG_INFO("HotRestart::takeOver inherited %d listen sockets from %s\n", count, controlAddr_.toIpPort().c_str());
+    controlFd_ = sockfd; // start时通过它通知旧进程
+    inherited_ = true;
+    return true;
+}
+
+void HotRestart::start() {
+    size_t unused = Acceptor::closeUnusedInheritedSockets();
+    if (unused > 0) {
+        LOG_INFO("HotRestart::start close %zu inherited sockets not used by any TcpServer\n", unused);
+    }
+    if (controlFd_ >= 0) {
+        // 新进程已经开始accept, 旧进程可以停止; 等旧进程关闭控制socket后再绑定同一地址
+        static const char kReady[] = "READY\n";
+        if (writeAll(controlFd_, kReady, sizeof kReady - 1)) {
+            char buf[64];
+            while (::read(controlFd_, buf, sizeof buf) > 0) {
+            }
+        }
+        ::close(controlFd_);
+        controlFd_ = -1;
+    }
+    controlAcceptor_.reset(new Acceptor(loop_, controlAddr_, false));
+    controlAcceptor_->setNewConnectionCallback(
+        [this](int sockfd, const InetAddress &peer) { newControlConnection(sockfd, peer); });
+    controlAcceptor_->listen();
+}
+
+void HotRestart::newControlConnection(int sockfd, const InetAddress &peer) {
+    if (controlFd_ >= 0 || draining_) {
+        LOG_ERROR("HotRestart reject control connection from %s, handover in progress\n", peer.toIpPort().c_str());
+        ::close(sockfd);
+        return;
+    }
+    controlFd_ = sockfd;
+    controlInput_.clear();
+    controlChannel_.reset(new Channel(loop_, sockfd));
+    controlChannel_->setReadCallback([this](Timestamp) { handleControlRead(); });
+    controlChannel_->enableReading();
+}
+
+void HotRestart::handleControlRead() {
+    char buf[256];
+    ssize_t n = ::read(controlFd_, buf, sizeof buf);
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+            return;
+        }
+        // 新进程在READY之前退出, 本进程继续提供服务
+        LOG_ERROR("HotRestart control connection closed before handover\n");
+        closeControlConnection();
+        return;
+    }
+    controlInput_.append(buf, n);
+    size_t pos;
+    while ((pos = controlInput_.find('\n')) != std::string::npos) {
+        std::string line = controlInput_.substr(0, pos);
+        controlInput_.erase(0, pos + 1);
+        if (line == "TAKEOVER") {
+            sendListenSockets();
+        } else if (line == "READY") {
+            // 交接会析构controlAcceptor_, 放到本轮事件处理之后, 避免析构本轮还要处理的channel
+            controlChannel_->disableAll();
+            loop_->queueInLoop([this]() { handOver(); });
+            return;
+        } else {
+            LOG_ERROR("HotRestart unknown control message: %s\n", line.c_str());
+            closeControlConnection();
+            return;
+        }
+    }
+}
+
+void HotRestart::sendListenSockets() {
+    std::vector<int> fds;
+    for (TcpServer *server : servers_) {
+        if (fds.size() < static_cast<size_t>(kMaxHandoverFds)) {
+            fds.push_back(server->listenFd());
+        }
+    }
+    char line[32];
+    int len = snprintf(line, sizeof line, "FDS %zu\n", fds.size());
+    iovec iov = {line, static_cast<size_t>(len)};
+    char control[CMSG_SPACE(sizeof(int) * kMaxHandoverFds)];
+    ::memset(control, 0, sizeof control);
+    msghdr msg;
+    ::memset(&msg, 0, sizeof msg);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (!fds.empty()) {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        ::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+    // 消息很短, 非阻塞socket的发送缓冲区一定放得下
+    if (::sendmsg(controlFd_, &msg, MSG_NOSIGNAL) != len) {
+        LOG_ERROR("HotRestart::sendListenSockets sendmsg err:%d\n", errno);
+        closeControlConnection();
+        return;
+    }
+    LOG_INFO("HotRestart sent %zu listen sockets\n", fds.size());
+}
+
+void HotRestart::handOver() {
+    LOG_INFO("HotRestart hand over, stop accepting and drain\n");
+    for (TcpServer *server : servers_) {
+        server->stopAccepting();
+    }
+    // 先释放控制地址再断开, 新进程看到EOF后绑定同一地址
+    controlAcceptor_.reset();
+    closeControlConnection();
+
+    draining_ = true;
+    drainCheckTimer_ = loop_->runEvery(kDrainCheckInterval, [this]() { checkDrained(); });
+    drainDeadlineTimer_ = loop_->runAfter(drainTimeout_, [this]() {
+        drainDeadlineTimer_ = 0;
+        LOG_INFO("HotRestart drain timeout, force close remaining connections\n");
+        for (TcpServer *server : servers_) {
+            server->forceCloseAll();
+        }
+    });
+    checkDrained();
+}
+
+void HotRestart::checkDrained() {
+    if (!draining_ || drainCheckTimer_ == 0) {
+        return;
+    }
+    size_t remaining = 0;
+    for (TcpServer *server : servers_) {
+        remaining += server->connectionCount();
+    }
+    if (remaining > 0) {
+        return;
+    }
+    loop_->cancel(drainCheckTimer_);
+    drainCheckTimer_ = 0;
+    if (drainDeadlineTimer_ != 0) {
+        loop_->cancel(drainDeadlineTimer_);
+        drainDeadlineTimer_ = 0;
+    }
+    LOG_INFO("HotRestart drained\n");
+    if (drainedCallback_) {
+        drainedCallback_();
+    }
+}
+
+void HotRestart::closeControlConnection() {
+    if (controlChannel_) {
+        controlChannel_->disableAll();
+        controlChannel_->remove();
+        // 可能正在该channel的回调中, 延后析构
+        std::shared_ptr<Channel> channel(std::move(controlChannel_));
+        loop_->queueInLoop([channel]() {});
+    }
+    if (controlFd_ >= 0) {
+        ::close(controlFd_);
+        controlFd_ = -1;
+    }
+    controlInput_.clear();
+}
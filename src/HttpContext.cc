@@ -0,0 +1,208 @@
+#include "HttpContext.h"
+#include "Buffer.h"
+#include "ByteScan.h"
+
+void HttpContext::reset() {
+    state_ = kExpectHeaders;
+    scanned_ = 0;
+    headerLen_ = 0;
+    contentLength_ = 0;
+    chunked_ = false;
+    chunkPos_ = 0;
+    requestLen_ = 0;
+    headerBase_ = nullptr;
+    chunkedBody_.clear(); // 保留容量, 供下一个请求复用
+    request_.reset();
+}
+
+HttpContext::ParseResult HttpContext::parse(Buffer *buf) {
+    const char *data = buf->peek();
+    const size_t readable = buf->readableBytes();
+
+    if (state_ == kExpectHeaders) {
+        // 从上次扫描结束的位置继续查找请求头结尾, 回退3字节防止\r\n\r\n跨越两次读取
+        const char *end = data + readable;
+        const char *crlf = ByteScan::findCRLF(data + (scanned_ > 3 ? scanned_ - 3 : 0), end);
+        while (crlf != nullptr && !(end - crlf >= 4 && crlf[2] == '\r' && crlf[3] == '\n')) {
+            crlf = ByteScan::findCRLF(crlf + 2, end);
+        }
+        if (crlf == nullptr) {
+            scanned_ = readable;
+            return readable > kMaxHeaderBytes ? kError : kIncomplete;
+        }
+        headerLen_ = crlf - data + 4;
+        if (headerLen_ > kMaxHeaderBytes || !parseHeaders(data, data + headerLen_)) {
+            return kError;
+        }
+        headerBase_ = data;
+        if (chunked_) {
+            state_ = kExpectChunk;
+            chunkPos_ = headerLen_;
+        } else {
+            if (contentLength_ > kMaxBodyBytes) {
+                return kError;
+            }
+            state_ = kExpectBody;
+        }
+    }
+
+    ParseResult result = kIncomplete;
+    if (state_ == kExpectBody) {
+        if (readable < headerLen_ + contentLength_) {
+            return kIncomplete;
+        }
+        requestLen_ = headerLen_ + contentLength_;
+        result = kComplete;
+    } else if (state_ == kExpectChunk) {
+        result = parseChunks(data, readable);
+    }
+
+    if (result == kComplete) {
+        // 等待消息体期间缓冲区可能扩容搬移, 此时请求头视图已失效, 重新解析
+        if (data != headerBase_) {
+            parseHeaders(data, data + headerLen_);
+        }
+        request_.body_ = chunked_
+            ? std::string_view(chunkedBody_)
+            : std::string_view(data + headerLen_, contentLength_);
+    }
+    return result;
+}
+
+void HttpContext::consume(Buffer *buf) {
+    buf->retrieve(requestLen_);
+    reset();
+}
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+bool HttpContext::parseHeaders(const char *begin, const char *end) {
+    request_.reset();
+    std::string_view input(begin, end - begin);
+
+    // 请求行: METHOD SP target SP HTTP/1.x CRLF
+    size_t eol = input.find("\r\n");
+    std::string_view line = input.substr(0, eol);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos || !request_.setMethod(line.substr(0, sp1))) {
+        return false;
+    }
+    std::string_view target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    size_t question = target.find('?');
+    if (question == std::string_view::npos) {
+        request_.path_ = target;
+    } else {
+        request_.path_ = target.substr(0, question);
+        request_.query_ = target.substr(question + 1);
+    }
+    if (request_.path_.empty()) {
+        return false;
+    }
+    std::string_view version = line.substr(sp2 + 1);
+    if (version == "HTTP/1.1") {
+        request_.version_ = HttpRequest::kHttp11;
+    } else if (version == "HTTP/1.0") {
+        request_.version_ = HttpRequest::kHttp10;
+    } else {
+        return false;
+    }
+
+    // 请求头: name: value CRLF, 以空行结束
+    contentLength_ = 0;
+    chunked_ = false;
+    size_t pos = eol + 2;
+    while (pos < input.size()) {
+        eol = input.find("\r\n", pos);
+        if (eol == pos) {
+            break; // 空行
+        }
+        line = input.substr(pos, eol - pos);
+        pos = eol + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos || colon == 0) {
+            return false;
+        }
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = trim(line.substr(colon + 1));
+        if (!request_.addHeader(name, value)) {
+            return false;
+        }
+
+        if (httpEqualsIgnoreCase(name, "Content-Length")) {
+            if (value.empty() || value.size() > 18) {
+                return false;
+            }
+            size_t length = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9') return false;
+                length = length * 10 + (c - '0');
+            }
+            contentLength_ = length;
+        } else if (httpEqualsIgnoreCase(name, "Transfer-Encoding")) {
+            chunked_ = value.size() >= 7 && httpEqualsIgnoreCase(value.substr(value.size() - 7), "chunked");
+        }
+    }
+    return true;
+}
+
+HttpContext::ParseResult HttpContext::parseChunks(const char *data, size_t readable) {
+    // chunk格式: 十六进制长度[;扩展] CRLF 数据 CRLF, 长度为0的chunk后跟可选的trailer和空行
+    while (true) {
+        std::string_view input(data + chunkPos_, readable - chunkPos_);
+        size_t eol = input.find("\r\n");
+        if (eol == std::string_view::npos) {
+            return input.size() > 1024 ? kError : kIncomplete;
+        }
+
+        size_t size = 0;
+        size_t digits = 0;
+        for (size_t i = 0; i < eol && input[i] != ';'; ++i) {
+            char c = input[i];
+            int value;
+            if (c >= '0' && c <= '9') value = c - '0';
+            else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+            else if (c == ' ' || c == '\t') continue;
+            else return kError;
+            if (++digits > 8) return kError;
+            size = size * 16 + value;
+        }
+        if (digits == 0) {
+            return kError;
+        }
+
+        if (size == 0) {
+            std::string_view rest = input.substr(eol + 2);
+            if (rest.size() < 2) {
+                return kIncomplete;
+            }
+            if (rest[0] == '\r' && rest[1] == '\n') {
+                requestLen_ = chunkPos_ + eol + 4;
+                return kComplete;
+            }
+            size_t end = rest.find("\r\n\r\n"); // 跳过trailer
+            if (end == std::string_view::npos) {
+                return rest.size() > kMaxHeaderBytes ? kError : kIncomplete;
+            }
+            requestLen_ = chunkPos_ + eol + 2 + end + 4;
+            return kComplete;
+        }
+
+        if (chunkedBody_.size() + size > kMaxBodyBytes) {
+            return kError;
+        }
+        if (input.size() < eol + 2 + size + 2) {
+            return kIncomplete;
+        }
+        if (input[eol + 2 + size] != '\r' || input[eol + 3 + size] != '\n') {
+            return kError;
+        }
+        chunkedBody_.append(input.data() + eol + 2, size);
+        chunkPos_ += eol + 2 + size + 2;
+    }
+}
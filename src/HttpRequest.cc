@@ -0,0 +1,57 @@
+#include <ctype.h>
+
+#include "HttpRequest.h"
+
+bool httpEqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (::tolower(static_cast<unsigned char>(a[i])) != ::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HttpRequest::setMethod(std::string_view method) {
+    methodString_ = method;
+    if (method == "GET") {
+        method_ = kGet;
+    } else if (method == "POST") {
+        method_ = kPost;
+    } else if (method == "HEAD") {
+        method_ = kHead;
+    } else if (method == "PUT") {
+        method_ = kPut;
+    } else if (method == "DELETE") {
+        method_ = kDelete;
+    } else if (method == "OPTIONS") {
+        method_ = kOptions;
+    } else if (method == "PATCH") {
+        method_ = kPatch;
+    } else {
+        method_ = kInvalid;
+    }
+    return method_ != kInvalid;
+}
+
+std::string_view HttpRequest::getHeader(std::string_view name) const {
+    for (size_t i = 0; i < numHeaders_; ++i) {
+        if (httpEqualsIgnoreCase(headers_[i].name, name)) {
+            return headers_[i].value;
+        }
+    }
+    return std::string_view();
+}
+
+bool HttpRequest::keepAlive() const {
+    std::string_view connection = getHeader("Connection");
+    if (httpEqualsIgnoreCase(connection, "close")) {
+        return false;
+    }
+    if (httpEqualsIgnoreCase(connection, "keep-alive")) {
+        return true;
+    }
+    return version_ == kHttp11;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+
+#include "HttpResponse.h"
+#include "Buffer.h"
+#include "Logger.h"
+
+static std::string_view defaultStatusMessage(int code) {
+    switch (code) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 301: return "Moved Permanently";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 413: return "Payload Too Large";
+        case 500: return "Internal Server Error";
+        default: return "Unknown";
+    }
+}
+
+void HttpResponse::addHeader(std::string_view name, std::string_view value) {
+    if (numHeaders_ >= kMaxHeaders) {
+        LOG_ERROR("HttpResponse::addHeader too many headers, drop %.*s\n",
+                  static_cast<int>(name.size()), name.data());
+        return;
+    }
+    headers_[numHeaders_].name = name;
+    headers_[numHeaders_].value = value;
+    ++numHeaders_;
+}
+
+void HttpResponse::appendToBuffer(Buffer *output) const {
+    char buf[64];
+    int code = statusCode_ == kUnknown ? 200 : statusCode_;
+    int n = snprintf(buf, sizeof buf, "HTTP/1.1 %d ", code);
+    output->append(buf, n);
+    std::string_view message = statusMessage_.empty() ? defaultStatusMessage(code) : statusMessage_;
+    output->append(message.data(), message.size());
+
+    if (closeConnection_) {
+        static const char kClose[] = "\r\nConnection: close";
+        output->append(kClose, sizeof kClose - 1);
+    } else {
+        static const char kKeepAlive[] = "\r\nConnection: Keep-Alive";
+        output->append(kKeepAlive, sizeof kKeepAlive - 1);
+    }
+    n = snprintf(buf, sizeof buf, "\r\nContent-Length: %zu\r\n", body_.size());
+    output->append(buf, n);
+
+    for (size_t i = 0; i < numHeaders_; ++i) {
+        output->append(headers_[i].name.data(), headers_[i].name.size());
+        output->append(": ", 2);
+        output->append(headers_[i].value.data(), headers_[i].value.size());
+        output->append("\r\n", 2);
+    }
+    output->append("\r\n", 2);
+    output->append(body_.data(), body_.size());
+}
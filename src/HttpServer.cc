@@ -0,0 +1,74 @@
+#include "HttpServer.h"
+#include "HttpContext.h"
+#include "Logger.h"
+
+// 默认回调: 所有请求返回404
+static void defaultHttpCallback(const HttpRequest &, HttpResponse *resp) {
+    resp->setStatusCode(HttpResponse::k404NotFound);
+    resp->setCloseConnection(true);
+}
+
+HttpServer::HttpServer(EventLoop *loop,
+                       const InetAddress &listenAddr,
+                       const std::string &name,
+                       TcpServer::Option option)
+    : server_(loop, listenAddr, name, option),
+      httpCallback_(defaultHttpCallback) {
+    server_.setConnectionCallback([this](const TcpConnectionPtr &conn) { onConnection(conn); });
+    server_.setMessageCallback([this](const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime) {
+        onMessage(conn, buf, receiveTime);
+    });
+}
+
+void HttpServer::start() {
+    LOG_INFO("HttpServer[%s] starts listening on %s\n", server_.name().c_str(), server_.ipPort().c_str());
+    server_.start();
+}
+
+void HttpServer::onConnection(const TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+        conn->setContext(HttpContext()); // 每个连接一个解析器
+    }
+}
+
+void HttpServer::onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    HttpContext *context = std::any_cast<HttpContext>(conn->getMutableContext());
+    // 同一loop线程内复用的输出缓冲区, 一批pipelined请求的响应一次发送
+    static thread_local Buffer output;
+
+    while (true) {
+        HttpContext::ParseResult result = context->parse(buf);
+        if (result == HttpContext::kIncomplete) {
+            break;
+        }
+        if (result == HttpContext::kError) {
+            static const char kBadRequest[] =
+                "HTTP/1.1 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+            output.append(kBadRequest, sizeof kBadRequest - 1);
+            conn->send(&output);
+            output.retrieveAll(); // 连接已断开时send不会取走数据
+            buf->retrieveAll();
+            conn->shutdown();
+            return;
+        }
+
+        const HttpRequest &request = context->request();
+        HttpResponse response(!request.keepAlive());
+        httpCallback_(request, &response);
+        response.appendToBuffer(&output);
+        context->consume(buf);
+
+        if (response.closeConnection()) {
+            conn->send(&output);
+            output.retrieveAll();
+            buf->retrieveAll(); // 连接即将关闭, 丢弃后续请求
+            conn->shutdown();
+            return;
+        }
+    }
+
+    if (output.readableBytes() > 0) {
+        conn->send(&output);
+        output.retrieveAll();
+    }
+}
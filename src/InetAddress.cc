@@ -1,34 +1,114 @@
 #include <strings.h>
 #include <string.h>
+#include <stddef.h>
 
 #include "InetAddress.h"
+#include "Logger.h"
 
 InetAddress::InetAddress(uint16_t port, std::string ip) {
-    ::memset(&addr_, 0, sizeof addr_);
-    addr_.sin_family = AF_INET;
-    addr_.sin_port = htons(port); // 本地字节序转为网络字节序
-    addr_.sin_addr.s_addr = inet_addr(ip.c_str());
+    ::memset(&addrUn_, 0, sizeof addrUn_);
+    if (ip.find(':') != std::string::npos) {
+        addr6_.sin6_family = AF_INET6;
+        addr6_.sin6_port = htons(port);
+        ::inet_pton(AF_INET6, ip.c_str(), &addr6_.sin6_addr);
+        len_ = sizeof addr6_;
+    } else {
+        addr4_.sin_family = AF_INET;
+        addr4_.sin_port = htons(port); // 本地字节序转为网络字节序
+        addr4_.sin_addr.s_addr = inet_addr(ip.c_str());
+        len_ = sizeof addr4_;
+    }
+}
+
+InetAddress::InetAddress(const sockaddr_in &addr) {
+    ::memset(&addrUn_, 0, sizeof addrUn_);
+    addr4_ = addr;
+    len_ = sizeof addr4_;
+}
+
+InetAddress::InetAddress(const sockaddr_in6 &addr) {
+    ::memset(&addrUn_, 0, sizeof addrUn_);
+    addr6_ = addr;
+    len_ = sizeof addr6_;
+}
+
+InetAddress InetAddress::unixPath(const std::string &path) {
+    InetAddress addr;
+    ::memset(&addr.addrUn_, 0, sizeof addr.addrUn_);
+    bool abstract = !path.empty() && path[0] == '@';
+    // abstract namespace的名字可以占满sun_path, 文件系统路径还需要结尾的'\0'
+    size_t maxLen = abstract ? sizeof addr.addrUn_.sun_path : sizeof addr.addrUn_.sun_path - 1;
+    if (path.size() > maxLen) {
+        // 截断后会绑定或连接到另一个socket, 返回无效地址让bind/connect失败
+        LOG_ERROR("InetAddress::unixPath path too long (%zu > %zu): %s\n", path.size(), maxLen, path.c_str());
+        addr.addrUn_.sun_family = AF_UNSPEC;
+        addr.len_ = 0;
+        return addr;
+    }
+    addr.addrUn_.sun_family = AF_UNIX;
+    size_t len = path.size();
+    ::memcpy(addr.addrUn_.sun_path, path.data(), len);
+    if (abstract) {
+        addr.addrUn_.sun_path[0] = '\0'; // abstract namespace, 长度不包括结尾的'\0'
+        addr.len_ = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + len);
+    } else {
+        addr.len_ = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + len + 1);
+    }
+    return addr;
+}
+
+void InetAddress::setSockAddr(const sockaddr *addr, socklen_t len) {
+    ::memset(&addrUn_, 0, sizeof addrUn_);
+    if (len > sizeof addrUn_) {
+        len = sizeof addrUn_;
+    }
+    ::memcpy(&addrUn_, addr, len);
+    len_ = len;
 }
 
 std::string InetAddress::toIp() const {
-    char buf[32];
-    ::memset(buf, 0, sizeof buf);
-    ::inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof buf);
+    char buf[INET6_ADDRSTRLEN] = {0};
+    if (family() == AF_INET) {
+        ::inet_ntop(AF_INET, &addr4_.sin_addr, buf, sizeof buf);
+    } else if (family() == AF_INET6) {
+        ::inet_ntop(AF_INET6, &addr6_.sin6_addr, buf, sizeof buf);
+    } else if (family() == AF_UNIX) {
+        size_t pathLen = len_ > offsetof(sockaddr_un, sun_path) ? len_ - offsetof(sockaddr_un, sun_path) : 0;
+        if (pathLen == 0) {
+            return std::string(); // accept返回的未命名地址
+        }
+        if (addrUn_.sun_path[0] == '\0') {
+            return "@" + std::string(addrUn_.sun_path + 1, pathLen - 1);
+        }
+        return std::string(addrUn_.sun_path, ::strnlen(addrUn_.sun_path, pathLen));
+    }
     return buf;
 }
 
 std::string InetAddress::toIpPort() const {
-    char buf[32];
-    ::memset(buf, 0, sizeof buf);
-    ::inet_ntop(AF_INET, &addr_.sin_addr, buf, sizeof buf);
-    size_t end = ::strlen(buf);
-    uint16_t port = ntohs(addr_.sin_port); // 网络字节序转为本地字节序
-    snprintf(buf + end, sizeof buf - end, ":%u", port);
+    if (family() == AF_UNIX) {
+        return "unix:" + toIp();
+    }
+    char buf[INET6_ADDRSTRLEN + 16];
+    if (family() == AF_INET6) {
+        snprintf(buf, sizeof buf, "[%s]:%u", toIp().c_str(), toPort());
+    } else {
+        snprintf(buf, sizeof buf, "%s:%u", toIp().c_str(), toPort());
+    }
     return buf;
 }
 
 uint16_t InetAddress::toPort() const {
-    return ntohs(addr_.sin_port);
+    if (family() == AF_INET) {
+        return ntohs(addr4_.sin_port); // 网络字节序转为本地字节序
+    } else if (family() == AF_INET6) {
+        return ntohs(addr6_.sin6_port);
+    }
+    return 0;
+}
+
+bool InetAddress::operator==(const InetAddress &rhs) const {
+    return len_ == rhs.len_ && ::memcmp(&addrUn_, &rhs.addrUn_, len_) == 0;
 }
 
 #if 0
@@ -38,4 +118,4 @@ int main() {
     std::cout << addr.toIpPort() << std::endl;
     return 0;
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,66 @@
+#include <math.h>
+
+#include "LatencyHistogram.h"
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < kSubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / kSubBuckets - 1;
+    uint64_t lower = static_cast<uint64_t>(kSubBuckets | (index % kSubBuckets)) << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot s;
+    s.counts.resize(kNumBuckets);
+    for (int i = 0; i < kNumBuckets; ++i) {
+        s.counts[i] = counts_[i].get();
+    }
+    // 与record并发时各字段可能相差几次记录, 以桶计数为准
+    s.count = 0;
+    for (uint64_t c : s.counts) {
+        s.count += c;
+    }
+    s.sum = sum_.get();
+    s.max = max_.get();
+    return s;
+}
+
+LatencyHistogram::Snapshot& LatencyHistogram::Snapshot::operator+=(const Snapshot &rhs) {
+    if (rhs.counts.empty()) {
+        return *this;
+    }
+    if (counts.empty()) {
+        counts.resize(rhs.counts.size());
+    }
+    for (size_t i = 0; i < rhs.counts.size(); ++i) {
+        counts[i] += rhs.counts[i];
+    }
+    count += rhs.count;
+    sum += rhs.sum;
+    if (rhs.max > max) {
+        max = rhs.max;
+    }
+    return *this;
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+    // 第rank个(从1开始)样本所在的桶, rank向上取整, 10个样本的p99是第10个
+    // 减去一个很小的量, 避免0.07*100这样的乘积因浮点误差略大于整数而多取一个
+    uint64_t rank = static_cast<uint64_t>(::ceil(p * static_cast<double>(count) - 1e-9));
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint64_t upper = bucketUpperBound(static_cast<int>(i));
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
@@ -0,0 +1,40 @@
+#include "LengthHeaderCodec.h"
+#include "TcpConnection.h"
+#include "Logger.h"
+
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime) {
+    // 一次可能收到多个完整的帧, 逐个解析
+    int frames = 0;
+    while (buf->readableBytes() >= kHeaderLen) {
+        const uint32_t len = static_cast<uint32_t>(buf->peekInt32());
+        if (len > maxFrameSize_) {
+            LOG_ERROR("LengthHeaderCodec::onMessage invalid frame length %u from %s\n",
+                      len, conn ? conn->name().c_str() : "");
+            buf->retrieveAll();
+            if (conn) conn->shutdown();
+            break;
+        }
+        if (buf->readableBytes() < kHeaderLen + len) {
+            break; // 帧不完整, 等待更多数据
+        }
+        if (frameBudget_ > 0 && frames == frameBudget_) {
+            if (conn) conn->deferMessages(); // 本轮配额用完, 剩余的帧下一轮处理
+            break;
+        }
+        ++frames;
+        std::string_view frame(buf->peek() + kHeaderLen, len);
+        frameCallback_(conn, frame, receiveTime);
+        buf->retrieve(kHeaderLen + len);
+    }
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr &conn, std::string_view message) {
+    Buffer buf(message.size());
+    buf.append(message.data(), message.size());
+    send(conn, &buf);
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr &conn, Buffer *message) {
+    message->prependInt32(static_cast<int32_t>(message->readableBytes()));
+    conn->send(message);
+}
@@ -3,6 +3,8 @@
 #include "Logger.h"
 #include "Timestamp.h"
 
+std::atomic<bool> Logger::infoEnabled_(true);
+
 // 获取日志的唯一实例 单例
 Logger& Logger::instance() {
     static Logger logger; // 局部静态变量
@@ -0,0 +1,123 @@
+#include <stdio.h>
+
+#include "MetricsServer.h"
+
+namespace {
+
+struct MetricDesc {
+    const char *name;
+    const char *type;
+    const char *help;
+    uint64_t LoopStats::*field;
+    double scale; // 纳秒转换为秒
+};
+
+const MetricDesc kLoopMetrics[] = {
+    {"muduo_loop_iterations_total", "counter", "Event loop iterations (poll calls).", &LoopStats::iterations, 1},
+    {"muduo_loop_events_total", "counter", "Events returned by poll.", &LoopStats::events, 1},
+    {"muduo_loop_poll_seconds_total", "counter", "Time blocked in poll.", &LoopStats::pollNanos, 1e-9},
+    {"muduo_loop_busy_seconds_total", "counter", "Time spent dispatching events and functors.", &LoopStats::busyNanos, 1e-9},
+    {"muduo_loop_functors_total", "counter", "Pending functors executed.", &LoopStats::functors, 1},
+    {"muduo_loop_pending_functors", "gauge", "Functors waiting in the urgent lane.", &LoopStats::pendingFunctors, 1},
+    {"muduo_loop_bulk_functors_total", "counter", "Functors executed from the bulk lane.", &LoopStats::bulkFunctors, 1},
+    {"muduo_loop_pending_bulk_functors", "gauge", "Functors waiting in the bulk lane.", &LoopStats::pendingBulkFunctors, 1},
+    {"muduo_loop_bulk_carry_overs_total", "counter", "Iterations that left bulk functors for the next iteration.", &LoopStats::bulkCarryOvers, 1},
+    {"muduo_loop_wakeups_total", "counter", "Wakeups through the eventfd.", &LoopStats::wakeups, 1},
+    {"muduo_loop_read_bytes_total", "counter", "Bytes read from TCP connections.", &LoopStats::bytesRead, 1},
+    {"muduo_loop_written_bytes_total", "counter", "Bytes written to TCP connections.", &LoopStats::bytesWritten, 1},
+    {"muduo_loop_write_calls_total", "counter", "Write system calls on TCP connections.", &LoopStats::writeCalls, 1},
+    {"muduo_loop_reads_deferred_total", "counter", "Reads cut short by the per-iteration read budget.", &LoopStats::readsDeferred, 1},
+    {"muduo_loop_connections", "gauge", "Active TCP connections.", &LoopStats::connections, 1},
+    {"muduo_loop_buffer_bytes", "gauge", "Memory held by connection input/output buffers.", &LoopStats::bufferBytes, 1},
+};
+
+struct LatencyDesc {
+    const char *stage;
+    LatencyHistogram::Snapshot LoopLatencyStats::*field;
+};
+
+const LatencyDesc kLatencyStages[] = {
+    {"event", &LoopLatencyStats::eventHandling},
+    {"message", &LoopLatencyStats::messageCallback},
+    {"functor", &LoopLatencyStats::functorRun},
+    {"functor_delay", &LoopLatencyStats::functorDelay},
+    {"bulk_functor_delay", &LoopLatencyStats::bulkFunctorDelay},
+    {"read_delay", &LoopLatencyStats::readDelay},
+};
+
+const double kQuantiles[] = {0.5, 0.99, 0.999};
+
+// 第一个是mainLoop, 之后是subloop
+std::string loopLabel(size_t index) {
+    return index == 0 ? std::string("main") : "io" + std::to_string(index - 1);
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(EventLoop *loop, const InetAddress &listenAddr, const std::string &name)
+    : http_(loop, listenAddr, name) {
+    http_.setHttpCallback([this](const HttpRequest &request, HttpResponse *response) {
+        onRequest(request, response);
+    });
+}
+
+std::string MetricsServer::render() const {
+    // 先取快照, 同一次输出中同一loop的各项指标来自同一份快照
+    std::vector<std::vector<LoopStats>> stats;
+    std::vector<std::vector<LoopLatencyStats>> latencies;
+    for (TcpServer *server : servers_) {
+        stats.push_back(server->loopStats());
+        latencies.push_back(server->loopLatencyStats());
+    }
+
+    // 服务名长度不受限制, 标签直接拼接到输出中, 定长缓冲区只用于格式化数值
+    std::string out;
+    char value[64];
+    for (const MetricDesc &desc : kLoopMetrics) {
+        out.append("# HELP ").append(desc.name).append(" ").append(desc.help).append("\n");
+        out.append("# TYPE ").append(desc.name).append(" ").append(desc.type).append("\n");
+        for (size_t i = 0; i < servers_.size(); ++i) {
+            for (size_t j = 0; j < stats[i].size(); ++j) {
+                uint64_t v = stats[i][j].*desc.field;
+                if (desc.scale == 1) {
+                    snprintf(value, sizeof value, "%lu", static_cast<unsigned long>(v));
+                } else {
+                    snprintf(value, sizeof value, "%.6f", v * desc.scale);
+                }
+                out.append(desc.name).append("{server=\"").append(servers_[i]->name())
+                   .append("\",loop=\"").append(loopLabel(j)).append("\"} ").append(value).append("\n");
+            }
+        }
+    }
+
+    out.append("# HELP muduo_loop_latency_seconds Event handling, MessageCallback, functor run, functor queueing (per lane) and read queueing time.\n"
+               "# TYPE muduo_loop_latency_seconds summary\n");
+    for (size_t i = 0; i < servers_.size(); ++i) {
+        for (size_t j = 0; j < latencies[i].size(); ++j) {
+            for (const LatencyDesc &desc : kLatencyStages) {
+                const LatencyHistogram::Snapshot &h = latencies[i][j].*desc.field;
+                std::string labels = "server=\"" + servers_[i]->name() + "\",loop=\"" + loopLabel(j)
+                                     + "\",stage=\"" + desc.stage + "\"";
+                for (double q : kQuantiles) {
+                    snprintf(value, sizeof value, ",quantile=\"%g\"} %.9f\n", q, h.percentile(q) * 1e-9);
+                    out.append("muduo_loop_latency_seconds{").append(labels).append(value);
+                }
+                snprintf(value, sizeof value, "} %.9f\n", h.sum * 1e-9);
+                out.append("muduo_loop_latency_seconds_sum{").append(labels).append(value);
+                snprintf(value, sizeof value, "} %lu\n", static_cast<unsigned long>(h.count));
+                out.append("muduo_loop_latency_seconds_count{").append(labels).append(value);
+            }
+        }
+    }
+    return out;
+}
+
+void MetricsServer::onRequest(const HttpRequest &request, HttpResponse *response) {
+    if (request.path() != "/metrics") {
+        response->setStatusCode(HttpResponse::k404NotFound);
+        return;
+    }
+    response->setStatusCode(HttpResponse::k200Ok);
+    response->setContentType("text/plain; version=0.0.4");
+    response->setBody(render());
+}
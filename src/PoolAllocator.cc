@@ -0,0 +1,63 @@
+#include <new>
+
+#include "PoolAllocator.h"
+
+BlockPool::BlockPool(size_t maxFreeBlocks)
+    : blockSize_(0),
+      freeList_(nullptr),
+      freeCount_(0),
+      maxFreeBlocks_(maxFreeBlocks),
+      reused_(0),
+      allocated_(0) {
+}
+
+BlockPool::~BlockPool() {
+    while (freeList_) {
+        FreeBlock *block = freeList_;
+        freeList_ = block->next;
+        ::operator delete(block);
+    }
+}
+
+void* BlockPool::allocate(size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (blockSize_ == 0 && size >= sizeof(FreeBlock)) {
+            blockSize_ = size; // 第一次分配决定块大小
+        }
+        if (size == blockSize_ && freeList_) {
+            FreeBlock *block = freeList_;
+            freeList_ = block->next;
+            --freeCount_;
+            reused_.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+    }
+    allocated_.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+}
+
+void BlockPool::deallocate(void *p, size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size == blockSize_ && freeCount_ < maxFreeBlocks_) {
+            FreeBlock *block = static_cast<FreeBlock *>(p);
+            block->next = freeList_;
+            freeList_ = block;
+            ++freeCount_;
+            return;
+        }
+    }
+    ::operator delete(p);
+}
+
+BlockPool::Stats BlockPool::stats() const {
+    Stats stats;
+    stats.reused = reused_.load(std::memory_order_relaxed);
+    stats.allocated = allocated_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.freeBlocks = freeCount_;
+    }
+    return stats;
+}
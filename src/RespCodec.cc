@@ -0,0 +1,248 @@
+#include <charconv>
+#include <stdio.h>
+#include <string.h>
+
+#include "RespCodec.h"
+#include "Buffer.h"
+
+static inline char toLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool RespCommand::is(std::string_view name) const {
+    std::string_view cmd = argv[0];
+    if (cmd.size() != name.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < cmd.size(); ++i) {
+        if (toLower(cmd[i]) != toLower(name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * 解析"<整数>\r\n", 成功时*next指向\r\n之后
+ * 返回值: 1成功, 0数据不完整, -1格式错误
+ */
+static int parseLength(const char *p, const char *end, int64_t *value, const char **next) {
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    int64_t v = 0;
+    int digits = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (++digits > 18) {
+            return -1;
+        }
+        v = v * 10 + (*p - '0');
+        ++p;
+    }
+    if (end - p < 2) {
+        return (digits == 0 && p < end) ? -1 : 0;
+    }
+    if (digits == 0 || p[0] != '\r' || p[1] != '\n') {
+        return -1;
+    }
+    *value = negative ? -v : v;
+    *next = p + 2;
+    return 1;
+}
+
+RespParser::ParseResult RespParser::parse(const Buffer *buf, RespCommandBatch *batch) {
+    const char *begin = buf->peek() + parsed_;
+    const char *end = buf->peek() + buf->readableBytes();
+    size_t before = batch->size();
+
+    while (begin < end) {
+        size_t consumed = 0;
+        ParseResult result = *begin == '*'
+            ? parseOne(begin, end, batch, &consumed)
+            : parseInline(begin, end, batch, &consumed);
+        if (result == kError) {
+            // 先返回错误之前的完整命令, 下一次parse再报告错误
+            return batch->size() > before ? kComplete : kError;
+        }
+        if (result == kIncomplete) {
+            break;
+        }
+        begin += consumed;
+        parsed_ += consumed;
+    }
+    return batch->size() > before ? kComplete : kIncomplete;
+}
+
+void RespParser::consume(Buffer *buf) {
+    buf->retrieve(parsed_);
+    parsed_ = 0;
+}
+
+// *<n>\r\n 后跟n个 $<len>\r\n<data>\r\n
+RespParser::ParseResult RespParser::parseOne(const char *begin, const char *end,
+                                             RespCommandBatch *batch, size_t *consumed) {
+    int64_t count = 0;
+    const char *p = nullptr;
+    int rc = parseLength(begin + 1, end, &count, &p);
+    if (rc == 0) {
+        return kIncomplete;
+    }
+    if (rc < 0 || count > static_cast<int64_t>(kMaxArgs)) {
+        error_ = "invalid multibulk length";
+        return kError;
+    }
+    if (count <= 0) {
+        *consumed = p - begin; // 空数组, 忽略
+        return kComplete;
+    }
+
+    size_t first = batch->args_.size();
+    for (int64_t i = 0; i < count; ++i) {
+        if (p >= end) {
+            batch->args_.resize(first); // 撤销不完整命令已经解析出的参数
+            return kIncomplete;
+        }
+        if (*p != '$') {
+            batch->args_.resize(first);
+            error_ = "expected '$'";
+            return kError;
+        }
+        int64_t len = 0;
+        rc = parseLength(p + 1, end, &len, &p);
+        if (rc <= 0 || len < 0 || len > static_cast<int64_t>(kMaxBulkLen)) {
+            batch->args_.resize(first);
+            if (rc == 0) {
+                return kIncomplete;
+            }
+            error_ = "invalid bulk length";
+            return kError;
+        }
+        if (end - p < len + 2) {
+            batch->args_.resize(first);
+            return kIncomplete;
+        }
+        if (p[len] != '\r' || p[len + 1] != '\n') {
+            batch->args_.resize(first);
+            error_ = "bulk string not terminated by CRLF";
+            return kError;
+        }
+        batch->args_.emplace_back(p, static_cast<size_t>(len));
+        p += len + 2;
+    }
+
+    batch->commands_.push_back(RespCommandBatch::Range{first, static_cast<size_t>(count)});
+    *consumed = p - begin;
+    return kComplete;
+}
+
+// inline命令: 以空白分割的参数, 以\n或\r\n结尾
+RespParser::ParseResult RespParser::parseInline(const char *begin, const char *end,
+                                                RespCommandBatch *batch, size_t *consumed) {
+    const char *eol = static_cast<const char *>(::memchr(begin, '\n', end - begin));
+    if (eol == nullptr) {
+        if (static_cast<size_t>(end - begin) > kMaxInlineLen) {
+            error_ = "too big inline request";
+            return kError;
+        }
+        return kIncomplete;
+    }
+    *consumed = eol - begin + 1;
+    const char *lineEnd = (eol > begin && eol[-1] == '\r') ? eol - 1 : eol;
+
+    size_t first = batch->args_.size();
+    const char *p = begin;
+    while (p < lineEnd) {
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) ++p;
+        const char *word = p;
+        while (p < lineEnd && *p != ' ' && *p != '\t') ++p;
+        if (p > word) {
+            batch->args_.emplace_back(word, p - word);
+        }
+    }
+    size_t count = batch->args_.size() - first;
+    if (count > 0) {
+        batch->commands_.push_back(RespCommandBatch::Range{first, count});
+    }
+    return kComplete; // 空行直接忽略
+}
+
+void RespWriter::header(char type, int64_t value) {
+    char buf[24];
+    buf[0] = type;
+    char *p = std::to_chars(buf + 1, buf + sizeof buf - 2, value).ptr;
+    *p++ = '\r';
+    *p++ = '\n';
+    output_->append(buf, p - buf);
+}
+
+void RespWriter::simpleString(std::string_view s) {
+    output_->append("+", 1);
+    output_->append(s.data(), s.size());
+    output_->append("\r\n", 2);
+}
+
+void RespWriter::error(std::string_view message) {
+    output_->append("-", 1);
+    output_->append(message.data(), message.size());
+    output_->append("\r\n", 2);
+}
+
+void RespWriter::integer(int64_t value) {
+    header(':', value);
+}
+
+void RespWriter::bulk(std::string_view s) {
+    header('$', static_cast<int64_t>(s.size()));
+    output_->append(s.data(), s.size());
+    output_->append("\r\n", 2);
+}
+
+void RespWriter::null() {
+    if (protocol_ >= 3) {
+        output_->append("_\r\n", 3);
+    } else {
+        output_->append("$-1\r\n", 5);
+    }
+}
+
+void RespWriter::nullArray() {
+    if (protocol_ >= 3) {
+        output_->append("_\r\n", 3);
+    } else {
+        output_->append("*-1\r\n", 5);
+    }
+}
+
+void RespWriter::arrayHeader(size_t count) {
+    header('*', static_cast<int64_t>(count));
+}
+
+void RespWriter::mapHeader(size_t count) {
+    if (protocol_ >= 3) {
+        header('%', static_cast<int64_t>(count));
+    } else {
+        header('*', static_cast<int64_t>(count * 2));
+    }
+}
+
+void RespWriter::boolean(bool value) {
+    if (protocol_ >= 3) {
+        output_->append(value ? "#t\r\n" : "#f\r\n", 4);
+    } else {
+        output_->append(value ? ":1\r\n" : ":0\r\n", 4);
+    }
+}
+
+void RespWriter::doubleValue(double value) {
+    char buf[32];
+    int n = ::snprintf(buf, sizeof buf, "%.17g", value);
+    if (protocol_ >= 3) {
+        output_->append(",", 1);
+        output_->append(buf, n);
+        output_->append("\r\n", 2);
+    } else {
+        bulk(std::string_view(buf, n));
+    }
+}
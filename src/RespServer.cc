@@ -0,0 +1,80 @@
+#include <stdio.h>
+
+#include "RespServer.h"
+#include "Logger.h"
+
+namespace {
+
+// 每个连接的解析状态, 保存在TcpConnection的上下文中
+struct RespSession {
+    RespParser parser;
+    RespCommandBatch batch; // 复用参数数组, 避免每批命令重新分配
+    int protocol = 2; // 回复使用的协议版本
+};
+
+}
+
+// 默认回调: 所有命令返回未知命令错误
+static void defaultBatchCallback(const TcpConnectionPtr &, const RespCommandBatch &batch, RespWriter *writer) {
+    for (size_t i = 0; i < batch.size(); ++i) {
+        writer->error("ERR unknown command");
+    }
+}
+
+RespServer::RespServer(EventLoop *loop,
+                       const InetAddress &listenAddr,
+                       const std::string &name,
+                       TcpServer::Option option)
+    : server_(loop, listenAddr, name, option),
+      batchCallback_(defaultBatchCallback) {
+    server_.setConnectionCallback([this](const TcpConnectionPtr &conn) { onConnection(conn); });
+    server_.setMessageCallback([this](const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime) {
+        onMessage(conn, buf, receiveTime);
+    });
+}
+
+void RespServer::start() {
+    LOG_INFO("RespServer[%s] starts listening on %s\n", server_.name().c_str(), server_.ipPort().c_str());
+    server_.start();
+}
+
+void RespServer::onConnection(const TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+        conn->setContext(RespSession());
+    }
+}
+
+void RespServer::onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp) {
+    RespSession *session = std::any_cast<RespSession>(conn->getMutableContext());
+
+    while (true) {
+        session->batch.clear();
+        RespParser::ParseResult result = session->parser.parse(buf, &session->batch);
+        if (result == RespParser::kIncomplete) {
+            break;
+        }
+
+        RespWriter writer(conn->outputBuffer(), session->protocol);
+        if (result == RespParser::kError) {
+            char message[128];
+            ::snprintf(message, sizeof message, "ERR Protocol error: %s", session->parser.error());
+            writer.error(message);
+            buf->retrieveAll();
+            conn->flushOutput();
+            conn->shutdown();
+            return;
+        }
+
+        batchCallback_(conn, session->batch, &writer);
+        session->protocol = writer.protocol();
+        session->parser.consume(buf); // 回调结束后参数视图不再使用
+        if (writer.closeRequested()) {
+            buf->retrieveAll(); // 连接即将关闭, 丢弃后续命令
+            conn->flushOutput();
+            conn->shutdown();
+            return;
+        }
+    }
+
+    conn->flushOutput(); // 整批回复一次发送
+}
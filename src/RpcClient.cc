@@ -0,0 +1,157 @@
+#include <algorithm>
+
+#include "RpcClient.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+RpcClient::RpcClient(EventLoop *loop, const InetAddress &serverAddr, const std::string &name)
+    : loop_(loop),
+      client_(loop, serverAddr, name),
+      codec_([this](const TcpConnectionPtr &conn, std::string_view frame, Timestamp receiveTime) {
+          onFrame(conn, frame, receiveTime);
+      }),
+      dispatching_(false),
+      nextId_(1),
+      deadlineTimer_(0),
+      timerExpiration_(0) {
+    client_.setConnectionCallback([this](const TcpConnectionPtr &conn) { onConnection(conn); });
+    client_.setMessageCallback([this](const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime) {
+        onMessage(conn, buf, receiveTime);
+    });
+}
+
+RpcClient::~RpcClient() {
+    if (deadlineTimer_ != 0) {
+        loop_->cancel(deadlineTimer_);
+    }
+}
+
+void RpcClient::call(std::string_view method, std::string_view request, ResponseCallback cb, int timeoutMs) {
+    if (loop_->isInLoopThread()) {
+        callInLoop(method, request, cb, timeoutMs);
+    } else {
+        loop_->queueInLoop([this, m = std::string(method), r = std::string(request),
+                            cb = std::move(cb), timeoutMs]() mutable {
+            callInLoop(m, r, cb, timeoutMs);
+        });
+    }
+}
+
+void RpcClient::callInLoop(std::string_view method, std::string_view request, ResponseCallback &cb, int timeoutMs) {
+    if (!connection_ || method.empty() || method.size() > RpcMessage::kMaxMethodLen) {
+        cb(connection_ ? kRpcBadRequest : kRpcConnectionLost, std::string_view());
+        return;
+    }
+
+    uint64_t id = nextId_++;
+    int64_t deadline = 0;
+    if (timeoutMs > 0) {
+        deadline = TimerQueue::now() + static_cast<int64_t>(timeoutMs) * 1000;
+        deadlines_.push(Deadline(deadline, id));
+    }
+    pending_.emplace(id, PendingCall{std::move(cb), deadline});
+
+    RpcMessage::appendRequest(connection_->outputBuffer(), id, method,
+                              static_cast<uint32_t>(timeoutMs > 0 ? timeoutMs : 0), request);
+    if (!dispatching_) {
+        connection_->flushOutput();
+    }
+    if (deadline != 0 && (timerExpiration_ == 0 || deadline < timerExpiration_)) {
+        scheduleDeadlineTimer();
+    }
+}
+
+void RpcClient::onConnection(const TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+        conn->setTcpNoDelay(true);
+        connection_ = conn;
+    } else {
+        connection_.reset();
+        failAll(kRpcConnectionLost);
+    }
+    if (connectionCallback_) {
+        connectionCallback_(conn);
+    }
+}
+
+void RpcClient::onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime) {
+    dispatching_ = true;
+    codec_.onMessage(conn, buf, receiveTime);
+    dispatching_ = false;
+    if (connection_) {
+        connection_->flushOutput(); // 回调中发起的新调用一次发送
+    }
+}
+
+void RpcClient::onFrame(const TcpConnectionPtr &conn, std::string_view frame, Timestamp) {
+    RpcMessage msg;
+    if (!msg.decode(frame) || msg.type != RpcMessage::kResponse) {
+        LOG_ERROR("RpcClient::onFrame bad response from %s\n", conn->name().c_str());
+        conn->forceClose();
+        return;
+    }
+    complete(msg.id, msg.status, msg.payload);
+}
+
+void RpcClient::complete(uint64_t id, RpcStatus status, std::string_view response) {
+    auto it = pending_.find(id);
+    if (it == pending_.end()) {
+        return; // 已超时的调用, 丢弃迟到的响应
+    }
+    // 回调中可能发起新调用修改pending_, 先取出再执行
+    ResponseCallback cb = std::move(it->second.callback);
+    pending_.erase(it);
+    cb(status, response);
+}
+
+void RpcClient::failAll(RpcStatus status) {
+    std::unordered_map<uint64_t, PendingCall> pending;
+    pending.swap(pending_);
+    deadlines_ = decltype(deadlines_)();
+    for (auto &item : pending) {
+        item.second.callback(status, std::string_view());
+    }
+}
+
+void RpcClient::scheduleDeadlineTimer() {
+    if (deadlineTimer_ != 0) {
+        loop_->cancel(deadlineTimer_);
+        deadlineTimer_ = 0;
+        timerExpiration_ = 0;
+    }
+    if (deadlines_.empty()) {
+        return;
+    }
+    timerExpiration_ = deadlines_.top().first;
+    // 定时器间隔至少kMinTimerIntervalUs, 负载高时一次处理一批到期的调用
+    int64_t delay = std::max(timerExpiration_ - TimerQueue::now(), kMinTimerIntervalUs);
+    deadlineTimer_ = loop_->runAfter(static_cast<double>(delay) / 1000000, [this]() {
+        deadlineTimer_ = 0;
+        timerExpiration_ = 0;
+        handleDeadlines();
+    });
+}
+
+void RpcClient::handleDeadlines() {
+    int64_t current = TimerQueue::now();
+    while (!deadlines_.empty() && deadlines_.top().first <= current) {
+        Deadline top = deadlines_.top();
+        deadlines_.pop();
+        auto it = pending_.find(top.second);
+        if (it != pending_.end() && it->second.deadline == top.first) {
+            complete(top.second, kRpcDeadlineExceeded, std::string_view());
+        }
+    }
+
+    // 大部分调用在截止时间前完成, 堆中残留的记录过多时重建
+    if (deadlines_.size() > 2 * pending_.size() + 1024) {
+        std::vector<Deadline> live;
+        for (const auto &item : pending_) {
+            if (item.second.deadline != 0) {
+                live.push_back(Deadline(item.second.deadline, item.first));
+            }
+        }
+        deadlines_ = decltype(deadlines_)(std::greater<Deadline>(), std::move(live));
+    }
+    scheduleDeadlineTimer();
+}
@@ -0,0 +1,83 @@
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "RpcMessage.h"
+#include "Buffer.h"
+
+const char* rpcStatusName(RpcStatus status) {
+    switch (status) {
+        case kRpcOk: return "OK";
+        case kRpcMethodNotFound: return "METHOD_NOT_FOUND";
+        case kRpcDeadlineExceeded: return "DEADLINE_EXCEEDED";
+        case kRpcConnectionLost: return "CONNECTION_LOST";
+        case kRpcBadRequest: return "BAD_REQUEST";
+        case kRpcApplicationError: return "APPLICATION_ERROR";
+    }
+    return "UNKNOWN";
+}
+
+// 与Buffer::peekInt64/peekInt32相同的网络字节序解码
+static uint64_t readUint64(const char *p) {
+    uint32_t be[2];
+    ::memcpy(be, p, sizeof be);
+    return (static_cast<uint64_t>(ntohl(be[0])) << 32) | ntohl(be[1]);
+}
+
+static uint32_t readUint32(const char *p) {
+    uint32_t be;
+    ::memcpy(&be, p, sizeof be);
+    return ntohl(be);
+}
+
+bool RpcMessage::decode(std::string_view frame) {
+    if (frame.empty()) {
+        return false;
+    }
+    const char *p = frame.data();
+    type = static_cast<Type>(p[0]);
+    if (type == kRequest) {
+        if (frame.size() < kRequestHeaderLen) {
+            return false;
+        }
+        id = readUint64(p + 1);
+        timeoutMs = readUint32(p + 9);
+        size_t methodLen = static_cast<uint8_t>(p[13]);
+        if (methodLen == 0 || frame.size() < kRequestHeaderLen + methodLen) {
+            return false;
+        }
+        status = kRpcOk;
+        method = frame.substr(kRequestHeaderLen, methodLen);
+        payload = frame.substr(kRequestHeaderLen + methodLen);
+        return true;
+    } else if (type == kResponse) {
+        if (frame.size() < kResponseHeaderLen) {
+            return false;
+        }
+        id = readUint64(p + 1);
+        timeoutMs = 0;
+        status = static_cast<RpcStatus>(p[9]);
+        method = std::string_view();
+        payload = frame.substr(kResponseHeaderLen);
+        return true;
+    }
+    return false;
+}
+
+void RpcMessage::appendRequest(Buffer *output, uint64_t id, std::string_view method,
+                               uint32_t timeoutMs, std::string_view payload) {
+    output->appendInt32(static_cast<int32_t>(kRequestHeaderLen + method.size() + payload.size()));
+    output->appendInt8(kRequest);
+    output->appendInt64(static_cast<int64_t>(id));
+    output->appendInt32(static_cast<int32_t>(timeoutMs));
+    output->appendInt8(static_cast<int8_t>(method.size()));
+    output->append(method.data(), method.size());
+    output->append(payload.data(), payload.size());
+}
+
+void RpcMessage::appendResponse(Buffer *output, uint64_t id, RpcStatus status, std::string_view payload) {
+    output->appendInt32(static_cast<int32_t>(kResponseHeaderLen + payload.size()));
+    output->appendInt8(kResponse);
+    output->appendInt64(static_cast<int64_t>(id));
+    output->appendInt8(static_cast<int8_t>(status));
+    output->append(payload.data(), payload.size());
+}
@@ -0,0 +1,106 @@
+#include "RpcServer.h"
+#include "TimerQueue.h"
+#include "Logger.h"
+
+namespace {
+
+// 每个连接的状态, 保存在TcpConnection的上下文中
+struct RpcSession {
+    bool flushQueued = false; // 已经安排了发送异步应答的任务
+};
+
+}
+
+// 当前线程正在分发请求的连接, 同步应答先写入输出缓冲区, 分发结束后统一发送
+static __thread TcpConnection *t_dispatchingConn = nullptr;
+
+bool RpcResponder::expired() const {
+    return deadline_ != 0 && TimerQueue::now() > deadline_;
+}
+
+void RpcResponder::send(RpcStatus status, std::string_view payload) const {
+    TcpConnectionPtr conn = conn_.lock();
+    if (!conn || expired()) {
+        return; // 连接已断开, 或客户端已按超时处理
+    }
+    if (conn->getLoop()->isInLoopThread()) {
+        RpcMessage::appendResponse(conn->outputBuffer(), id_, status, payload);
+        if (t_dispatchingConn != conn.get()) {
+            conn->flushOutput();
+        }
+    } else {
+        // 异步应答, 拷贝响应体交给连接所属的loop
+        uint64_t id = id_;
+        conn->getLoop()->queueInLoop([conn, id, status, data = std::string(payload)]() {
+            RpcMessage::appendResponse(conn->outputBuffer(), id, status, data);
+            // 同一轮中到达的多个异步应答合并为一次发送
+            RpcSession *session = std::any_cast<RpcSession>(conn->getMutableContext());
+            if (session && !session->flushQueued) {
+                session->flushQueued = true;
+                conn->getLoop()->queueInLoop([conn, session]() {
+                    session->flushQueued = false;
+                    conn->flushOutput();
+                });
+            }
+        });
+    }
+}
+
+RpcServer::RpcServer(EventLoop *loop,
+                     const InetAddress &listenAddr,
+                     const std::string &name,
+                     TcpServer::Option option)
+    : server_(loop, listenAddr, name, option),
+      codec_([this](const TcpConnectionPtr &conn, std::string_view frame, Timestamp receiveTime) {
+          onFrame(conn, frame, receiveTime);
+      }) {
+    server_.setConnectionCallback([this](const TcpConnectionPtr &conn) { onConnection(conn); });
+    server_.setMessageCallback([this](const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime) {
+        onMessage(conn, buf, receiveTime);
+    });
+}
+
+void RpcServer::registerMethod(const std::string &name, const MethodHandler &handler) {
+    if (name.empty() || name.size() > RpcMessage::kMaxMethodLen) {
+        LOG_ERROR("RpcServer::registerMethod invalid method name %s\n", name.c_str());
+        return;
+    }
+    methods_[name] = handler;
+}
+
+void RpcServer::start() {
+    LOG_INFO("RpcServer[%s] starts listening on %s\n", server_.name().c_str(), server_.ipPort().c_str());
+    server_.start();
+}
+
+void RpcServer::onConnection(const TcpConnectionPtr &conn) {
+    if (conn->connected()) {
+        conn->setTcpNoDelay(true);
+        conn->setContext(RpcSession());
+    }
+}
+
+void RpcServer::onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp receiveTime) {
+    t_dispatchingConn = conn.get();
+    codec_.onMessage(conn, buf, receiveTime);
+    t_dispatchingConn = nullptr;
+    conn->flushOutput();
+}
+
+void RpcServer::onFrame(const TcpConnectionPtr &conn, std::string_view frame, Timestamp) {
+    RpcMessage msg;
+    if (!msg.decode(frame) || msg.type != RpcMessage::kRequest) {
+        LOG_ERROR("RpcServer::onFrame bad request from %s\n", conn->name().c_str());
+        conn->shutdown();
+        return;
+    }
+    int64_t deadline = msg.timeoutMs > 0 ? TimerQueue::now() + static_cast<int64_t>(msg.timeoutMs) * 1000 : 0;
+    RpcResponder responder(conn, msg.id, deadline);
+
+    auto it = methods_.find(msg.method);
+    if (it == methods_.end()) {
+        responder.fail(kRpcMethodNotFound, msg.method);
+        return;
+    }
+    it->second(msg.payload, std::move(responder));
+}
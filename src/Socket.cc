@@ -13,7 +13,7 @@ Socket::~Socket() {
 }
 
 void Socket::bindAddress(const InetAddress &localaddr) {
-    if (0 != ::bind(sockfd_, (sockaddr *)localaddr.getSockAddr(), sizeof(sockaddr_in))) {
+    if (0 != ::bind(sockfd_, localaddr.getSockAddr(), localaddr.getSockLen())) {
         LOG_FATAL("bind sockfd:%d fail\n", sockfd_);
     }
 }
@@ -25,12 +25,13 @@ void Socket::listen() {
 }
 
 int Socket::accept(InetAddress *peeraddr) {
-    sockaddr_in addr;
+    sockaddr_storage addr; // 足够存放任意地址族
     socklen_t addrlen = sizeof(addr);
     ::memset(&addr, 0, sizeof(addr));
-    int connfd = ::accept(sockfd_, (sockaddr *)&addr, &addrlen);
+    // 监听socket的O_NONBLOCK不会被新连接继承, 需要在accept4时设置
+    int connfd = ::accept4(sockfd_, (sockaddr *)&addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
     if (connfd >= 0) {
-        peeraddr->setSockAddr(addr);
+        peeraddr->setSockAddr((sockaddr *)&addr, addrlen);
     } else {
         LOG_ERROR("accept sockfd:%d fail\n", sockfd_);
     }
@@ -61,4 +62,27 @@ void Socket::setReusePort(bool on) {
 void Socket::setKeepAlive(bool on) {
     int optval = on ? 1 : 0;
     ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof(optval));
-}
\ No newline at end of file
+}
+
+int Socket::incomingCpu(int sockfd) {
+#ifdef SO_INCOMING_CPU
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0) {
+        return cpu;
+    }
+#endif
+    return -1;
+}
+
+int Socket::incomingNapiId(int sockfd) {
+#ifdef SO_INCOMING_NAPI_ID
+    unsigned int napiId = 0;
+    socklen_t len = sizeof(napiId);
+    // napi_id为0表示该连接没有经过NAPI收包(如loopback)
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_INCOMING_NAPI_ID, &napiId, &len) == 0 && napiId != 0) {
+        return static_cast<int>(napiId);
+    }
+#endif
+    return -1;
+}
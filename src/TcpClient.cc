@@ -0,0 +1,128 @@
+#include <sys/socket.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "TcpClient.h"
+#include "Connector.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+static EventLoop *CheckLoopNotNull(EventLoop *loop) {
+    if (loop == nullptr) {
+        LOG_FATAL("%s:%s:%d loop is null!\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+    return loop;
+}
+
+// TcpClient析构后连接仍可能存活, 此时由该函数销毁连接
+static void removeConnectionAfterClient(EventLoop *loop, const TcpConnectionPtr &conn) {
+    loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+TcpClient::TcpClient(EventLoop *loop, const InetAddress &serverAddr, const std::string &nameArg)
+    : loop_(CheckLoopNotNull(loop)),
+      connector_(new Connector(loop, serverAddr)),
+      name_(nameArg),
+      retry_(false),
+      connect_(false),
+      nextConnId_(1) {
+    connector_->setNewConnectionCallback([this](int sockfd) { newConnection(sockfd); });
+}
+
+TcpClient::~TcpClient() {
+    TcpConnectionPtr conn;
+    bool unique = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unique = connection_.use_count() == 1;
+        conn = connection_;
+    }
+    if (conn) {
+        // 连接不再回调已析构的TcpClient及其使用者
+        EventLoop *loop = loop_;
+        loop_->runInLoop([conn, loop]() {
+            conn->setConnectionCallback(ConnectionCallback());
+            conn->setMessageCallback(MessageCallback());
+            conn->setCloseCallback([loop](const TcpConnectionPtr &c) { removeConnectionAfterClient(loop, c); });
+        });
+        if (unique) {
+            conn->forceClose();
+        }
+    } else {
+        connector_->stop();
+    }
+}
+
+void TcpClient::setLocalAddress(const InetAddress &localAddr) {
+    connector_->setLocalAddress(localAddr);
+}
+
+void TcpClient::connect() {
+    LOG_INFO("TcpClient::connect[%s] - connecting to %s\n",
+             name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+    connect_ = true;
+    connector_->start();
+}
+
+void TcpClient::disconnect() {
+    connect_ = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (connection_) {
+        connection_->shutdown();
+    }
+}
+
+void TcpClient::stop() {
+    connect_ = false;
+    connector_->stop();
+}
+
+void TcpClient::newConnection(int sockfd) {
+    sockaddr_storage local, peer;
+    ::memset(&local, 0, sizeof local);
+    ::memset(&peer, 0, sizeof peer);
+    socklen_t localLen = sizeof local;
+    if (::getsockname(sockfd, (sockaddr *)&local, &localLen) < 0) {
+        LOG_ERROR("sockets::getLocalAddr");
+    }
+    socklen_t peerLen = sizeof peer;
+    if (::getpeername(sockfd, (sockaddr *)&peer, &peerLen) < 0) {
+        LOG_ERROR("sockets::getPeerAddr");
+    }
+    InetAddress localAddr((sockaddr *)&local, localLen);
+    InetAddress peerAddr((sockaddr *)&peer, peerLen);
+
+    char buf[64] = {0};
+    snprintf(buf, sizeof buf, ":%s#%lu", peerAddr.toIpPort().c_str(), static_cast<unsigned long>(nextConnId_));
+    uint64_t connId = nextConnId_++;
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn(new TcpConnection(loop_, connName, connId, sockfd, localAddr, peerAddr));
+    conn->setConnectionCallback(connectionCallback_);
+    conn->setMessageCallback(messageCallback_);
+    conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setCloseCallback([this](const TcpConnectionPtr &c) { removeConnection(c); });
+#ifdef MUDUO_WITH_TLS
+    if (tlsContext_) {
+        conn->startTls(tlsContext_.get(), tlsServerName_);
+    }
+#endif
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_ = conn;
+    }
+    conn->connectEstablished();
+}
+
+void TcpClient::removeConnection(const TcpConnectionPtr &conn) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_.reset();
+    }
+    loop_->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    if (retry_ && connect_) {
+        LOG_INFO("TcpClient::connect[%s] - Reconnecting to %s\n",
+                 name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+        connector_->restart();
+    }
+}
@@ -3,6 +3,7 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <string.h>
 #include <netinet/tcp.h>
 
@@ -11,6 +12,10 @@
 #include "Socket.h"
 #include "Channel.h"
 #include "EventLoop.h"
+#include "WorkStealingThreadPool.h"
+#ifdef MUDUO_WITH_TLS
+#include "TlsStream.h"
+#endif
 
 static EventLoop *CheckLoopNotNull(EventLoop *loop) {
     if (loop == nullptr) {
@@ -21,31 +26,54 @@ static EventLoop *CheckLoopNotNull(EventLoop *loop) {
 
 TcpConnection::TcpConnection(EventLoop *loop,
                              const std::string &name,
+                             uint64_t id,
                              int sockfd,
                              const InetAddress &localaddr,
                              const InetAddress &peeraddr)
     : loop_(CheckLoopNotNull(loop)),
       name_(name),
+      id_(id),
       state_(kConnecting), // 连接状态设置为连接中
       reading_(true),
-      socket_(new Socket(sockfd)),
-      channel_(new Channel(loop, sockfd)),
+      socket_(sockfd),
+      channel_(loop, sockfd),
       localaddr_(localaddr),
       peeraddr_(peeraddr),
-      highWaterMark_(64 * 1024 * 1024) { // 64M
-    // 设置channel的回调函数
-    channel_->setReadCallback(std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
-    channel_->setWriteCallback(std::bind(&TcpConnection::handleWrite, this));
-    channel_->setCloseCallback(std::bind(&TcpConnection::handleClose, this));
-    channel_->setErrorCallback(std::bind(&TcpConnection::handleError, this));
+      highWaterMark_(64 * 1024 * 1024), // 64M
+      readBudget_(0),
+      deferredReadScheduled_(false),
+      deferredReadPending_(false),
+      inputDeferred_(false),
+      deliveredIteration_(0),
+      autoCork_(false),
+      flushScheduled_(false),
+      backpressureHighMark_(64 * 1024 * 1024),
+      backpressureLowMark_(32 * 1024 * 1024),
+      backpressureApplied_(false),
+      readPauseCount_(0),
+      sharedBytes_(0),
+      bufferBytes_(0),
+      countedInLoop_(false),
+      outbound_(nullptr) {
+    // 设置channel的回调函数, 只捕获this的lambda可放入std::function的内部存储, 不需要额外分配内存
+    channel_.setReadCallback([this](Timestamp receiveTime) { handleRead(receiveTime); });
+    channel_.setWriteCallback([this]() { handleWrite(); });
+    channel_.setCloseCallback([this]() { handleClose(); });
+    channel_.setErrorCallback([this]() { handleError(); });
 
     LOG_INFO("TcpConnection::ctor[%s] at %p fd=%d\n", name_.c_str(), this, sockfd);
-    socket_->setKeepAlive(true); // 开启TCP keep-alive属性
+    socket_.setKeepAlive(true); // 开启TCP keep-alive属性
 }
 
 TcpConnection::~TcpConnection() {
     LOG_INFO("TcpConnection::dtor[%s] at %p fd=%d state=%d\n",
-             name_.c_str(), this, channel_->fd(), (int)state_);
+             name_.c_str(), this, channel_.fd(), (int)state_);
+    OutboundMessage *message = outbound_.load(std::memory_order_acquire);
+    while (message) { // 连接断开后才到达的消息
+        OutboundMessage *next = message->next;
+        delete message;
+        message = next;
+    }
 }
 
 void TcpConnection::send(const std::string &buf) {
@@ -53,23 +81,242 @@ void TcpConnection::send(const std::string &buf) {
         if (loop_->isInLoopThread()) { // 单reactor情况, 发送数据的操作在当前loop所在的线程
             sendInLoop(buf.data(), buf.size());
         } else {
-            loop_->runInLoop(std::bind(&TcpConnection::sendInLoop, shared_from_this(), buf.data(), buf.size()));
+            pushOutbound(std::string(buf)); // 调用者的buf可能在loop发送之前就被释放, 需要拷贝
+        }
+    }
+}
+
+void TcpConnection::send(std::string &&buf) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(buf.data(), buf.size());
+        } else {
+            pushOutbound(std::move(buf));
+        }
+    }
+}
+
+void TcpConnection::send(Buffer *buf) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendInLoop(buf->peek(), buf->readableBytes());
+            buf->retrieveAll();
+        } else {
+            pushOutbound(buf->retrieveAllAsString()); // 跨线程发送, 数据需要拷贝一份交给loop
+        }
+    }
+}
+
+void TcpConnection::sendShared(const SharedPayload &payload) {
+    if (state_ == kConnected) {
+        if (loop_->isInLoopThread()) {
+            sendSharedInLoop(payload);
+        } else {
+            pushOutbound(std::string(), payload); // 与其他线程的send共用一个队列, 保持顺序
         }
     }
 }
+
+bool TcpConnection::canShareOutput() const {
+#ifdef MUDUO_WITH_TLS
+    if (tls_ && !tls_->ktlsSend()) {
+        return false; // SSL_write不支持writev
+    }
+#endif
+    return true;
+}
+
+void TcpConnection::sendSharedInLoop(const SharedPayload &payload) {
+    if (state_ == kDisconnected || payload->empty()) {
+        return;
+    }
+    if (outputBuffer_.readableBytes() > 0 || !canShareOutput()) {
+        sendInLoop(payload->data(), payload->size()); // 输出缓冲区中的数据更早, 共享负载不能排到它前面
+        return;
+    }
+    queueSharedOutput(payload, 0);
+    if (autoCork_) {
+        scheduleCorkedFlush();
+    } else if (!channel_.isWriting()) {
+        flushOutput(); // 发送并在有剩余时注册可写事件
+    } else if (backpressureHighMark_ > 0
+               && !backpressureApplied_
+               && outputBytes() >= backpressureHighMark_) {
+        applyBackpressure();
+    }
+}
+
+void TcpConnection::queueSharedOutput(const SharedPayload &payload, size_t offset) {
+    checkHighWaterMark(payload->size() - offset);
+    sharedOutput_.emplace_back(payload, offset);
+    sharedBytes_ += payload->size() - offset;
+}
+
+void TcpConnection::pushOutbound(std::string &&data, SharedPayload shared) {
+    OutboundMessage *message = new OutboundMessage{std::move(data), std::move(shared), nullptr};
+    OutboundMessage *head = outbound_.load(std::memory_order_relaxed);
+    do {
+        message->next = head;
+    } while (!outbound_.compare_exchange_weak(head, message, std::memory_order_release, std::memory_order_relaxed));
+    if (head == nullptr) {
+        // 栈由空变为非空, 由本线程唤醒loop; 在drain取走之前压入的消息都由这一次drain发送
+        loop_->queueInLoop(std::bind(&TcpConnection::drainOutbound, shared_from_this()));
+    }
+}
+
+void TcpConnection::drainOutbound() {
+    // 取走整个栈并反转, 恢复压栈(发送)的顺序
+    OutboundMessage *stack = outbound_.exchange(nullptr, std::memory_order_acquire);
+    OutboundMessage *message = nullptr;
+    while (stack) {
+        OutboundMessage *next = stack->next;
+        stack->next = message;
+        message = stack;
+        stack = next;
+    }
+    auto popMessage = [&message]() {
+        OutboundMessage *next = message->next;
+        delete message;
+        message = next;
+    };
+    if (state_ == kDisconnected) {
+        while (message) popMessage();
+        return;
+    }
+
+    bool direct = !autoCork_ && !channel_.isWriting() && outputBytes() == 0 && canShareOutput();
+    size_t written = 0; // 队首消息中已经写出的字节数
+    if (direct) {
+        // 一次writev发送所有消息, 不拷贝到输出缓冲区
+        static const int kMaxIov = 256;
+        iovec iov[kMaxIov];
+        int count = 0;
+        for (OutboundMessage *m = message; m && count < kMaxIov; m = m->next) {
+            iov[count].iov_base = const_cast<char *>(m->bytes());
+            iov[count].iov_len = m->size();
+            ++count;
+        }
+        int savedErrno = 0;
+        ssize_t n = writevSocket(iov, count, &savedErrno);
+        if (n < 0) {
+            n = 0;
+            if (savedErrno != EWOULDBLOCK) {
+                LOG_ERROR("TcpConnection::drainOutbound");
+                if (savedErrno == EPIPE || savedErrno == ECONNRESET) { // 对端已关闭, 等待handleClose
+                    while (message) popMessage();
+                    return;
+                }
+            }
+        }
+        written = static_cast<size_t>(n);
+        while (message && written >= message->size()) {
+            written -= message->size();
+            popMessage();
+        }
+        if (!message) {
+            if (writeCompleteCallback_) {
+                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            return;
+        }
+    }
+
+    // 剩余的消息按顺序追加到输出队列; 共享负载在输出缓冲区为空时只引用, 否则拷贝以保持顺序
+    while (message) {
+        if (message->shared && outputBuffer_.readableBytes() == 0 && canShareOutput()) {
+            queueSharedOutput(message->shared, written);
+            if (autoCork_) {
+                scheduleCorkedFlush();
+            }
+        } else if (autoCork_) {
+            appendCorked(message->bytes() + written, message->size() - written);
+        } else {
+            appendOutput(message->bytes() + written, message->size() - written);
+        }
+        written = 0;
+        popMessage();
+    }
+    if (autoCork_) {
+        return;
+    }
+    updateBufferMetrics();
+    if (!channel_.isWriting()) {
+        flushOutput(); // 发送并在有剩余时注册可写事件
+    } else if (backpressureHighMark_ > 0
+               && !backpressureApplied_
+               && outputBytes() >= backpressureHighMark_) {
+        applyBackpressure();
+    }
+}
+
+void TcpConnection::appendOutput(const char *data, size_t len) {
+    checkHighWaterMark(len);
+    outputBuffer_.append(data, len);
+}
+
+void TcpConnection::checkHighWaterMark(size_t len) {
+    size_t oldLen = outputBytes();
+    if (oldLen + len >= highWaterMark_ && oldLen < highWaterMark_ && highWaterMarkCallback_) {
+        loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + len));
+    }
+}
+
+void TcpConnection::flushOutput() {
+    if (state_ == kDisconnected) {
+        outputBuffer_.retrieveAll(); // 连接已断开, 丢弃新写入的数据
+        sharedOutput_.clear();
+        sharedBytes_ = 0;
+        return;
+    }
+    if (channel_.isWriting() || outputBytes() == 0) {
+        return; // 已注册可写事件, 剩余数据由handleWrite发送
+    }
+
+    int savedErrno = 0;
+    ssize_t n = writeOutput(&savedErrno);
+    if (n < 0 && savedErrno != EWOULDBLOCK) {
+        LOG_ERROR("TcpConnection::flushOutput");
+        if (savedErrno == EPIPE || savedErrno == ECONNRESET) {
+            outputBuffer_.retrieveAll(); // 对端已关闭, 等待handleClose
+            sharedOutput_.clear();
+            sharedBytes_ = 0;
+            return;
+        }
+    }
+
+    updateBufferMetrics(); // 上层协议可能直接写入输出缓冲区使其扩容
+    if (outputBytes() == 0) {
+        if (writeCompleteCallback_) {
+            loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        return;
+    }
+    channel_.enableWriting(); // 还有剩余数据, 注册channel的可写事件
+    if (backpressureHighMark_ > 0
+        && !backpressureApplied_
+        && outputBytes() >= backpressureHighMark_) {
+        applyBackpressure();
+    }
+}
+
 /**
  * 发送数据, 应用写数据快, 内核发送数据慢, 需要将待发送数据写入outputBuffer_缓冲区,
  * 并注册channel的可写事件, 当socket可写时, 通过handleWrite回调函数将数据发送出去
  * 且设置了高水位回调
  */
 void TcpConnection::sendInLoop(const void *data, size_t len) {
+    if (autoCork_) {
+        appendCorked(data, len);
+        return;
+    }
     ssize_t nwrote = 0;
     size_t remaining = len; // 剩余待发送数据的长度
     bool faultError = false;
+    int savedErrno = 0;
 
     // channel_第一次写数据, 且outputBuffer_中没有待发送数据
-    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) {
-        nwrote = ::write(channel_->fd(), data, len); // 直接写数据到内核发送缓冲区
+    if (!channel_.isWriting() && outputBytes() == 0) {
+        nwrote = writeSocket(data, len, &savedErrno); // 直接写数据到内核发送缓冲区
         if (nwrote >= 0) {
             remaining = len - nwrote;
             if (remaining == 0 && writeCompleteCallback_) {
@@ -78,9 +325,9 @@ void TcpConnection::sendInLoop(const void *data, size_t len) {
             }
         } else { // nwrote < 0
             nwrote = 0;
-            if (errno != EWOULDBLOCK) { // EWOULDBLOCK表示非阻塞没有数据后的正常返回
+            if (savedErrno != EWOULDBLOCK) { // EWOULDBLOCK表示非阻塞没有数据后的正常返回
                 LOG_ERROR("TcpConnection::sendInLoop");
-                if (errno == EPIPE || errno == ECONNRESET) { // SIGPIPE
+                if (savedErrno == EPIPE || savedErrno == ECONNRESET) { // SIGPIPE
                     faultError = true;
                 }
             }
@@ -89,7 +336,7 @@ void TcpConnection::sendInLoop(const void *data, size_t len) {
 
     // 还有剩余数据没有发送完, 则放入outputBuffer_中, 并注册channel的可写事件
     if (!faultError && remaining > 0) {
-        size_t oldLen = outputBuffer_.readableBytes();
+        size_t oldLen = outputBytes();
         if (oldLen + remaining >= highWaterMark_
             && oldLen < highWaterMark_
             && highWaterMarkCallback_) {
@@ -97,12 +344,44 @@ void TcpConnection::sendInLoop(const void *data, size_t len) {
             loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
         }
         outputBuffer_.append((const char *)data + nwrote, remaining);
-        if (!channel_->isWriting()) {
-            channel_->enableWriting(); // 注册channel的可写事件
+        updateBufferMetrics();
+        if (!channel_.isWriting()) {
+            channel_.enableWriting(); // 注册channel的可写事件
+        }
+        if (backpressureHighMark_ > 0
+            && !backpressureApplied_
+            && outputBytes() >= backpressureHighMark_) {
+            applyBackpressure(); // 输出积压, 停止读取数据来源
         }
     }
 }
 
+void TcpConnection::appendCorked(const void *data, size_t len) {
+    appendOutput(static_cast<const char *>(data), len);
+    scheduleCorkedFlush();
+}
+
+void TcpConnection::scheduleCorkedFlush() {
+    if (channel_.isWriting()) {
+        // 已注册可写事件, 由handleWrite发送
+        updateBufferMetrics();
+        if (backpressureHighMark_ > 0
+            && !backpressureApplied_
+            && outputBytes() >= backpressureHighMark_) {
+            applyBackpressure();
+        }
+        return;
+    }
+    if (!flushScheduled_) {
+        flushScheduled_ = true;
+        TcpConnectionPtr guardThis(shared_from_this());
+        loop_->runAfterDispatch([guardThis]() {
+            guardThis->flushScheduled_ = false;
+            guardThis->flushOutput(); // 期间可能已经flushOutput过, 此时没有数据, 直接返回
+        });
+    }
+}
+
 void TcpConnection::shutdown() {
     if (state_ == kConnected) {
         setState(kDisconnecting);
@@ -110,38 +389,347 @@ void TcpConnection::shutdown() {
     }
 }
 
+void TcpConnection::forceClose() {
+    // kConnecting: TLS握手还未完成
+    if (state_ == kConnected || state_ == kDisconnecting || state_ == kConnecting) {
+        setState(kDisconnecting);
+        loop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop() {
+    if (state_ == kConnected || state_ == kDisconnecting || state_ == kConnecting) {
+        handleClose(); // 与对端关闭连接的处理相同
+    }
+}
+
 void TcpConnection::shutdownInLoop() {
-    if (!channel_->isWriting()) { // 还没有注册channel的可写事件, 说明outputBuffer_中没有待发送数据
-        socket_->shutdownWrite(); // 关闭写端, 触发对端的EPOLLHUP事件
+    flushOutput(); // 合并发送或直接写入输出缓冲区的数据还未发送
+    if (!channel_.isWriting()) { // 还没有注册channel的可写事件, 说明没有待发送数据
+#ifdef MUDUO_WITH_TLS
+        if (tls_) {
+            tls_->shutdown(); // 先发送close_notify
+        }
+#endif
+        socket_.shutdownWrite(); // 关闭写端, 触发对端的EPOLLHUP事件
+    }
+}
+
+void TcpConnection::offload(OffloadWork work, OffloadDoneCallback done) {
+    if (loop_->isInLoopThread()) {
+        offloadInLoop(work, done);
+    } else {
+        loop_->queueInLoop(std::bind(&TcpConnection::offloadInLoop, shared_from_this(), work, done));
+    }
+}
+
+void TcpConnection::offloadInLoop(const OffloadWork &work, const OffloadDoneCallback &done) {
+    if (!computePool_) {
+        work();
+        if (done) done(shared_from_this());
+        return;
+    }
+    offloadQueue_.emplace_back(work, done);
+    if (offloadQueue_.size() == 1) {
+        submitNextOffload(); // 没有正在执行的任务
+    }
+}
+
+void TcpConnection::submitNextOffload() {
+    // 任务在loop中取出再提交, 计算线程不会访问offloadQueue_
+    OffloadWork work = std::move(offloadQueue_.front().first);
+    TcpConnectionPtr guardThis(shared_from_this());
+    computePool_->submit([guardThis, work]() mutable {
+        work();
+        // 把连接的引用转交给loop, 避免计算线程持有最后一个引用
+        EventLoop *loop = guardThis->loop_;
+        loop->runInLoop(std::bind(&TcpConnection::offloadDone, std::move(guardThis)));
+    });
+}
+
+void TcpConnection::offloadDone() {
+    OffloadDoneCallback done = std::move(offloadQueue_.front().second);
+    offloadQueue_.pop_front();
+    if (done) done(shared_from_this());
+    if (!offloadQueue_.empty()) {
+        submitNextOffload();
+    }
+}
+
+void TcpConnection::startRead() {
+    loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopRead() {
+    loop_->runInLoop(std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop() {
+    reading_ = true;
+    updateReadingInLoop();
+}
+
+void TcpConnection::stopReadInLoop() {
+    reading_ = false;
+    updateReadingInLoop();
+}
+
+void TcpConnection::pauseReadInLoop() {
+    ++readPauseCount_;
+    updateReadingInLoop();
+}
+
+void TcpConnection::resumeReadInLoop() {
+    if (readPauseCount_ > 0) {
+        --readPauseCount_;
+    }
+    updateReadingInLoop();
+}
+
+void TcpConnection::updateReadingInLoop() {
+    if (state_ != kConnected && state_ != kDisconnecting) {
+        return; // 连接还未建立或已关闭, connectEstablished时再按状态注册读事件
+    }
+    bool wantRead = reading_ && readPauseCount_ == 0;
+    if (wantRead && !channel_.isReading()) {
+        channel_.enableReading();
+        if (deferredReadPending_) {
+            deferredReadPending_ = false;
+            scheduleDeferredRead(LatencyHistogram::now()); // 暂停前让出本轮时留下的数据
+        }
+    } else if (!wantRead && channel_.isReading()) {
+        channel_.disableReading();
+    }
+}
+
+void TcpConnection::applyBackpressure() {
+    TcpConnectionPtr target = backpressurePeer_.lock();
+    if (!target) {
+        target = shared_from_this();
+    }
+    backpressureApplied_ = true;
+    pausedTarget_ = target;
+    LOG_INFO("TcpConnection::applyBackpressure [%s] pause reading [%s] output=%zu\n",
+             name_.c_str(), target->name().c_str(), outputBytes());
+    // 目标连接可能属于其他loop
+    target->loop_->runInLoop(std::bind(&TcpConnection::pauseReadInLoop, target));
+}
+
+void TcpConnection::releaseBackpressure() {
+    backpressureApplied_ = false;
+    TcpConnectionPtr target = pausedTarget_.lock();
+    pausedTarget_.reset();
+    if (target) {
+        target->loop_->runInLoop(std::bind(&TcpConnection::resumeReadInLoop, target));
     }
 }
 
 // 连接建立
 void TcpConnection::connectEstablished() {
+    channel_.tie(shared_from_this());
+    countedInLoop_ = true;
+    loop_->metrics().connections.add(1);
+    updateBufferMetrics();
+#ifdef MUDUO_WITH_TLS
+    if (tls_) {
+        channel_.enableReading(); // 握手期间总是需要读, 握手完成后再按reading_设置
+        handshakeTls();
+        return;
+    }
+#endif
     setState(kConnected);
-    channel_->tie(shared_from_this());
-    channel_->enableReading(); // 注册channel的可读事件
-    connectionCallback_(shared_from_this()); // 执行用户注册的连接建立回调
+    if (reading_ && readPauseCount_ == 0) {
+        channel_.enableReading(); // 注册channel的可读事件
+    }
+    if (connectionCallback_) connectionCallback_(shared_from_this()); // 执行用户注册的连接建立回调
 }
 
 // 连接销毁
 void TcpConnection::connectDestroyed() {
     if (state_ == kConnected) {
         setState(kDisconnected);
-        channel_->disableAll(); // 禁用channel的所有事件
-        connectionCallback_(shared_from_this()); // 执行用户注册的连接断开回调
+        channel_.disableAll(); // 禁用channel的所有事件
+        if (backpressureApplied_) {
+            releaseBackpressure();
+        }
+        if (connectionCallback_) connectionCallback_(shared_from_this()); // 执行用户注册的连接断开回调
+    }
+    channel_.remove(); // 从Poller中删除channel
+    if (countedInLoop_) {
+        countedInLoop_ = false;
+        loop_->metrics().connections.sub(1);
+        loop_->metrics().bufferBytes.sub(bufferBytes_);
+        bufferBytes_ = 0;
+    }
+}
+
+void TcpConnection::updateBufferMetrics() {
+    size_t bytes = inputBuffer_.internalCapacity() + outputBuffer_.internalCapacity();
+    if (bytes != bufferBytes_ && countedInLoop_) {
+        // 无符号数按模运算, 容量减小时同样正确
+        loop_->metrics().bufferBytes.add(bytes - bufferBytes_);
+        bufferBytes_ = bytes;
+    }
+}
+
+#ifdef MUDUO_WITH_TLS
+void TcpConnection::startTls(TlsContext *context, const std::string &serverName) {
+    tls_.reset(new TlsStream(context, channel_.fd(), serverName));
+    // 握手由多个小消息往返完成, Nagle算法与延迟确认叠加会让每次握手多等一个ACK超时
+    socket_.setTcpNoDelay(true);
+}
+
+void TcpConnection::handshakeTls() {
+    TlsStream::HandshakeState hs = tls_->handshake();
+    if (hs == TlsStream::kHandshakeWantWrite) {
+        if (!channel_.isWriting()) {
+            channel_.enableWriting();
+        }
+        return;
+    }
+    if (channel_.isWriting()) {
+        channel_.disableWriting(); // 握手期间输出缓冲区为空, 可写事件只用于握手
+    }
+    if (hs == TlsStream::kHandshakeWantRead) {
+        return;
+    } else if (hs == TlsStream::kHandshakeFailed) {
+        LOG_ERROR("TcpConnection::handshakeTls [%s] fail\n", name_.c_str());
+        handleClose();
+        return;
+    }
+
+    LOG_INFO("TcpConnection::handshakeTls [%s] %s %s ktls_send=%d ktls_recv=%d\n", name_.c_str(),
+             tls_->version(), tls_->cipher(), tls_->ktlsSend(), tls_->ktlsRecv());
+    setState(kConnected);
+    updateReadingInLoop();
+    if (connectionCallback_) connectionCallback_(shared_from_this());
+}
+#endif
+
+ssize_t TcpConnection::readSocket(int *savedErrno) {
+#ifdef MUDUO_WITH_TLS
+    ssize_t n = tls_ ? tls_->read(&inputBuffer_, savedErrno, readBudget_)
+                     : inputBuffer_.readFd(channel_.fd(), savedErrno, readBudget_);
+#else
+    ssize_t n = inputBuffer_.readFd(channel_.fd(), savedErrno, readBudget_);
+#endif
+    if (n > 0) {
+        loop_->metrics().bytesRead.add(n);
+    }
+    return n;
+}
+
+ssize_t TcpConnection::writeSocket(const void *data, size_t len, int *savedErrno) {
+    ssize_t n;
+#ifdef MUDUO_WITH_TLS
+    // 开启kTLS后由内核加密, 与明文连接走同一条write路径
+    if (tls_ && !tls_->ktlsSend()) {
+        n = tls_->write(data, len, savedErrno);
+    } else {
+        n = ::write(channel_.fd(), data, len);
+        if (n < 0) *savedErrno = errno;
     }
-    channel_->remove(); // 从Poller中删除channel
+#else
+    n = ::write(channel_.fd(), data, len);
+    if (n < 0) *savedErrno = errno;
+#endif
+    loop_->metrics().writeCalls.add(1);
+    if (n > 0) {
+        loop_->metrics().bytesWritten.add(n);
+    }
+    return n;
+}
+
+ssize_t TcpConnection::writevSocket(const struct iovec *iov, int iovcnt, int *savedErrno) {
+    ssize_t n = ::writev(channel_.fd(), iov, iovcnt);
+    if (n < 0) *savedErrno = errno;
+    loop_->metrics().writeCalls.add(1);
+    if (n > 0) {
+        loop_->metrics().bytesWritten.add(n);
+    }
+    return n;
+}
+
+ssize_t TcpConnection::writeOutput(int *savedErrno) {
+    if (sharedOutput_.empty()) {
+        ssize_t n = writeSocket(outputBuffer_.peek(), outputBuffer_.readableBytes(), savedErrno);
+        if (n > 0) {
+            outputBuffer_.retrieve(n);
+        }
+        return n;
+    }
+    // 共享负载在前, 输出缓冲区中的数据都比它们新, 放在最后一起writev
+    static const int kMaxIov = 64;
+    iovec iov[kMaxIov];
+    int count = 0;
+    for (auto it = sharedOutput_.begin(); it != sharedOutput_.end() && count < kMaxIov - 1; ++it) {
+        iov[count].iov_base = const_cast<char *>(it->first->data() + it->second);
+        iov[count].iov_len = it->first->size() - it->second;
+        ++count;
+    }
+    if (count == static_cast<int>(sharedOutput_.size()) && outputBuffer_.readableBytes() > 0) {
+        iov[count].iov_base = const_cast<char *>(outputBuffer_.peek());
+        iov[count].iov_len = outputBuffer_.readableBytes();
+        ++count;
+    }
+    ssize_t n = writevSocket(iov, count, savedErrno);
+    size_t written = n > 0 ? static_cast<size_t>(n) : 0;
+    while (written > 0 && !sharedOutput_.empty()) {
+        auto &front = sharedOutput_.front();
+        size_t left = front.first->size() - front.second;
+        if (written < left) {
+            front.second += written;
+            sharedBytes_ -= written;
+            return n;
+        }
+        written -= left;
+        sharedBytes_ -= left;
+        sharedOutput_.pop_front(); // 释放对共享负载的引用
+    }
+    outputBuffer_.retrieve(written);
+    return n;
 }
 
 // 可读事件的回调
 void TcpConnection::handleRead(Timestamp receiveTime) {
+#ifdef MUDUO_WITH_TLS
+    if (tls_ && !tls_->established()) {
+        handshakeTls();
+        return;
+    }
+#endif
+    if (inputDeferred_) {
+        deliverInput(receiveTime, loop_->pollReturnNanos()); // 先处理推迟的数据, 新数据留在内核中
+        return;
+    }
+    readAndDeliver(receiveTime, loop_->pollReturnNanos());
+}
+
+void TcpConnection::readAndDeliver(Timestamp receiveTime, int64_t readyAt) {
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    ssize_t n = readSocket(&savedErrno);
     if (n > 0) {
-        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime); // 执行用户注册的读写消息回调
+        if (readBudget_ > 0 && static_cast<size_t>(n) >= readBudget_) {
+            // 配额用完, 让出本轮; 明文连接未读的数据留在内核中, 下一轮仍会返回可读事件
+            loop_->metrics().readsDeferred.add(1);
+#ifdef MUDUO_WITH_TLS
+            if (tls_ && tls_->hasPending()) {
+                scheduleDeferredRead(LatencyHistogram::now()); // 已解密的数据不会再触发可读事件
+            }
+#endif
+        }
+        deliverInput(receiveTime, readyAt);
+#ifdef MUDUO_WITH_TLS
+        if (tls_ && tls_->peerClosed() && state_ != kDisconnected) {
+            drainDeferredInput();
+            handleClose(); // 数据之后是close_notify
+        }
+#endif
     } else if (n == 0) {
+        drainDeferredInput();
         handleClose(); // 对端关闭连接
+    } else if (savedErrno == EWOULDBLOCK) {
+        // TLS连接只收到了非应用数据的记录(如会话票据)
     } else {
         errno = savedErrno;
         LOG_ERROR("TcpConnection::handleRead");
@@ -149,15 +737,95 @@ void TcpConnection::handleRead(Timestamp receiveTime) {
     }
 }
 
+void TcpConnection::deliverInput(Timestamp receiveTime, int64_t readyAt) {
+    deliveredIteration_ = loop_->iteration();
+    inputDeferred_ = false;
+    if (messageCallback_) {
+        size_t inputBytes = inputBuffer_.readableBytes();
+        int64_t start = LatencyHistogram::now();
+        loop_->metrics().readDelay.record(start - readyAt);
+        messageCallback_(shared_from_this(), &inputBuffer_, receiveTime); // 执行用户注册的读写消息回调
+        int64_t elapsed = LatencyHistogram::now() - start;
+        loop_->metrics().messageCallback.record(elapsed);
+        if (loop_->isSlowCallback(elapsed)) {
+            LOG_ERROR("TcpConnection::handleRead [%s] peer=%s slow MessageCallback took %.3fms input=%zu\n",
+                      name_.c_str(), peeraddr_.toIpPort().c_str(), elapsed / 1e6, inputBytes);
+        }
+    } else {
+        inputBuffer_.retrieveAll(); // 没有设置消息回调, 丢弃数据
+    }
+    updateBufferMetrics();
+}
+
+void TcpConnection::deferMessages() {
+    inputDeferred_ = true;
+    loop_->metrics().readsDeferred.add(1);
+    scheduleDeferredRead(LatencyHistogram::now());
+}
+
+void TcpConnection::drainDeferredInput() {
+    // 连接即将关闭, 不再等下一轮; 回调不再取走数据时停止
+    while (inputDeferred_ && inputBuffer_.readableBytes() > 0) {
+        size_t before = inputBuffer_.readableBytes();
+        deliverInput(loop_->pollReturnTime(), LatencyHistogram::now());
+        if (inputBuffer_.readableBytes() >= before) {
+            break;
+        }
+    }
+}
+
+void TcpConnection::scheduleDeferredRead(int64_t deferredAt) {
+    if (deferredReadScheduled_) {
+        return;
+    }
+    deferredReadScheduled_ = true;
+    TcpConnectionPtr guardThis(shared_from_this());
+    loop_->runNextIteration([guardThis, deferredAt]() { guardThis->continueDeferredRead(deferredAt); });
+}
+
+void TcpConnection::continueDeferredRead(int64_t deferredAt) {
+    deferredReadScheduled_ = false;
+    if (state_ != kConnected && state_ != kDisconnecting) {
+        return;
+    }
+    if (!channel_.isReading()) {
+        deferredReadPending_ = true; // 读取已暂停(背压或stopRead), 恢复读取时再继续
+        return;
+    }
+    if (deliveredIteration_ == loop_->iteration()) {
+        scheduleDeferredRead(deferredAt); // 本轮已经随可读事件处理过, 再让一轮
+        return;
+    }
+    if (inputDeferred_) {
+        deliverInput(loop_->pollReturnTime(), deferredAt); // 先处理推迟的数据
+    }
+#ifdef MUDUO_WITH_TLS
+    else if (tls_ && tls_->hasPending()) {
+        readAndDeliver(loop_->pollReturnTime(), deferredAt);
+    }
+    if (tls_ && tls_->hasPending() && state_ != kDisconnected) {
+        scheduleDeferredRead(LatencyHistogram::now()); // 已解密的数据不会再触发可读事件
+    }
+#endif
+}
+
 // 可写事件的回调
 void TcpConnection::handleWrite() {
-    if (channel_->isWriting()) {
+#ifdef MUDUO_WITH_TLS
+    if (tls_ && !tls_->established()) {
+        handshakeTls();
+        return;
+    }
+#endif
+    if (channel_.isWriting()) {
         int savedErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+        ssize_t n = writeOutput(&savedErrno); // 同时从缓冲区中移除已发送的数据
         if (n > 0) {
-            outputBuffer_.retrieve(n); // 从缓冲区中移除已发送的数据
-            if (outputBuffer_.readableBytes() == 0) {
-                channel_->disableWriting(); // 发送完所有数据, 注销channel的可写事件
+            if (backpressureApplied_ && outputBytes() <= backpressureLowMark_) {
+                releaseBackpressure(); // 积压缓解, 恢复读取
+            }
+            if (outputBytes() == 0) {
+                channel_.disableWriting(); // 发送完所有数据, 注销channel的可写事件
                 if (writeCompleteCallback_) {
                     loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
                 }
@@ -165,23 +833,27 @@ void TcpConnection::handleWrite() {
                     shutdownInLoop(); // 连接正在断开, 关闭写端
                 }
             }
-        } else {
+        } else if (savedErrno != EWOULDBLOCK) { // TLS连接的SSL_write可能暂时写不出完整记录
             LOG_ERROR("TcpConnection::handleWrite");
         }
     } else {
-        LOG_ERROR("TcpConnection fd=%d is down, no more writing\n", channel_->fd());
+        LOG_ERROR("TcpConnection fd=%d is down, no more writing\n", channel_.fd());
     }
 }
 
 // 关闭事件的回调
 void TcpConnection::handleClose() {
-    LOG_INFO("TcpConnection::handleClose fd=%d state=%d\n", channel_->fd(), (int)state_);
+    LOG_INFO("TcpConnection::handleClose fd=%d state=%d\n", channel_.fd(), (int)state_);
+    bool announced = state_ != kConnecting; // TLS握手没有完成的连接没有调用过连接建立回调
     setState(kDisconnected);
-    channel_->disableAll(); // 禁用channel的所有事件
+    channel_.disableAll(); // 禁用channel的所有事件
+    if (backpressureApplied_) {
+        releaseBackpressure(); // 连接关闭, 不再阻塞数据来源
+    }
 
     TcpConnectionPtr guardThis(shared_from_this());
-    connectionCallback_(guardThis); // 执行用户注册的连接断开回调
-    closeCallback_(guardThis); // 执行用户注册的连接关闭回调
+    if (connectionCallback_ && announced) connectionCallback_(guardThis); // 执行用户注册的连接断开回调
+    if (closeCallback_) closeCallback_(guardThis); // 执行用户注册的连接关闭回调
 }
 
 // 错误事件的回调
@@ -189,7 +861,7 @@ void TcpConnection::handleError() {
     int optval;
     socklen_t optlen = sizeof optval;
     int err = 0;
-    if (::getsockopt(channel_->fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
+    if (::getsockopt(channel_.fd(), SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0) {
         err = errno;
     } else {
         err = optval;
@@ -1,10 +1,10 @@
 #include <functional>
 #include <string.h>
-#include <assert.h>
 
 #include "TcpServer.h"
 #include "Logger.h"
 #include "TcpConnection.h"
+#include "Socket.h"
 
 static EventLoop *CheckLoopNotNull(EventLoop *loop) {
     if (loop == nullptr) {
@@ -19,10 +19,18 @@ TcpServer::TcpServer(EventLoop *loop, const InetAddress &listenaddr, const std::
     , name_(nameArg)
     , acceptor_(new Acceptor(loop, listenaddr, option == kReusePort))
     , threadPool_(new EventLoopThreadPool(loop, name_))
+    , computeThreadNum_(0)
     , connectionCallback_() // TcpServer默认没有设置回调
     , messageCallback_()
-    , nextConnId_(1)
     , started_(0)
+    , nextConnId_(1)
+    , slowCallbackThreshold_(0)
+    , autoCork_(false)
+    , readBudget_(0)
+    , steeringPolicy_(kRoundRobin)
+    , steerHits_(0)
+    , steerMisses_(0)
+    , steerUnavailable_(0)
 {
     // 当有新连接时，Acceptor会执行该回调
     acceptor_->setNewConnectionCallback(
@@ -31,13 +39,24 @@ TcpServer::TcpServer(EventLoop *loop, const InetAddress &listenaddr, const std::
 }
 
 TcpServer::~TcpServer() {
-    for (auto &item : connections_) {
-        TcpConnectionPtr conn(item.second);
-        item.second.reset();
-        conn->getLoop()->runInLoop(
-            std::bind(&TcpConnection::connectDestroyed, conn)
-        );
+    for (auto &shard : shards_) {
+        ConnectionMap connections;
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            connections.swap(shard->connections);
+        }
+        for (auto &item : connections) {
+            TcpConnectionPtr conn(item.second);
+            item.second.reset();
+            // 连接不再回调已析构的TcpServer
+            conn->getLoop()->runInLoop([conn]() {
+                conn->setCloseCallback(CloseCallback());
+                conn->connectDestroyed();
+            });
+        }
     }
+    // subloop仍可能在访问分片, 先停止所有subloop再析构分片
+    threadPool_.reset();
 }
 
 // 设置底层subloop的个数
@@ -45,10 +64,41 @@ void TcpServer::setThreadNum(int numThreads) {
     threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setSteeringPolicy(SteeringPolicy policy) {
+    steeringPolicy_ = policy;
+    // 按CPU分发要求subloop绑定到CPU上
+    threadPool_->setCpuAffinity(policy == kIncomingCpu);
+}
+
+TcpServer::SteeringStats TcpServer::steeringStats() const {
+    SteeringStats stats;
+    stats.hits = steerHits_.load(std::memory_order_relaxed);
+    stats.misses = steerMisses_.load(std::memory_order_relaxed);
+    stats.unavailable = steerUnavailable_.load(std::memory_order_relaxed);
+    return stats;
+}
+
 // 启动服务器监听
 void TcpServer::start() {
     if (started_.fetch_add(1) == 0) {
         threadPool_->start(threadInitCallback_); // 启动底层的subloops
+        std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+        for (size_t i = 0; i < loops.size(); ++i) {
+            shards_.emplace_back(new ConnectionShard);
+            shards_.back()->pool = std::make_shared<BlockPool>();
+            loopShards_[loops[i]] = i;
+        }
+        if (slowCallbackThreshold_ > 0) {
+            // 未设置时不覆盖用户直接在loop上设置的阈值
+            loop_->setSlowCallbackThreshold(slowCallbackThreshold_);
+            for (EventLoop *loop : loops) {
+                loop->setSlowCallbackThreshold(slowCallbackThreshold_);
+            }
+        }
+        if (computeThreadNum_ > 0) {
+            computePool_.reset(new WorkStealingThreadPool(name_ + "-compute"));
+            computePool_->start(computeThreadNum_);
+        }
         loop_->runInLoop(
             std::bind(&Acceptor::listen, acceptor_.get()) // 让mainLoop监听listenfd的可读事件
         );
@@ -57,55 +107,182 @@ void TcpServer::start() {
 
 // 新用户连接时的回调
 void TcpServer::newConnection(int sockfd, const InetAddress &peerAddr) {
-    // 轮询算法选择一个subLoop管理connfd对应的channel
-    EventLoop *ioLoop = threadPool_ -> getNextLoop();
+    // 按分发策略选择一个subLoop管理connfd对应的channel
+    EventLoop *ioLoop = selectLoop(sockfd);
+    size_t shard = loopShards_[ioLoop];
+    uint64_t connId = (static_cast<uint64_t>(shard) << kSeqBits) | nextConnId_;
     char buf[64] = {0};
-    snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);
-    ++nextConnId_;
+    snprintf(buf, sizeof buf, "-%s#%lu", ipPort_.c_str(), static_cast<unsigned long>(nextConnId_));
+    nextConnId_ = (nextConnId_ + 1) & ((1ULL << kSeqBits) - 1);
     std::string connName = name_ + buf;
     LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s\n",
              name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
     
     // 获取该连接的本地地址
-    sockaddr_in local;
+    sockaddr_storage local;
     ::memset(&local, 0, sizeof(local));
     socklen_t addrlen = sizeof(local);
     if(::getsockname(sockfd, (sockaddr *)&local, &addrlen) < 0) {
         LOG_ERROR("sockets::getLocalAddr");
     }
 
-    InetAddress localAddr(local);
-    // 创建一个TcpConnection对象
-    TcpConnectionPtr conn(new TcpConnection(ioLoop, connName, sockfd, localAddr, peerAddr));
-    connections_[connName] = conn; // 保存连接
+    InetAddress localAddr((sockaddr *)&local, addrlen);
+    // 创建一个TcpConnection对象, 对象与shared_ptr控制块从该loop的内存池中一次分配
+    TcpConnectionPtr conn = std::allocate_shared<TcpConnection>(
+        PoolAllocator<TcpConnection>(shards_[shard]->pool),
+        ioLoop, connName, connId, sockfd, localAddr, peerAddr);
 
     // 下面的回调都是用户设置给TcpServer => TcpConnection
     conn->setConnectionCallback(connectionCallback_); // 设置连接建立和断开的回调
     conn->setMessageCallback(messageCallback_); // 设置读写消息的回调
     conn->setWriteCompleteCallback(writeCompleteCallback_); // 设置消息发送完成后的回调
+    conn->setComputePool(computePool_); // 设置计算线程池
+    conn->setAutoCork(autoCork_);
+    conn->setReadBudget(readBudget_);
+#ifdef MUDUO_WITH_TLS
+    if (tlsContext_) {
+        conn->startTls(tlsContext_.get());
+    }
+#endif
 
     conn->setCloseCallback( // 设置连接关闭的回调
-        std::bind(&TcpServer::removeConnection, this, std::placeholders::_1)
+        [this](const TcpConnectionPtr &c) { removeConnection(c); }
     );
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn)); // 让subLoop执行该新连接的回调
+    // 让subLoop登记该连接并执行新连接的回调
+    ioLoop->runInLoop(std::bind(&TcpServer::addConnectionInLoop, this, shard, conn));
 }
 
-void TcpServer::removeConnection(const TcpConnectionPtr &conn) {
-    // 该函数可能在mainLoop也可能在subLoop中调用
-    loop_->runInLoop(
-        std::bind(&TcpServer::removeConnectionInLoop, this, conn)
-    );
+void TcpServer::addConnectionInLoop(size_t shard, const TcpConnectionPtr &conn) {
+    {
+        std::lock_guard<std::mutex> lock(shards_[shard]->mutex);
+        shards_[shard]->connections[conn->id()] = conn; // 保存连接
+    }
+    conn->connectEstablished();
 }
 
-void TcpServer::removeConnectionInLoop(const TcpConnectionPtr &conn) {
-    LOG_INFO("TcpServer::removeConnectionInLoop [%s] - connection %s\n",
+// 连接关闭时在其所属的subLoop中调用, 只访问该loop的分片
+void TcpServer::removeConnection(const TcpConnectionPtr &conn) {
+    LOG_INFO("TcpServer::removeConnection [%s] - connection %s\n",
              name_.c_str(), conn->name().c_str());
-    size_t n = connections_.erase(conn->name());
-    (void)n;
-    assert(n == 1); // 确保连接存在
+    ConnectionShard &shard = *shards_[conn->id() >> kSeqBits];
+    size_t n = 0;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        n = shard.connections.erase(conn->id());
+    }
+    if (n == 0) {
+        return; // TcpServer析构时已经移除
+    }
 
-    EventLoop *ioLoop = conn->getLoop();
-    ioLoop->queueInLoop( // 在subLoop中销毁连接
+    conn->getLoop()->queueInLoop( // 当前正在处理该连接channel的事件, 稍后再销毁连接
         std::bind(&TcpConnection::connectDestroyed, conn)
     );
-}
\ No newline at end of file
+}
+
+void TcpServer::stopAccepting() {
+    loop_->runInLoop(std::bind(&Acceptor::stopListening, acceptor_.get()));
+}
+
+void TcpServer::forceCloseAll() {
+    std::vector<TcpConnectionPtr> connections;
+    for (const auto &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto &item : shard->connections) {
+            connections.push_back(item.second);
+        }
+    }
+    for (const TcpConnectionPtr &conn : connections) {
+        conn->forceClose();
+    }
+}
+
+size_t TcpServer::broadcast(const SharedPayload &payload, const BroadcastFilter &filter) {
+    if (payload->empty()) {
+        return 0;
+    }
+    std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        loops[i]->runInLoop(std::bind(&TcpServer::broadcastInLoop, this, i, payload, filter));
+    }
+    return shards_.size();
+}
+
+// 在分片所属的loop中调用, 整个分片只执行一个任务
+void TcpServer::broadcastInLoop(size_t shard, const SharedPayload &payload, const BroadcastFilter &filter) {
+    std::vector<TcpConnectionPtr> connections;
+    {
+        // 只在锁内复制连接, 发送时不阻塞其他线程的查找
+        std::lock_guard<std::mutex> lock(shards_[shard]->mutex);
+        connections.reserve(shards_[shard]->connections.size());
+        for (const auto &item : shards_[shard]->connections) {
+            connections.push_back(item.second);
+        }
+    }
+    for (const TcpConnectionPtr &conn : connections) {
+        if (!filter || filter(conn)) {
+            conn->sendShared(payload);
+        }
+    }
+}
+
+TcpConnectionPtr TcpServer::getConnection(uint64_t id) const {
+    size_t shard = id >> kSeqBits;
+    if (shard >= shards_.size()) {
+        return TcpConnectionPtr();
+    }
+    std::lock_guard<std::mutex> lock(shards_[shard]->mutex);
+    auto it = shards_[shard]->connections.find(id);
+    return it != shards_[shard]->connections.end() ? it->second : TcpConnectionPtr();
+}
+
+size_t TcpServer::connectionCount() const {
+    size_t count = 0;
+    for (const auto &shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->connections.size();
+    }
+    return count;
+}
+
+BlockPool::Stats TcpServer::connectionPoolStats() const {
+    BlockPool::Stats total = {0, 0, 0};
+    for (const auto &shard : shards_) {
+        BlockPool::Stats stats = shard->pool->stats();
+        total.reused += stats.reused;
+        total.allocated += stats.allocated;
+        total.freeBlocks += stats.freeBlocks;
+    }
+    return total;
+}
+
+EventLoop* TcpServer::selectLoop(int sockfd) {
+    if (steeringPolicy_ == kIncomingCpu) {
+        int cpu = Socket::incomingCpu(sockfd);
+        if (cpu < 0) {
+            ++steerUnavailable_;
+        } else if (EventLoop *loop = threadPool_->getLoopForCpu(cpu)) {
+            ++steerHits_;
+            return loop;
+        } else {
+            ++steerMisses_;
+        }
+    } else if (steeringPolicy_ == kIncomingNapiId) {
+        int napiId = Socket::incomingNapiId(sockfd);
+        if (napiId < 0) {
+            ++steerUnavailable_;
+        } else {
+            auto it = napiLoops_.find(napiId);
+            if (it != napiLoops_.end()) {
+                ++steerHits_;
+                return it->second;
+            }
+            // 第一次见到该收包队列, 按轮询选出subloop并记住
+            ++steerMisses_;
+            EventLoop *loop = threadPool_->getNextLoop();
+            napiLoops_[napiId] = loop;
+            return loop;
+        }
+    }
+    // 没有匹配的subloop, 退回轮询
+    return threadPool_->getNextLoop();
+}
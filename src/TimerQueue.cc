@@ -0,0 +1,130 @@
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <vector>
+
+#include "TimerQueue.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+static int createTimerfd() {
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0) {
+        LOG_FATAL("timerfd_create error:%d\n", errno);
+    }
+    return timerfd;
+}
+
+int64_t TimerQueue::now() {
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+TimerQueue::TimerQueue(EventLoop *loop)
+    : loop_(loop),
+      timerfd_(createTimerfd()),
+      timerfdChannel_(loop, timerfd_),
+      nextId_(1) {
+    timerfdChannel_.setReadCallback([this](Timestamp) { handleRead(); });
+    timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue() {
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb, int64_t when, int64_t interval) {
+    TimerId timerId = nextId_.fetch_add(1, std::memory_order_relaxed);
+    if (loop_->isInLoopThread()) {
+        Timer timer{std::move(cb), when, interval};
+        addTimerInLoop(timerId, timer);
+    } else {
+        loop_->queueInLoop([this, timerId, cb = std::move(cb), when, interval]() mutable {
+            Timer timer{std::move(cb), when, interval};
+            addTimerInLoop(timerId, timer);
+        });
+    }
+    return timerId;
+}
+
+void TimerQueue::cancel(TimerId timerId) {
+    loop_->runInLoop([this, timerId]() { cancelInLoop(timerId); });
+}
+
+void TimerQueue::addTimerInLoop(TimerId timerId, Timer &timer) {
+    bool earliest = timers_.empty() || timer.when < timers_.begin()->first;
+    timers_.insert(Entry(timer.when, timerId));
+    active_.emplace(timerId, std::move(timer));
+    if (earliest) {
+        resetTimerfd();
+    }
+}
+
+void TimerQueue::cancelInLoop(TimerId timerId) {
+    auto it = active_.find(timerId);
+    if (it == active_.end()) {
+        return; // 已经执行完毕或已取消
+    }
+    timers_.erase(Entry(it->second.when, timerId));
+    active_.erase(it);
+}
+
+void TimerQueue::handleRead() {
+    uint64_t howmany = 0;
+    ssize_t n = ::read(timerfd_, &howmany, sizeof howmany);
+    if (n != sizeof howmany) {
+        LOG_ERROR("TimerQueue::handleRead() reads %ld bytes instead of 8\n", static_cast<long>(n));
+    }
+
+    // 先取出所有到期的定时器, 回调中新增的定时器留到下一轮
+    int64_t current = now();
+    std::vector<TimerId> expired;
+    while (!timers_.empty() && timers_.begin()->first <= current) {
+        expired.push_back(timers_.begin()->second);
+        timers_.erase(timers_.begin());
+    }
+
+    for (TimerId timerId : expired) {
+        auto it = active_.find(timerId);
+        if (it == active_.end()) {
+            continue; // 被前面的回调取消
+        }
+        // 回调可能取消自己, 先把回调移出再执行
+        TimerCallback cb = std::move(it->second.callback);
+        cb();
+        it = active_.find(timerId);
+        if (it == active_.end()) {
+            continue;
+        }
+        if (it->second.interval > 0) {
+            it->second.callback = std::move(cb);
+            it->second.when = current + it->second.interval;
+            timers_.insert(Entry(it->second.when, timerId));
+        } else {
+            active_.erase(it);
+        }
+    }
+    resetTimerfd();
+}
+
+void TimerQueue::resetTimerfd() {
+    itimerspec value;
+    ::memset(&value, 0, sizeof value);
+    if (!timers_.empty()) {
+        // 至少100微秒, 避免设置为0时停止timerfd
+        int64_t delay = timers_.begin()->first - now();
+        if (delay < 100) {
+            delay = 100;
+        }
+        value.it_value.tv_sec = static_cast<time_t>(delay / 1000000);
+        value.it_value.tv_nsec = static_cast<long>(delay % 1000000) * 1000;
+    }
+    if (::timerfd_settime(timerfd_, 0, &value, nullptr) < 0) {
+        LOG_ERROR("timerfd_settime error:%d\n", errno);
+    }
+}
@@ -0,0 +1,135 @@
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <errno.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+
+#include "TlsContext.h"
+#include "Logger.h"
+
+// 取出OpenSSL错误队列中最早的一条错误
+static const char* lastSslError() {
+    static __thread char buf[256];
+    unsigned long err = ERR_get_error();
+    ERR_clear_error();
+    if (err == 0) {
+        return "unknown";
+    }
+    ERR_error_string_n(err, buf, sizeof buf);
+    return buf;
+}
+
+TlsContext::TlsContext(Mode mode)
+    : mode_(mode),
+      ctx_(::SSL_CTX_new(mode == kServer ? TLS_server_method() : TLS_client_method())),
+      verifyPeer_(false),
+      ktls_(false) {
+    if (ctx_ == nullptr) {
+        LOG_FATAL("%s:%s:%d SSL_CTX_new err:%s\n", __FILE__, __FUNCTION__, __LINE__, lastSslError());
+    }
+    SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+    // 部分写: SSL_write每发出一个记录就可以返回; 重试时允许缓冲区地址变化(Buffer扩容或前移)
+    SSL_CTX_set_mode(ctx_, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER
+                           | SSL_MODE_RELEASE_BUFFERS);
+    // 没有close_notify的TCP关闭按正常关闭处理, 与明文连接的语义一致; OpenSSL 1.1.1没有该选项, 由TlsStream::read处理
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+    SSL_CTX_set_options(ctx_, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+    setKtls(true);
+}
+
+TlsContext::~TlsContext() {
+    ::SSL_CTX_free(ctx_);
+}
+
+bool TlsContext::useCertificateFile(const std::string &certFile, const std::string &keyFile) {
+    if (SSL_CTX_use_certificate_chain_file(ctx_, certFile.c_str()) != 1
+        || SSL_CTX_use_PrivateKey_file(ctx_, keyFile.c_str(), SSL_FILETYPE_PEM) != 1
+        || SSL_CTX_check_private_key(ctx_) != 1) {
+        LOG_ERROR("TlsContext::useCertificateFile cert:%s key:%s err:%s\n",
+                  certFile.c_str(), keyFile.c_str(), lastSslError());
+        return false;
+    }
+    return true;
+}
+
+bool TlsContext::useCertificate(const std::string &certPem, const std::string &keyPem) {
+    bool ok = false;
+    BIO *certBio = BIO_new_mem_buf(certPem.data(), static_cast<int>(certPem.size()));
+    BIO *keyBio = BIO_new_mem_buf(keyPem.data(), static_cast<int>(keyPem.size()));
+    X509 *cert = PEM_read_bio_X509(certBio, nullptr, nullptr, nullptr);
+    EVP_PKEY *key = PEM_read_bio_PrivateKey(keyBio, nullptr, nullptr, nullptr);
+    if (cert != nullptr && key != nullptr
+        && SSL_CTX_use_certificate(ctx_, cert) == 1
+        && SSL_CTX_use_PrivateKey(ctx_, key) == 1
+        && SSL_CTX_check_private_key(ctx_) == 1) {
+        ok = true;
+        // PEM中证书之后的部分是中间证书链
+        X509 *extra;
+        while ((extra = PEM_read_bio_X509(certBio, nullptr, nullptr, nullptr)) != nullptr) {
+            SSL_CTX_add0_chain_cert(ctx_, extra);
+        }
+        ERR_clear_error(); // 读到末尾产生的错误
+    } else {
+        LOG_ERROR("TlsContext::useCertificate err:%s\n", lastSslError());
+    }
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    BIO_free(certBio);
+    BIO_free(keyBio);
+    return ok;
+}
+
+bool TlsContext::loadVerifyLocations(const std::string &caFile) {
+    if (SSL_CTX_load_verify_locations(ctx_, caFile.c_str(), nullptr) != 1) {
+        LOG_ERROR("TlsContext::loadVerifyLocations ca:%s err:%s\n", caFile.c_str(), lastSslError());
+        return false;
+    }
+    setVerifyPeer(true);
+    return true;
+}
+
+void TlsContext::setVerifyPeer(bool on) {
+    verifyPeer_ = on;
+    int mode = SSL_VERIFY_NONE;
+    if (on) {
+        mode = SSL_VERIFY_PEER;
+        if (mode_ == kServer) {
+            mode |= SSL_VERIFY_FAIL_IF_NO_PEER_CERT; // 服务端校验即要求客户端证书
+        }
+    }
+    SSL_CTX_set_verify(ctx_, mode, nullptr);
+}
+
+void TlsContext::setKtls(bool on) {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+    ktls_ = on;
+    if (on) {
+        SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
+    } else {
+        SSL_CTX_clear_options(ctx_, SSL_OP_ENABLE_KTLS);
+    }
+#else
+    ktls_ = false; // OpenSSL编译时没有开启kTLS
+    (void)on;
+#endif
+}
+
+bool TlsContext::kernelSupportsKtls() {
+#ifdef TCP_ULP
+    // tls模块初始化时要求socket已连接, 未连接的socket返回ENOTCONN说明内核找到了tls ULP
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sockfd < 0) {
+        return false;
+    }
+    int ret = ::setsockopt(sockfd, SOL_TCP, TCP_ULP, "tls", sizeof "tls");
+    int savedErrno = errno;
+    ::close(sockfd);
+    return ret == 0 || savedErrno == ENOTCONN;
+#else
+    return false;
+#endif
+}
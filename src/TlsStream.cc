@@ -0,0 +1,165 @@
+#include <errno.h>
+#include <stdint.h>
+#include <algorithm>
+#include <openssl/opensslv.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "TlsStream.h"
+#include "TlsContext.h"
+#include "Buffer.h"
+#include "Logger.h"
+
+static const size_t kReadChunk = 16 * 1024; // 一个TLS记录的最大明文长度
+
+TlsStream::TlsStream(TlsContext *context, int sockfd, const std::string &serverName)
+    : ssl_(::SSL_new(context->nativeHandle())),
+      established_(false),
+      ktlsSend_(false),
+      ktlsRecv_(false),
+      peerClosed_(false) {
+    if (ssl_ == nullptr) {
+        LOG_FATAL("%s:%s:%d SSL_new fail\n", __FILE__, __FUNCTION__, __LINE__);
+    }
+    // 使用socket BIO直接读写fd, kTLS只能在socket BIO上开启
+    SSL_set_fd(ssl_, sockfd);
+    if (context->mode() == TlsContext::kServer) {
+        SSL_set_accept_state(ssl_);
+    } else {
+        SSL_set_connect_state(ssl_);
+        if (!serverName.empty()) {
+            SSL_set_tlsext_host_name(ssl_, serverName.c_str());
+            if (context->verifyPeer()) {
+                SSL_set1_host(ssl_, serverName.c_str());
+            }
+        }
+    }
+}
+
+TlsStream::~TlsStream() {
+    ::SSL_free(ssl_); // 不关闭fd, fd由Socket管理
+}
+
+TlsStream::HandshakeState TlsStream::handshake() {
+    ERR_clear_error();
+    int ret = ::SSL_do_handshake(ssl_);
+    if (ret == 1) {
+        established_ = true;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(OPENSSL_NO_KTLS)
+        ktlsSend_ = BIO_get_ktls_send(SSL_get_wbio(ssl_));
+        ktlsRecv_ = BIO_get_ktls_recv(SSL_get_rbio(ssl_));
+#else
+        ktlsSend_ = false; // OpenSSL 3.0之前没有kTLS
+        ktlsRecv_ = false;
+#endif
+        return kHandshakeDone;
+    }
+    int err = ::SSL_get_error(ssl_, ret);
+    if (err == SSL_ERROR_WANT_READ) {
+        return kHandshakeWantRead;
+    } else if (err == SSL_ERROR_WANT_WRITE) {
+        return kHandshakeWantWrite;
+    }
+    unsigned long sslErr = ERR_get_error();
+    char reason[256] = "connection closed";
+    if (sslErr != 0) {
+        ERR_error_string_n(sslErr, reason, sizeof reason);
+    } else if (err == SSL_ERROR_SYSCALL && errno != 0) {
+        snprintf(reason, sizeof reason, "errno %d", errno);
+    }
+    LOG_ERROR("TlsStream::handshake fail: %s\n", reason);
+    ERR_clear_error();
+    return kHandshakeFailed;
+}
+
+const char* TlsStream::version() const {
+    return ::SSL_get_version(ssl_);
+}
+
+const char* TlsStream::cipher() const {
+    return ::SSL_get_cipher_name(ssl_);
+}
+
+ssize_t TlsStream::read(Buffer *buf, int *savedErrno, size_t maxBytes) {
+    const size_t limit = maxBytes > 0 ? maxBytes : SIZE_MAX;
+    ssize_t total = 0;
+    while (static_cast<size_t>(total) < limit) {
+        buf->ensureWritableBytes(kReadChunk);
+        ERR_clear_error();
+        errno = 0;
+        size_t len = std::min(buf->writableBytes(), limit - static_cast<size_t>(total));
+        int n = ::SSL_read(ssl_, buf->beginWrite(), static_cast<int>(std::min<size_t>(len, INT32_MAX)));
+        if (n > 0) {
+            buf->hasWritten(n);
+            total += n;
+            continue;
+        }
+        int err = ::SSL_get_error(ssl_, n);
+        if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+            break; // 内核中没有完整的记录了
+        }
+        if (err == SSL_ERROR_ZERO_RETURN) {
+            // close_notify, 或对端直接关闭了TCP连接(SSL_OP_IGNORE_UNEXPECTED_EOF)
+            peerClosed_ = true;
+            return total;
+        }
+#ifndef SSL_OP_IGNORE_UNEXPECTED_EOF
+        if (err == SSL_ERROR_SYSCALL && errno == 0) {
+            // OpenSSL 1.1.1中对端直接关闭TCP连接报告为SSL_ERROR_SYSCALL且errno为0, 同样按正常关闭处理
+            peerClosed_ = true;
+            return total;
+        }
+#endif
+        if (total > 0) {
+            break; // 先交付已读出的数据, 错误在下次读取时报告
+        }
+        *savedErrno = err == SSL_ERROR_SYSCALL && errno != 0 ? errno : EPROTO;
+        LOG_ERROR("TlsStream::read ssl error:%d errno:%d\n", err, errno);
+        ERR_clear_error();
+        return -1;
+    }
+    if (total == 0) {
+        *savedErrno = EWOULDBLOCK;
+        return -1;
+    }
+    return total;
+}
+
+bool TlsStream::hasPending() const {
+    return ::SSL_pending(ssl_) > 0;
+}
+
+ssize_t TlsStream::write(const void *data, size_t len, int *savedErrno) {
+    const char *p = static_cast<const char *>(data);
+    size_t total = 0;
+    while (total < len) {
+        ERR_clear_error();
+        errno = 0;
+        int n = ::SSL_write(ssl_, p + total, static_cast<int>(std::min<size_t>(len - total, INT32_MAX)));
+        if (n > 0) {
+            total += n;
+            continue;
+        }
+        int err = ::SSL_get_error(ssl_, n);
+        if (err == SSL_ERROR_WANT_WRITE || err == SSL_ERROR_WANT_READ) {
+            if (total > 0) {
+                break;
+            }
+            *savedErrno = EWOULDBLOCK;
+            return -1;
+        }
+        // 致命错误后连接不可再用, 按对端重置处理, 丢弃剩余的输出
+        *savedErrno = err == SSL_ERROR_SYSCALL && errno != 0 ? errno : ECONNRESET;
+        ERR_clear_error();
+        return total > 0 ? static_cast<ssize_t>(total) : -1;
+    }
+    return static_cast<ssize_t>(total);
+}
+
+void TlsStream::shutdown() {
+    if (established_) {
+        ERR_clear_error();
+        ::SSL_shutdown(ssl_); // 只发送close_notify, 不等待对端的close_notify
+        ERR_clear_error();
+    }
+}
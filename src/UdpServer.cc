@@ -0,0 +1,74 @@
+#include <sys/socket.h>
+#include <errno.h>
+
+#include "UdpServer.h"
+#include "EventLoop.h"
+#include "EventLoopThreadPool.h"
+#include "Logger.h"
+
+static int createUdpSocket(const InetAddress &addr, bool reusePort) {
+    int sockfd = ::socket(addr.family(), SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+    if (sockfd < 0) {
+        LOG_FATAL("%s:%s:%d udp socket create err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+    int on = 1;
+    ::setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+    if (reusePort) {
+        ::setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof on);
+    }
+    if (::bind(sockfd, addr.getSockAddr(), addr.getSockLen()) < 0) {
+        LOG_FATAL("bind udp sockfd:%d fail, errno:%d\n", sockfd, errno);
+    }
+    return sockfd;
+}
+
+UdpServer::UdpServer(EventLoop *loop, const InetAddress &listenAddr, const std::string &nameArg)
+    : loop_(loop),
+      listenAddr_(listenAddr),
+      name_(nameArg),
+      threadPool_(new EventLoopThreadPool(loop, nameArg)),
+      started_(0) {
+}
+
+UdpServer::~UdpServer() {
+    // socket的channel注册在各自的loop中, 需要在对应的loop中析构
+    for (UdpSocket *socket : sockets_) {
+        socket->getLoop()->runInLoop([socket]() { delete socket; });
+    }
+    threadPool_.reset(); // 先执行上面的析构任务, 再停止subloop
+}
+
+void UdpServer::setThreadNum(int numThreads) {
+    threadPool_->setThreadNum(numThreads);
+}
+
+void UdpServer::start() {
+    if (started_.fetch_add(1) != 0) {
+        return;
+    }
+    threadPool_->start(threadInitCallback_);
+    std::vector<EventLoop *> loops = threadPool_->getAllLoops();
+    bool reusePort = true; // 单个socket时也开启, 允许同一端口上运行多个进程
+    for (EventLoop *ioLoop : loops) {
+        UdpSocket *socket = new UdpSocket(ioLoop, createUdpSocket(listenAddr_, reusePort), options_);
+        socket->setDatagramCallback(datagramCallback_);
+        sockets_.push_back(socket);
+        ioLoop->runInLoop([socket]() { socket->start(); });
+    }
+    LOG_INFO("UdpServer[%s] listening on %s with %zu sockets, gro=%d\n",
+             name_.c_str(), listenAddr_.toIpPort().c_str(), sockets_.size(),
+             sockets_.empty() ? 0 : static_cast<int>(sockets_[0]->groEnabled()));
+}
+
+UdpSocket::Stats UdpServer::stats() const {
+    UdpSocket::Stats total = {0, 0, 0, 0, 0};
+    for (UdpSocket *socket : sockets_) {
+        UdpSocket::Stats stats = socket->stats();
+        total.datagramsReceived += stats.datagramsReceived;
+        total.recvCalls += stats.recvCalls;
+        total.datagramsSent += stats.datagramsSent;
+        total.sendCalls += stats.sendCalls;
+        total.sendDrops += stats.sendDrops;
+    }
+    return total;
+}
@@ -0,0 +1,313 @@
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include "UdpSocket.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+static const size_t kControlLen = 64; // 每条消息的cmsg空间, 只用来放UDP_GRO/UDP_SEGMENT
+static const size_t kMaxGsoSegments = 64; // 内核限制的单次GSO最大段数
+static const size_t kMaxGsoBytes = 65000; // 单条GSO消息的最大字节数(UDP负载上限为65507)
+static const int kMaxReadRounds = 4; // 一次可读事件最多调用recvmmsg的次数
+
+UdpSocket::UdpSocket(EventLoop *loop, int sockfd, const Options &options)
+    : loop_(loop),
+      sockfd_(sockfd),
+      channel_(loop, sockfd),
+      options_(options),
+      groEnabled_(false),
+#ifdef UDP_SEGMENT
+      gsoEnabled_(options.gso),
+#else
+      gsoEnabled_(false), // 没有UDP_SEGMENT时不能合并, 否则会作为一个大数据报发出
+#endif
+      slotSize_(options.maxDatagramSize),
+      inCallback_(false),
+      flushQueued_(false),
+      sent_(0),
+      datagramsReceived_(0),
+      recvCalls_(0),
+      datagramsSent_(0),
+      sendCalls_(0),
+      sendDrops_(0) {
+#ifdef UDP_GRO
+    if (options_.gro) {
+        int on = 1;
+        groEnabled_ = ::setsockopt(sockfd_, SOL_UDP, UDP_GRO, &on, sizeof on) == 0;
+        if (groEnabled_) {
+            slotSize_ = 65536; // 合并后的大包最长64K
+        }
+    }
+#endif
+    if (options_.socketBufferBytes > 0) {
+        ::setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &options_.socketBufferBytes, sizeof(int));
+        ::setsockopt(sockfd_, SOL_SOCKET, SO_SNDBUF, &options_.socketBufferBytes, sizeof(int));
+    }
+
+    size_t batch = static_cast<size_t>(options_.batchSize > 0 ? options_.batchSize : 1);
+    recvBuffer_.resize(batch * slotSize_);
+    recvMsgs_.resize(batch);
+    recvIovecs_.resize(batch);
+    recvAddrs_.resize(batch);
+    recvControl_.resize(batch * kControlLen);
+    sendMsgs_.resize(batch);
+    sendIovecs_.resize(batch);
+    sendControl_.resize(batch * kControlLen);
+    msgDatagrams_.resize(batch);
+    for (size_t i = 0; i < batch; ++i) {
+        recvIovecs_[i].iov_base = recvBuffer_.data() + i * slotSize_;
+        recvIovecs_[i].iov_len = slotSize_;
+    }
+
+    channel_.setReadCallback([this](Timestamp receiveTime) { handleRead(receiveTime); });
+    channel_.setWriteCallback([this]() { handleWrite(); });
+}
+
+UdpSocket::~UdpSocket() {
+    channel_.disableAll();
+    channel_.remove();
+    ::close(sockfd_);
+}
+
+void UdpSocket::start() {
+    channel_.enableReading();
+}
+
+void UdpSocket::stop() {
+    channel_.disableAll();
+}
+
+UdpSocket::Stats UdpSocket::stats() const {
+    Stats stats;
+    stats.datagramsReceived = datagramsReceived_.load(std::memory_order_relaxed);
+    stats.recvCalls = recvCalls_.load(std::memory_order_relaxed);
+    stats.datagramsSent = datagramsSent_.load(std::memory_order_relaxed);
+    stats.sendCalls = sendCalls_.load(std::memory_order_relaxed);
+    stats.sendDrops = sendDrops_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void UdpSocket::handleRead(Timestamp receiveTime) {
+    const size_t batch = recvMsgs_.size();
+    for (int round = 0; round < kMaxReadRounds; ++round) {
+        // recvmmsg会改写msg_namelen/msg_controllen, 每次调用前重新设置
+        for (size_t i = 0; i < batch; ++i) {
+            msghdr &hdr = recvMsgs_[i].msg_hdr;
+            hdr.msg_name = &recvAddrs_[i];
+            hdr.msg_namelen = sizeof(sockaddr_in6);
+            hdr.msg_iov = &recvIovecs_[i];
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = recvControl_.data() + i * kControlLen;
+            hdr.msg_controllen = kControlLen;
+            hdr.msg_flags = 0;
+        }
+        int n = ::recvmmsg(sockfd_, recvMsgs_.data(), static_cast<unsigned>(batch), MSG_DONTWAIT, nullptr);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG_ERROR("UdpSocket::handleRead recvmmsg error:%d\n", errno);
+            }
+            break;
+        }
+        recvCalls_.fetch_add(1, std::memory_order_relaxed);
+
+        datagrams_.clear();
+        for (int i = 0; i < n; ++i) {
+            const char *data = static_cast<const char *>(recvIovecs_[i].iov_base);
+            size_t len = recvMsgs_[i].msg_len;
+            size_t segment = len;
+#ifdef UDP_GRO
+            // GRO合并的大包由多个等长的数据报组成(最后一个可能更短), cmsg中给出段长
+            msghdr &hdr = recvMsgs_[i].msg_hdr;
+            for (cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+                if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                    int gso = 0;
+                    ::memcpy(&gso, CMSG_DATA(cmsg), sizeof gso);
+                    if (gso > 0) {
+                        segment = static_cast<size_t>(gso);
+                    }
+                }
+            }
+#endif
+            InetAddress peer(reinterpret_cast<const sockaddr *>(&recvAddrs_[i]), recvMsgs_[i].msg_hdr.msg_namelen);
+            if (len == 0) {
+                datagrams_.push_back(UdpDatagram{std::string_view(data, 0), peer});
+                continue;
+            }
+            for (size_t offset = 0; offset < len; offset += segment) {
+                size_t size = len - offset < segment ? len - offset : segment;
+                datagrams_.push_back(UdpDatagram{std::string_view(data + offset, size), peer});
+            }
+        }
+        datagramsReceived_.fetch_add(datagrams_.size(), std::memory_order_relaxed);
+
+        if (datagramCallback_) {
+            inCallback_ = true;
+            datagramCallback_(this, datagrams_.data(), datagrams_.size(), receiveTime);
+            inCallback_ = false;
+        }
+        if (outgoing_.size() > sent_) {
+            flush(); // 回调中产生的回复一次发送
+        }
+        if (static_cast<size_t>(n) < batch) {
+            break; // 接收队列已读空
+        }
+    }
+}
+
+void UdpSocket::send(const InetAddress &peer, std::string_view data) {
+    if (sendBuffer_.size() + data.size() > options_.maxQueuedBytes) {
+        sendDrops_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (peer.getSockLen() > sizeof(sockaddr_in6)) {
+        sendDrops_.fetch_add(1, std::memory_order_relaxed); // UDP只支持IPv4/IPv6对端
+        return;
+    }
+    Outgoing o;
+    o.offset = sendBuffer_.size();
+    o.len = data.size();
+    ::memcpy(&o.peer, peer.getSockAddr(), peer.getSockLen());
+    o.peerLen = peer.getSockLen();
+    outgoing_.push_back(o);
+    sendBuffer_.append(data.data(), data.size());
+
+    if (!inCallback_ && !flushQueued_ && !channel_.isWriting()) {
+        // 回调之外的发送在本轮loop结束时合并发送
+        flushQueued_ = true;
+        loop_->queueInLoop([this]() {
+            flushQueued_ = false;
+            flush();
+        });
+    }
+}
+
+// UDP_SEGMENT不被支持或分段参数不被接受时的错误码
+static bool isGsoError(int err) {
+    return err == EIO || err == EINVAL || err == EOPNOTSUPP || err == ENOPROTOOPT || err == EMSGSIZE;
+}
+
+static bool samePeer(const sockaddr_in6 &a, socklen_t aLen, const sockaddr_in6 &b, socklen_t bLen) {
+    return aLen == bLen && ::memcmp(&a, &b, aLen) == 0;
+}
+
+void UdpSocket::flush() {
+    const size_t batch = sendMsgs_.size();
+    while (sent_ < outgoing_.size()) {
+        // 组装最多batch条消息, 连续发往同一对端的等长数据报合并为一条GSO消息
+        size_t numMsgs = 0;
+        size_t next = sent_;
+        while (numMsgs < batch && next < outgoing_.size()) {
+            const Outgoing &first = outgoing_[next];
+            size_t count = 1;
+            size_t bytes = first.len;
+            if (gsoEnabled_ && first.len > 0) {
+                while (next + count < outgoing_.size() && count < kMaxGsoSegments) {
+                    const Outgoing &o = outgoing_[next + count];
+                    if (!samePeer(o.peer, o.peerLen, first.peer, first.peerLen) || o.len == 0 || o.len > first.len
+                        || bytes + o.len > kMaxGsoBytes) {
+                        break;
+                    }
+                    bytes += o.len;
+                    ++count;
+                    if (o.len < first.len) {
+                        break; // 只有最后一段可以更短
+                    }
+                }
+            }
+
+            mmsghdr &msg = sendMsgs_[numMsgs];
+            ::memset(&msg, 0, sizeof msg);
+            // 排队的数据报在sendBuffer_中连续存放, 一条消息只需要一个iovec
+            sendIovecs_[numMsgs].iov_base = &sendBuffer_[first.offset];
+            sendIovecs_[numMsgs].iov_len = bytes;
+            msg.msg_hdr.msg_name = const_cast<sockaddr_in6 *>(&first.peer);
+            msg.msg_hdr.msg_namelen = first.peerLen;
+            msg.msg_hdr.msg_iov = &sendIovecs_[numMsgs];
+            msg.msg_hdr.msg_iovlen = 1;
+#ifdef UDP_SEGMENT
+            if (count > 1) {
+                char *control = sendControl_.data() + numMsgs * kControlLen;
+                ::memset(control, 0, kControlLen);
+                msg.msg_hdr.msg_control = control;
+                msg.msg_hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                cmsghdr *cmsg = CMSG_FIRSTHDR(&msg.msg_hdr);
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                uint16_t segment = static_cast<uint16_t>(first.len);
+                ::memcpy(CMSG_DATA(cmsg), &segment, sizeof segment);
+            }
+#endif
+            msgDatagrams_[numMsgs] = count;
+            next += count;
+            ++numMsgs;
+        }
+
+        int n = ::sendmmsg(sockfd_, sendMsgs_.data(), static_cast<unsigned>(numMsgs), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+                if (!channel_.isWriting()) {
+                    channel_.enableWriting(); // 内核缓冲区满, 等待可写事件
+                }
+                compactSendQueue();
+                return;
+            }
+            int savedErrno = errno;
+            if (msgDatagrams_[0] > 1 && isGsoError(savedErrno)) {
+                // 网卡或路径不支持UDP_SEGMENT, 关闭GSO后逐个重发这些数据报
+                LOG_ERROR("UdpSocket::flush GSO send error:%d, disable GSO on fd=%d\n", savedErrno, sockfd_);
+                gsoEnabled_ = false;
+                continue;
+            }
+            // 第一条消息本身的错误(如对端地址非法), 只丢弃这条消息; GSO消息中的数据报发往同一对端
+            LOG_ERROR("UdpSocket::flush sendmmsg error:%d\n", savedErrno);
+            sendDrops_.fetch_add(msgDatagrams_[0], std::memory_order_relaxed);
+            sent_ += msgDatagrams_[0];
+            continue;
+        }
+        sendCalls_.fetch_add(1, std::memory_order_relaxed);
+        size_t datagrams = 0;
+        for (int i = 0; i < n; ++i) {
+            datagrams += msgDatagrams_[i];
+        }
+        sent_ += datagrams;
+        datagramsSent_.fetch_add(datagrams, std::memory_order_relaxed);
+        if (static_cast<size_t>(n) < numMsgs) {
+            if (!channel_.isWriting()) {
+                channel_.enableWriting();
+            }
+            compactSendQueue();
+            return;
+        }
+    }
+
+    // 队列已发送完毕
+    sendBuffer_.clear();
+    outgoing_.clear();
+    sent_ = 0;
+    if (channel_.isWriting()) {
+        channel_.disableWriting();
+    }
+}
+
+// 移除已发送的数据报, sendBuffer_只保留未发送的字节, send中的排队上限只计算这部分
+void UdpSocket::compactSendQueue() {
+    if (sent_ == 0) {
+        return;
+    }
+    size_t sentBytes = sent_ < outgoing_.size() ? outgoing_[sent_].offset : sendBuffer_.size();
+    sendBuffer_.erase(0, sentBytes);
+    outgoing_.erase(outgoing_.begin(), outgoing_.begin() + sent_);
+    for (Outgoing &o : outgoing_) {
+        o.offset -= sentBytes;
+    }
+    sent_ = 0;
+}
+
+void UdpSocket::handleWrite() {
+    flush();
+}
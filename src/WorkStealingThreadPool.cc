@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <algorithm>
+
+#include "WorkStealingThreadPool.h"
+
+namespace {
+    const size_t kMaxInjectorBatch = 32; // worker一次从注入队列取走的最大任务数
+
+    // 当前线程所属的线程池及worker下标, 用于判断submit是否来自本池的worker
+    __thread const WorkStealingThreadPool *t_pool = nullptr;
+    __thread size_t t_workerIndex = 0;
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::string &name)
+    : name_(name),
+      running_(false),
+      pending_(0),
+      idle_(0) {
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+    stop();
+}
+
+void WorkStealingThreadPool::start(int numThreads) {
+    // 停止后workers_保留给stats()读取, 不能再次启动
+    if (running_ || !workers_.empty() || numThreads <= 0) {
+        return;
+    }
+    running_ = true;
+
+    for (int i = 0; i < numThreads; ++i) {
+        workers_.emplace_back(new Worker);
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        char buf[name_.size() + 32];
+        snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
+        workers_[i]->thread.reset(new Thread(std::bind(&WorkStealingThreadPool::workerFunc, this, i), buf));
+        workers_[i]->thread->start();
+    }
+}
+
+void WorkStealingThreadPool::stop() {
+    {
+        // 与submit的检查和入队互斥: 之后的submit都在调用线程中执行, 之前入队的任务都能被worker看到
+        std::lock_guard<std::mutex> lock(injectorMutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    // worker执行完队列中的任务才退出, 否则offload的完成回调丢失, 连接后续的offload永远排队
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        sleepCond_.notify_all();
+    }
+    for (auto &worker : workers_) {
+        worker->thread->join();
+    }
+}
+
+void WorkStealingThreadPool::submit(Task task) {
+    // 先增加计数再入队, 保证worker取到任务时pending_不会减到负数
+    // pending_与idle_都使用seq_cst, 保证要么worker看到新任务, 要么这里看到有worker休眠
+    if (t_pool == this) {
+        // worker线程中提交的任务放入自己的队列; 停止过程中worker清空所有队列后才退出
+        pending_.fetch_add(1);
+        std::lock_guard<std::mutex> lock(workers_[t_workerIndex]->mutex);
+        workers_[t_workerIndex]->tasks.push_back(std::move(task));
+    } else {
+        // 外部线程提交的任务放入注入队列, 保持提交顺序
+        std::unique_lock<std::mutex> lock(injectorMutex_);
+        if (!running_) {
+            lock.unlock();
+            task(); // 线程池未运行, 直接在调用线程中执行
+            return;
+        }
+        pending_.fetch_add(1);
+        injector_.push_back(std::move(task));
+    }
+    if (idle_.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        sleepCond_.notify_one();
+    }
+}
+
+WorkStealingThreadPool::Stats WorkStealingThreadPool::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(injectorMutex_);
+        stats.injectorDepth = injector_.size();
+    }
+    stats.queueDepth = stats.injectorDepth;
+    stats.executed = 0;
+    stats.steals = 0;
+    for (const auto &worker : workers_) {
+        size_t depth = 0;
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex);
+            depth = worker->tasks.size();
+        }
+        stats.workerDepths.push_back(depth);
+        stats.queueDepth += depth;
+        stats.executed += worker->executed.load(std::memory_order_relaxed);
+        stats.steals += worker->steals.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+bool WorkStealingThreadPool::popLocal(size_t index, Task *task) {
+    Worker &worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    *task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingThreadPool::popInjector(size_t index, Task *task) {
+    std::vector<Task> batch;
+    {
+        std::lock_guard<std::mutex> lock(injectorMutex_);
+        if (injector_.empty()) {
+            return false;
+        }
+        // 按worker数均分, 取走的任务放入自己的队列供其他worker窃取
+        size_t n = std::min(injector_.size() / workers_.size() + 1, kMaxInjectorBatch);
+        *task = std::move(injector_.front());
+        injector_.pop_front();
+        for (size_t i = 1; i < n; ++i) {
+            batch.push_back(std::move(injector_.front()));
+            injector_.pop_front();
+        }
+    }
+    if (!batch.empty()) {
+        Worker &worker = *workers_[index];
+        {
+            // 倒序放入: 自己从队尾先取较早的任务, 窃取者从队头取较晚的任务
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+                worker.tasks.push_back(std::move(*it));
+            }
+        }
+        if (idle_.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            sleepCond_.notify_all();
+        }
+    }
+    return true;
+}
+
+bool WorkStealingThreadPool::steal(size_t index, Task *task) {
+    size_t n = workers_.size();
+    for (size_t i = 1; i < n; ++i) {
+        Worker &victim = *workers_[(index + i) % n];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        *task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        workers_[index]->steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingThreadPool::workerFunc(size_t index) {
+    t_pool = this;
+    t_workerIndex = index;
+
+    for (;;) {
+        Task task;
+        // 先执行自己派生的任务, 再按顺序取外部提交的任务, 最后窃取
+        if (popLocal(index, &task) || popInjector(index, &task) || steal(index, &task)) {
+            pending_.fetch_sub(1);
+            task();
+            workers_[index]->executed.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (!running_ && pending_.load() == 0) {
+            break; // 已停止且所有任务都已取走
+        }
+
+        // 窃取时try_lock可能失败, 仍有任务时继续尝试, 否则休眠
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        idle_.fetch_add(1);
+        sleepCond_.wait(lock, [this] { return pending_.load() > 0 || !running_; });
+        idle_.fetch_sub(1);
+    }
+}